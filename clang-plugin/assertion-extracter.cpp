@@ -24,76 +24,152 @@
 
 #include <clang/AST/Attr.h>
 #include <clang/Lex/Lexer.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringExtras.h>
+
+#include <glib.h>
 
 #include "assertion-extracter.h"
 #include "debug.h"
 
-static bool
-_is_assertion_name (const std::string& name)
+enum {
+	/* Assertion macros, when the compiler hasn’t seen their definitions. */
+	ASSERTION_FUNC = 1,
+	/* Functions called on the failure branch of expanded assertion
+	 * macros. */
+	ASSERTION_FAIL_FUNC,
+};
+
+static const tartan::CalleeTable::Name assertion_func_names[] = {
+	{ "g_return_if_fail", ASSERTION_FUNC },
+	{ "g_return_val_if_fail", ASSERTION_FUNC },
+	{ "g_assert_cmpstr", ASSERTION_FUNC },
+	{ "g_assert_cmpint", ASSERTION_FUNC },
+	{ "g_assert_cmpuint", ASSERTION_FUNC },
+	{ "g_assert_cmphex", ASSERTION_FUNC },
+	{ "g_assert_cmpfloat", ASSERTION_FUNC },
+	{ "g_assert_no_error", ASSERTION_FUNC },
+	{ "g_assert_error", ASSERTION_FUNC },
+	{ "g_assert_true", ASSERTION_FUNC },
+	{ "g_assert_false", ASSERTION_FUNC },
+	{ "g_assert_null", ASSERTION_FUNC },
+	{ "g_assert_nonnull", ASSERTION_FUNC },
+	{ "g_assert_not_reached", ASSERTION_FUNC },
+	{ "g_assert", ASSERTION_FUNC },
+	{ "assert", ASSERTION_FUNC },
+	{ "assert_perror", ASSERTION_FUNC },
+
+	{ "g_return_if_fail_warning", ASSERTION_FAIL_FUNC },
+	{ "g_assertion_message_cmpstr", ASSERTION_FAIL_FUNC },
+	{ "g_assertion_message_cmpnum", ASSERTION_FAIL_FUNC },
+	{ "g_assertion_message_error", ASSERTION_FAIL_FUNC },
+	{ "g_assertion_message", ASSERTION_FAIL_FUNC },
+	{ "g_assertion_message_expr", ASSERTION_FAIL_FUNC },
+	{ "__assert_fail", ASSERTION_FAIL_FUNC },
+	{ "__assert_perror_fail", ASSERTION_FAIL_FUNC },
+};
+
+AssertionExtracter::AssertionFuncs::AssertionFuncs () :
+	tartan::CalleeTable (assertion_func_names,
+	                     G_N_ELEMENTS (assertion_func_names))
 {
-	return (name == "g_return_if_fail" ||
-	        name == "g_return_val_if_fail" ||
-	        name == "g_assert_cmpstr" ||
-	        name == "g_assert_cmpint" ||
-	        name == "g_assert_cmpuint" ||
-	        name == "g_assert_cmphex" ||
-	        name == "g_assert_cmpfloat" ||
-	        name == "g_assert_no_error" ||
-	        name == "g_assert_error" ||
-	        name == "g_assert_true" ||
-	        name == "g_assert_false" ||
-	        name == "g_assert_null" ||
-	        name == "g_assert_nonnull" ||
-	        name == "g_assert_not_reached" ||
-	        name == "g_assert" ||
-	        name == "assert" ||
-	        name == "assert_perror");
 }
 
-static bool
-_is_assertion_fail_func_name (const std::string& name)
+using AssertionExtracter::AssertionCache;
+using AssertionExtracter::Formula;
+using AssertionExtracter::FormulaArena;
+
+void
+AssertionExtracter::Formula::printPretty (raw_ostream& out,
+                                          PrinterHelper *helper,
+                                          const PrintingPolicy& policy) const
+{
+	switch (this->kind) {
+	case FORMULA_TRUE:
+		out << "1";
+		break;
+	case FORMULA_FALSE:
+		out << "0";
+		break;
+	case FORMULA_EXPR:
+		this->expr->printPretty (out, helper, policy);
+		break;
+	case FORMULA_NOT:
+		out << "!(";
+		this->lhs->printPretty (out, helper, policy);
+		out << ")";
+		break;
+	case FORMULA_AND:
+	case FORMULA_OR:
+		out << "(";
+		this->lhs->printPretty (out, helper, policy);
+		out << ((this->kind == FORMULA_AND) ? " && " : " || ");
+		this->rhs->printPretty (out, helper, policy);
+		out << ")";
+		break;
+	default:
+		assert (false);
+	}
+}
+
+/* TRUE and FALSE are shared between all arenas, rather than allocated. */
+static const Formula formula_true = {
+	Formula::FORMULA_TRUE, NULL, NULL, NULL
+};
+static const Formula formula_false = {
+	Formula::FORMULA_FALSE, NULL, NULL, NULL
+};
+
+const Formula*
+AssertionExtracter::FormulaArena::_make (Formula::Kind kind,
+                                         const Formula *lhs,
+                                         const Formula *rhs, Expr *expr)
+{
+	Formula *formula = this->_allocator.Allocate<Formula> ();
+
+	formula->kind = kind;
+	formula->lhs = lhs;
+	formula->rhs = rhs;
+	formula->expr = expr;
+
+	return formula;
+}
+
+const Formula*
+AssertionExtracter::FormulaArena::make_constant (bool value)
+{
+	return value ? &formula_true : &formula_false;
+}
+
+const Formula*
+AssertionExtracter::FormulaArena::make_expr (Expr *expr)
 {
-	return (name == "g_return_if_fail_warning" ||
-	        name == "g_assertion_message_cmpstr" ||
-	        name == "g_assertion_message_cmpnum" ||
-	        name == "g_assertion_message_error" ||
-	        name == "g_assertion_message" ||
-	        name == "g_assertion_message_expr" ||
-	        name == "__assert_fail" ||
-	        name == "__assert_perror_fail");
+	return this->_make (Formula::FORMULA_EXPR, NULL, NULL, expr);
 }
 
-/* Return the negation of the given expression. */
-static Expr*
-_negation_expr (Expr* e, const ASTContext& context)
+/* Return the negation of the given formula. */
+const Formula*
+AssertionExtracter::FormulaArena::make_not (const Formula *formula)
 {
-	return new (context)
-		UnaryOperator (e, UnaryOperatorKind::UO_LNot,
-		               context.getLogicalOperationType (),
-		               VK_RValue, OK_Ordinary, SourceLocation (),
-		               /* can_overflow = */ false);
+	return this->_make (Formula::FORMULA_NOT, formula, NULL, NULL);
 }
 
-/* Combine expressions A and B to give (A && B). */
-static Expr*
-_conjunction_expr (Expr* lhs, Expr* rhs, const ASTContext& context)
+/* Combine formulae A and B to give (A ∧ B). */
+const Formula*
+AssertionExtracter::FormulaArena::make_and (const Formula *lhs,
+                                            const Formula *rhs)
 {
-	return new (context)
-		BinaryOperator (lhs, rhs, BinaryOperatorKind::BO_LAnd,
-		                context.getLogicalOperationType (),
-		                VK_RValue, OK_Ordinary, SourceLocation (),
-		                FPOptions ());
+	return this->_make (Formula::FORMULA_AND, lhs, rhs, NULL);
 }
 
-/* Combine expressions A and B to give (A || B). */
-static Expr*
-_disjunction_expr (Expr* lhs, Expr* rhs, const ASTContext& context)
+/* Combine formulae A and B to give (A ∨ B). */
+const Formula*
+AssertionExtracter::FormulaArena::make_or (const Formula *lhs,
+                                           const Formula *rhs)
 {
-	return new (context)
-		BinaryOperator (lhs, rhs, BinaryOperatorKind::BO_LOr,
-		                context.getLogicalOperationType (),
-		                VK_RValue, OK_Ordinary, SourceLocation (),
-		                FPOptions ());
+	return this->_make (Formula::FORMULA_OR, lhs, rhs, NULL);
 }
 
 /* Does the given statement look like:
@@ -110,8 +186,8 @@ _disjunction_expr (Expr* lhs, Expr* rhs, const ASTContext& context)
  * If the statement changes program state at all, return NULL. Otherwise, return
  * the condition which holds for the assertion to be bypassed (i.e. for the
  * assertion to succeed). This function is built recursively, building a boolean
- * expression for the condition based on avoiding branches which call
- * abort()-like functions.
+ * formula (allocated from @arena) for the condition based on avoiding branches
+ * which call abort()-like functions.
  *
  * This function is based on a transformation of the AST to an augmented boolean
  * expression, using rules documented in each switch case. In this
@@ -123,11 +199,16 @@ _disjunction_expr (Expr* lhs, Expr* rhs, const ASTContext& context)
  *     B ∨ NULL ≡ NULL
  *     ¬NULL ≡ NULL
  */
-Expr*
-AssertionExtracter::is_assertion_stmt (Stmt& stmt, const ASTContext& context)
+static const Formula*
+_is_assertion_stmt (Stmt& stmt, const ASTContext& context,
+                    const AssertionExtracter::AssertionFuncs& assertion_funcs,
+                    FormulaArena& arena,
+                    llvm::SmallVectorImpl<const Stmt*>& visited)
 {
 	DEBUG ("Checking " << stmt.getStmtClassName () << " for assertions.");
 
+	visited.push_back (&stmt);
+
 	/* Slow path: walk through the AST, aborting on statements which
 	 * potentially mutate program state, and otherwise trying to find a base
 	 * function call such as:
@@ -147,10 +228,11 @@ AssertionExtracter::is_assertion_stmt (Stmt& stmt, const ASTContext& context)
 		if (func == NULL)
 			return NULL;
 
-		std::string func_name = func->getNameAsString ();
-		DEBUG ("CallExpr to function " << func_name);
+		DEBUG ("CallExpr to function " << func->getNameAsString ());
 
-		if (_is_assertion_name (func_name)) {
+		unsigned int func_kind = assertion_funcs.lookup (*func);
+
+		if (func_kind == ASSERTION_FUNC) {
 			/* Assertion path where the compiler hasn't seen the
 			 * definition of the assertion macro, so still thinks
 			 * it's a function.
@@ -160,18 +242,15 @@ AssertionExtracter::is_assertion_stmt (Stmt& stmt, const ASTContext& context)
 			 *
 			 * TODO: May need to fix up the condition for macros
 			 * like g_assert_null(). */
-			return call_expr.getArg (0);
-		} else if (_is_assertion_fail_func_name (func_name)) {
+			return arena.make_expr (call_expr.getArg (0));
+		} else if (func_kind == ASSERTION_FAIL_FUNC) {
 			/* Assertion path where the assertion macro has been
 			 * expanded and we're on the assertion failure branch.
 			 *
 			 * In this case, the assertion condition has been
 			 * grabbed from an if statement already, so negate it
 			 * (to avoid the failure condition) and return. */
-			return new (context)
-				IntegerLiteral (context, context.MakeIntValue (0, context.getLogicalOperationType ()),
-				                context.getLogicalOperationType (),
-				                SourceLocation ());
+			return arena.make_constant (false);
 		}
 
 		/* Not an assertion path. */
@@ -195,7 +274,9 @@ AssertionExtracter::is_assertion_stmt (Stmt& stmt, const ASTContext& context)
 		    expr != NULL &&
 		    expr->isIntegerConstantExpr (bool_expr, context) &&
 		    !bool_expr.getBoolValue ()) {
-			return is_assertion_stmt (*body, context);
+			return _is_assertion_stmt (*body, context,
+			                           assertion_funcs, arena,
+			                           visited);
 		}
 
 		return NULL;
@@ -212,31 +293,29 @@ AssertionExtracter::is_assertion_stmt (Stmt& stmt, const ASTContext& context)
 		IfStmt& if_stmt = cast<IfStmt> (stmt);
 		assert (if_stmt.getThen () != NULL);
 
-		Expr* neg_cond = _negation_expr (if_stmt.getCond (), context);
+		const Formula* cond = arena.make_expr (if_stmt.getCond ());
+		const Formula* neg_cond = arena.make_not (cond);
 
-		Expr* then_assertion =
-			is_assertion_stmt (*(if_stmt.getThen ()), context);
+		const Formula* then_assertion =
+			_is_assertion_stmt (*(if_stmt.getThen ()), context,
+			                    assertion_funcs, arena, visited);
 		if (then_assertion == NULL)
 			return NULL;
 
-		then_assertion =
-			_conjunction_expr (if_stmt.getCond (), then_assertion,
-			                   context);
+		then_assertion = arena.make_and (cond, then_assertion);
 
 		if (if_stmt.getElse () == NULL)
-			return _disjunction_expr (then_assertion, neg_cond,
-			                          context);
+			return arena.make_or (then_assertion, neg_cond);
 
-		Expr* else_assertion =
-			is_assertion_stmt (*(if_stmt.getElse ()), context);
+		const Formula* else_assertion =
+			_is_assertion_stmt (*(if_stmt.getElse ()), context,
+			                    assertion_funcs, arena, visited);
 		if (else_assertion == NULL)
 			return NULL;
 
-		else_assertion =
-			_conjunction_expr (neg_cond, else_assertion, context);
+		else_assertion = arena.make_and (neg_cond, else_assertion);
 
-		return _disjunction_expr (then_assertion, else_assertion,
-		                          context);
+		return arena.make_or (then_assertion, else_assertion);
 	}
 	case Stmt::StmtClass::ConditionalOperatorClass: {
 		/* Handle a ternary operator.
@@ -247,28 +326,27 @@ AssertionExtracter::is_assertion_stmt (Stmt& stmt, const ASTContext& context)
 		assert (op_expr.getTrueExpr () != NULL);
 		assert (op_expr.getFalseExpr () != NULL);
 
-		Expr* neg_cond = _negation_expr (op_expr.getCond (), context);
+		const Formula* cond = arena.make_expr (op_expr.getCond ());
+		const Formula* neg_cond = arena.make_not (cond);
 
-		Expr* then_assertion =
-			is_assertion_stmt (*(op_expr.getTrueExpr ()), context);
+		const Formula* then_assertion =
+			_is_assertion_stmt (*(op_expr.getTrueExpr ()), context,
+			                    assertion_funcs, arena, visited);
 		if (then_assertion == NULL)
 			return NULL;
 
-		then_assertion =
-			_conjunction_expr (op_expr.getCond (), then_assertion,
-			                   context);
+		then_assertion = arena.make_and (cond, then_assertion);
 
-		Expr* else_assertion =
-			is_assertion_stmt (*(op_expr.getFalseExpr ()),
-			                   context);
+		const Formula* else_assertion =
+			_is_assertion_stmt (*(op_expr.getFalseExpr ()),
+			                    context, assertion_funcs, arena,
+			                    visited);
 		if (else_assertion == NULL)
 			return NULL;
 
-		else_assertion =
-			_conjunction_expr (neg_cond, else_assertion, context);
+		else_assertion = arena.make_and (neg_cond, else_assertion);
 
-		return _disjunction_expr (then_assertion, else_assertion,
-		                          context);
+		return arena.make_or (then_assertion, else_assertion);
 	}
 	case Stmt::StmtClass::SwitchStmtClass: {
 		/* Handle a switch statement.
@@ -287,7 +365,8 @@ AssertionExtracter::is_assertion_stmt (Stmt& stmt, const ASTContext& context)
 		if (sub_stmt == NULL)
 			return NULL;
 
-		return is_assertion_stmt (*sub_stmt, context);
+		return _is_assertion_stmt (*sub_stmt, context,
+		                           assertion_funcs, arena, visited);
 	}
 	case Stmt::StmtClass::CompoundStmtClass: {
 		/* Handle a compound statement, e.g. { stmt1; stmt2; }.
@@ -304,19 +383,16 @@ AssertionExtracter::is_assertion_stmt (Stmt& stmt, const ASTContext& context)
 		 * TRUE. Otherwise, it will be (TRUE ∧ …), which will be
 		 * simplified later. */
 		CompoundStmt& compound_stmt = cast<CompoundStmt> (stmt);
-		Expr* compound_condition =
-			new (context)
-				IntegerLiteral (context,
-				                context.MakeIntValue (1, context.getLogicalOperationType ()),
-				                context.getLogicalOperationType (),
-				                SourceLocation ());
+		const Formula* compound_condition = arena.make_constant (true);
 
 		for (CompoundStmt::const_body_iterator it =
 		     compound_stmt.body_begin (),
 		     ie = compound_stmt.body_end (); it != ie; ++it) {
 			Stmt* body_stmt = *it;
-			Expr* body_assertion =
-				is_assertion_stmt (*body_stmt, context);
+			const Formula* body_assertion =
+				_is_assertion_stmt (*body_stmt, context,
+				                    assertion_funcs, arena,
+				                    visited);
 
 			if (body_assertion == NULL) {
 				/* Reached a program state mutation. */
@@ -325,8 +401,8 @@ AssertionExtracter::is_assertion_stmt (Stmt& stmt, const ASTContext& context)
 
 			/* Update the compound condition. */
 			compound_condition =
-				_conjunction_expr (compound_condition,
-				                   body_assertion, context);
+				arena.make_and (compound_condition,
+				                body_assertion);
 
 			DEBUG_EXPR ("Compound condition: ", *compound_condition);
 		}
@@ -341,11 +417,7 @@ AssertionExtracter::is_assertion_stmt (Stmt& stmt, const ASTContext& context)
 		/* Handle a return statement.
 		 * Transformations:
 		 *     return ↦ FALSE */
-		return new (context)
-			IntegerLiteral (context,
-			                context.MakeIntValue (0, context.getLogicalOperationType ()),
-			                context.getLogicalOperationType (),
-			                SourceLocation ());
+		return arena.make_constant (false);
 	}
 	case Stmt::StmtClass::NullStmtClass:
 		/* Handle a null statement.
@@ -364,11 +436,7 @@ AssertionExtracter::is_assertion_stmt (Stmt& stmt, const ASTContext& context)
 		 * Transformations:
 		 *     T S1 ↦ TRUE
 		 *     T S1 = S2 ↦ TRUE */
-		return new (context)
-			IntegerLiteral (context,
-			                context.MakeIntValue (1, context.getLogicalOperationType ()),
-			                context.getLogicalOperationType (),
-			                SourceLocation ());
+		return arena.make_constant (true);
 	}
 	case Stmt::StmtClass::IntegerLiteralClass: {
 		/* Handle an integer literal. This doesn’t modify program state,
@@ -376,7 +444,10 @@ AssertionExtracter::is_assertion_stmt (Stmt& stmt, const ASTContext& context)
 		 * Transformations:
 		 *     0 ↦ FALSE
 		 *     I ↦ TRUE */
-		return dyn_cast<Expr> (&stmt);
+		IntegerLiteral& literal = cast<IntegerLiteral> (stmt);
+
+		return arena.make_constant (
+			literal.getValue ().getBoolValue ());
 	}
 	case Stmt::StmtClass::ExprWithCleanupsClass: {
 		/* Handle an expression that introduces a cleanup to be run at the end
@@ -389,7 +460,8 @@ AssertionExtracter::is_assertion_stmt (Stmt& stmt, const ASTContext& context)
 		if (sub_expr == NULL)
 			return NULL;
 
-		return is_assertion_stmt (*sub_expr, context);
+		return _is_assertion_stmt (*sub_expr, context,
+		                           assertion_funcs, arena, visited);
 	}
 	case Stmt::StmtClass::ParenExprClass: {
 		/* Handle a parenthesised expression.
@@ -401,7 +473,8 @@ AssertionExtracter::is_assertion_stmt (Stmt& stmt, const ASTContext& context)
 		if (sub_expr == NULL)
 			return NULL;
 
-		return is_assertion_stmt (*sub_expr, context);
+		return _is_assertion_stmt (*sub_expr, context,
+		                           assertion_funcs, arena, visited);
 	}
 	case Stmt::StmtClass::LabelStmtClass: {
 		/* Handle a label statement.
@@ -413,7 +486,8 @@ AssertionExtracter::is_assertion_stmt (Stmt& stmt, const ASTContext& context)
 		if (sub_stmt == NULL)
 			return NULL;
 
-		return is_assertion_stmt (*sub_stmt, context);
+		return _is_assertion_stmt (*sub_stmt, context,
+		                           assertion_funcs, arena, visited);
 	}
 	case Stmt::StmtClass::ImplicitCastExprClass:
 	case Stmt::StmtClass::CStyleCastExprClass: {
@@ -426,7 +500,8 @@ AssertionExtracter::is_assertion_stmt (Stmt& stmt, const ASTContext& context)
 		if (sub_expr == NULL)
 			return NULL;
 
-		return is_assertion_stmt (*sub_expr, context);
+		return _is_assertion_stmt (*sub_expr, context,
+		                           assertion_funcs, arena, visited);
 	}
 	case Stmt::StmtClass::CXXTryStmtClass: {
 		/* Handle a C++ try statement. We assume any assertions in any of the
@@ -440,7 +515,8 @@ AssertionExtracter::is_assertion_stmt (Stmt& stmt, const ASTContext& context)
 		if (try_block == NULL)
 			return NULL;
 
-		return is_assertion_stmt (*try_block, context);
+		return _is_assertion_stmt (*try_block, context,
+		                           assertion_funcs, arena, visited);
 	}
 	case Stmt::StmtClass::GCCAsmStmtClass:
 	case Stmt::StmtClass::MSAsmStmtClass:
@@ -508,159 +584,576 @@ AssertionExtracter::is_assertion_stmt (Stmt& stmt, const ASTContext& context)
 	}
 }
 
-/* Simplify a logical expression. Currently this eliminates extra parens and
- * casts, and performs basic boolean simplification according to common
- * identities.
+/* Whether @loc is in the body of a macro definition, rather than in a macro
+ * argument or outside a macro expansion entirely. */
+static bool
+_is_macro_body_loc (SourceLocation loc, const SourceManager& sm)
+{
+	return loc.isMacroID () && sm.isMacroBodyExpansion (loc);
+}
+
+static bool
+_is_macro_body_range (SourceRange range, const SourceManager& sm)
+{
+	return (_is_macro_body_loc (range.getBegin (), sm) &&
+	        _is_macro_body_loc (range.getEnd (), sm));
+}
+
+/* Number of non-NULL children of @stmt. */
+static unsigned int
+_n_children (const Stmt& stmt)
+{
+	unsigned int n = 0;
+
+	for (Stmt::const_child_iterator it = stmt.child_begin (),
+	     ie = stmt.child_end (); it != ie; ++it) {
+		if (*it != NULL)
+			n++;
+	}
+
+	return n;
+}
+
+/* Child @index of @stmt (counting NULL children), or NULL if there is no such
+ * child. */
+static Stmt*
+_child_at (Stmt& stmt, unsigned int index)
+{
+	unsigned int i = 0;
+
+	for (Stmt::child_iterator it = stmt.child_begin (),
+	     ie = stmt.child_end (); it != ie; ++it, i++) {
+		if (i == index)
+			return *it;
+	}
+
+	return NULL;
+}
+
+/* Record the parts of @s which aren’t covered by its class and number of
+ * children — callees, operators and literal values — in @step. Two
+ * expansions of macros with the same shape but, for example, different
+ * callees must not share a template. */
+static void
+_record_step_details (const Stmt& s, AssertionCache::Step& step)
+{
+	step.decl = NULL;
+	step.opcode = 0;
+	step.literal.clear ();
+
+	if (const CallExpr *call = dyn_cast<CallExpr> (&s)) {
+		const FunctionDecl *callee = call->getDirectCallee ();
+		if (callee != NULL)
+			step.decl = callee->getCanonicalDecl ();
+	} else if (const DeclRefExpr *ref = dyn_cast<DeclRefExpr> (&s)) {
+		step.decl = ref->getDecl ()->getCanonicalDecl ();
+	} else if (const BinaryOperator *bin_op =
+	           dyn_cast<BinaryOperator> (&s)) {
+		step.opcode = bin_op->getOpcode ();
+	} else if (const UnaryOperator *un_op =
+	           dyn_cast<UnaryOperator> (&s)) {
+		step.opcode = un_op->getOpcode ();
+	} else if (const IntegerLiteral *int_lit =
+	           dyn_cast<IntegerLiteral> (&s)) {
+		llvm::SmallString<32> str;
+		int_lit->getValue ().toString (str, 10, false);
+		step.literal = std::string (str.begin (), str.end ());
+	} else if (const CharacterLiteral *char_lit =
+	           dyn_cast<CharacterLiteral> (&s)) {
+		step.literal = llvm::utostr (char_lit->getValue ());
+	} else if (const FloatingLiteral *float_lit =
+	           dyn_cast<FloatingLiteral> (&s)) {
+		llvm::SmallString<32> str;
+		float_lit->getValue ().toString (str);
+		step.literal = std::string (str.begin (), str.end ());
+	} else if (const StringLiteral *str_lit =
+	           dyn_cast<StringLiteral> (&s)) {
+		step.literal = str_lit->getBytes ().str ();
+	} else if (const CXXBoolLiteralExpr *bool_lit =
+	           dyn_cast<CXXBoolLiteralExpr> (&s)) {
+		step.literal = bool_lit->getValue () ? "true" : "false";
+	}
+}
+
+/* Whether @s has the structure recorded in @step. */
+static bool
+_step_matches (const AssertionCache::Step& step, const Stmt& s)
+{
+	if (s.getStmtClass () != step.stmt_class ||
+	    _n_children (s) != step.n_children)
+		return false;
+
+	AssertionCache::Step details;
+	_record_step_details (s, details);
+
+	return (details.decl == step.decl &&
+	        details.opcode == step.opcode &&
+	        details.literal == step.literal);
+}
+
+/* Add the expressions from the statement’s AST which are the leaves of the
+ * extracted @condition to @leaves. */
+static void
+_collect_condition_leaves (const Formula& condition,
+                           llvm::SmallPtrSetImpl<const Stmt*>& leaves)
+{
+	if (condition.kind == Formula::FORMULA_EXPR) {
+		leaves.insert (condition.expr);
+	} else if (condition.kind == Formula::FORMULA_NOT) {
+		_collect_condition_leaves (*condition.lhs, leaves);
+	} else if (condition.kind == Formula::FORMULA_AND ||
+	           condition.kind == Formula::FORMULA_OR) {
+		_collect_condition_leaves (*condition.lhs, leaves);
+		_collect_condition_leaves (*condition.rhs, leaves);
+	}
+}
+
+/* Add the nodes for @condition to @tpl in post-order, returning the index of
+ * the node for @condition itself. */
+static unsigned int
+_record_condition (const Formula& condition,
+                   const llvm::DenseMap<const Stmt*, unsigned int>& step_indices,
+                   AssertionCache::Template& tpl)
+{
+	AssertionCache::Node node;
+	node.lhs = 0;
+	node.rhs = 0;
+	node.step = 0;
+
+	switch (condition.kind) {
+	case Formula::FORMULA_TRUE:
+		node.kind = AssertionCache::Node::NODE_TRUE;
+		break;
+	case Formula::FORMULA_FALSE:
+		node.kind = AssertionCache::Node::NODE_FALSE;
+		break;
+	case Formula::FORMULA_EXPR:
+		node.kind = AssertionCache::Node::NODE_LEAF;
+		node.step = step_indices.find (condition.expr)->second;
+		break;
+	case Formula::FORMULA_NOT:
+		node.kind = AssertionCache::Node::NODE_NOT;
+		node.lhs = _record_condition (*condition.lhs, step_indices,
+		                              tpl);
+		break;
+	case Formula::FORMULA_AND:
+	case Formula::FORMULA_OR:
+		node.kind = (condition.kind == Formula::FORMULA_AND) ?
+			AssertionCache::Node::NODE_AND :
+			AssertionCache::Node::NODE_OR;
+		node.lhs = _record_condition (*condition.lhs, step_indices,
+		                              tpl);
+		node.rhs = _record_condition (*condition.rhs, step_indices,
+		                              tpl);
+		break;
+	default:
+		assert (false);
+	}
+
+	tpl.nodes.push_back (node);
+
+	return tpl.nodes.size () - 1;
+}
+
+/* Whether the template for a statement, given the statements which were
+ * @visited while extracting its condition, is valid for all expansions of the
+ * macro the statement was expanded from.
  *
- * FIXME: Ideally, this should should be a full boolean expression minimiser,
- * returning in disjunctive normal form. */
-static Expr*
-_simplify_boolean_expr (Expr* expr, const ASTContext& context)
+ * It isn’t if any of the analysed statements came from a macro argument, or
+ * from outside a macro, since then they could differ between expansions of the
+ * macro without changing the structure of the statement. */
+static bool
+_is_macro_template (const llvm::SmallVectorImpl<const Stmt*>& visited,
+                    const SourceManager& sm)
+{
+	for (llvm::SmallVectorImpl<const Stmt*>::const_iterator it =
+	     visited.begin (), ie = visited.end (); it != ie; ++it) {
+		const Stmt *s = *it;
+
+		if (!_is_macro_body_range (s->getSourceRange (), sm))
+			return false;
+
+		/* Whether a do-while loop is analysed depends on whether its
+		 * condition is constant. */
+		const DoStmt *do_stmt = dyn_cast<DoStmt> (s);
+		if (do_stmt != NULL &&
+		    !_is_macro_body_range (do_stmt->getCond ()->getSourceRange (),
+		                           sm))
+			return false;
+	}
+
+	return true;
+}
+
+/* Try to build a template in @tpl for the @condition extracted from @stmt,
+ * given the statements which were @visited while extracting it (parents before
+ * their children). The template records the position and structure of each of
+ * those statements, and the position of each leaf of @condition. */
+static bool
+_record_template (Stmt& stmt, const Formula *condition,
+                  const llvm::SmallVectorImpl<const Stmt*>& visited,
+                  AssertionCache::Template& tpl)
+{
+	llvm::SmallPtrSet<const Stmt*, 16> analysed (visited.begin (),
+	                                             visited.end ());
+	llvm::SmallPtrSet<const Stmt*, 16> leaves;
+
+	if (condition != NULL)
+		_collect_condition_leaves (*condition, leaves);
+
+	/* Find the position of each analysed statement and leaf, working down
+	 * from the root. */
+	llvm::DenseMap<const Stmt*, unsigned int> step_indices;
+	std::vector<Stmt*> step_stmts;
+
+	AssertionCache::Step root;
+	root.parent = AssertionCache::NO_PARENT;
+	root.child_index = 0;
+	root.check_structure = true;
+	root.stmt_class = stmt.getStmtClass ();
+	root.n_children = _n_children (stmt);
+	_record_step_details (stmt, root);
+
+	tpl.steps.push_back (root);
+	step_stmts.push_back (&stmt);
+	step_indices[&stmt] = 0;
+
+	for (unsigned int i = 0; i < step_stmts.size (); i++) {
+		Stmt *parent = step_stmts[i];
+
+		/* Only the analysed statements have interesting children. */
+		if (!analysed.count (parent))
+			continue;
+
+		unsigned int j = 0;
+
+		for (Stmt::child_iterator it = parent->child_begin (),
+		     ie = parent->child_end (); it != ie; ++it, j++) {
+			Stmt *child = *it;
+
+			if (child == NULL ||
+			    (!analysed.count (child) && !leaves.count (child)) ||
+			    step_indices.count (child))
+				continue;
+
+			AssertionCache::Step step;
+			step.parent = i;
+			step.child_index = j;
+			step.check_structure = analysed.count (child);
+			step.stmt_class = child->getStmtClass ();
+			step.n_children = _n_children (*child);
+			_record_step_details (*child, step);
+
+			step_indices[child] = tpl.steps.size ();
+			tpl.steps.push_back (step);
+			step_stmts.push_back (child);
+		}
+	}
+
+	for (llvm::SmallPtrSetImpl<const Stmt*>::const_iterator it =
+	     leaves.begin (), ie = leaves.end (); it != ie; ++it) {
+		if (!step_indices.count (*it))
+			return false;
+	}
+
+	if (condition != NULL)
+		_record_condition (*condition, step_indices, tpl);
+
+	return true;
+}
+
+/* Build the condition for @stmt from @tpl, allocating it from @arena. Returns
+ * false if @stmt doesn’t have the structure recorded in the template, in
+ * which case it must be analysed normally. Otherwise, sets @condition to the
+ * extracted condition (which may be NULL). */
+static bool
+_instantiate_template (const AssertionCache::Template& tpl,
+                       Stmt& stmt, FormulaArena& arena,
+                       const Formula **condition)
 {
-	if (ExprWithCleanups* expr_cleanup = dyn_cast<ExprWithCleanups> (expr))
-		expr = expr_cleanup->getSubExpr ();
+	llvm::SmallVector<Stmt*, 16> step_stmts;
+
+	for (std::vector<AssertionCache::Step>::const_iterator it =
+	     tpl.steps.begin (), ie = tpl.steps.end (); it != ie; ++it) {
+		const AssertionCache::Step& step = *it;
+		Stmt *s;
 
-	expr = expr->IgnoreParens ();
+		if (step.parent == AssertionCache::NO_PARENT)
+			s = &stmt;
+		else
+			s = _child_at (*step_stmts[step.parent], step.child_index);
 
-	DEBUG ("Simplifying boolean expression of type " <<
-	       expr->getStmtClassName ());
+		if (s == NULL)
+			return false;
 
-	if (expr->getStmtClass () == Expr::UnaryOperatorClass) {
-		UnaryOperator& op_expr = cast<UnaryOperator> (*expr);
-		Expr* sub_expr =
-			_simplify_boolean_expr (op_expr.getSubExpr (), context);
+		if (step.check_structure && !_step_matches (step, *s))
+			return false;
+
+		step_stmts.push_back (s);
+	}
 
-		if (op_expr.getOpcode () != UnaryOperatorKind::UO_LNot) {
-			/* op S ↦ op simplify(S) */
-			op_expr.setSubExpr (sub_expr);
-			return expr;
+	llvm::SmallVector<const Formula*, 16> formulae;
+
+	for (std::vector<AssertionCache::Node>::const_iterator it =
+	     tpl.nodes.begin (), ie = tpl.nodes.end (); it != ie; ++it) {
+		const AssertionCache::Node& node = *it;
+		const Formula *f = NULL;
+
+		switch (node.kind) {
+		case AssertionCache::Node::NODE_TRUE:
+			f = arena.make_constant (true);
+			break;
+		case AssertionCache::Node::NODE_FALSE:
+			f = arena.make_constant (false);
+			break;
+		case AssertionCache::Node::NODE_LEAF: {
+			Expr *e = dyn_cast<Expr> (step_stmts[node.step]);
+			if (e == NULL)
+				return false;
+			f = arena.make_expr (e);
+			break;
+		}
+		case AssertionCache::Node::NODE_NOT:
+			f = arena.make_not (formulae[node.lhs]);
+			break;
+		case AssertionCache::Node::NODE_AND:
+			f = arena.make_and (formulae[node.lhs],
+			                    formulae[node.rhs]);
+			break;
+		case AssertionCache::Node::NODE_OR:
+			f = arena.make_or (formulae[node.lhs],
+			                   formulae[node.rhs]);
+			break;
+		default:
+			assert (false);
 		}
 
-		if (sub_expr->getStmtClass () == Expr::UnaryOperatorClass) {
-			UnaryOperator& op_sub_expr =
-				cast<UnaryOperator> (*sub_expr);
-			Expr* sub_sub_expr =
-				_simplify_boolean_expr (
-					op_sub_expr.getSubExpr (), context);
-
-			if (op_sub_expr.getOpcode () ==
-			    UnaryOperatorKind::UO_LNot) {
-				/* ! ! S ↦ simplify(S) */
-				return sub_sub_expr;
-			}
+		formulae.push_back (f);
+	}
 
-			/* ! op S ↦ ! op simplify(S) */
-			op_sub_expr.setSubExpr (sub_sub_expr);
-			return expr;
-		} else if (sub_expr->getStmtClass () ==
-		           Expr::BinaryOperatorClass) {
-			BinaryOperator& op_sub_expr =
-				cast<BinaryOperator> (*sub_expr);
-			Expr* lhs =
-				_simplify_boolean_expr (
-					op_sub_expr.getLHS (), context);
-			Expr* rhs =
-				_simplify_boolean_expr (
-					op_sub_expr.getRHS (), context);
-
-			if (op_sub_expr.getOpcode () ==
-			    BinaryOperatorKind::BO_EQ ||
-			    op_sub_expr.getOpcode () ==
-			    BinaryOperatorKind::BO_NE) {
-				/* ! (S1 == S2) ↦
-				 *     simplify(S1) != simplify(S2)
-				 * or
-				 * ! (S1 != S2) ↦
-				 *     simplify(S1) == simplify(S2) */
-				BinaryOperatorKind opcode =
-					(op_sub_expr.getOpcode () ==
-					 BinaryOperatorKind::BO_EQ) ?
-						BinaryOperatorKind::BO_NE :
-						BinaryOperatorKind::BO_EQ;
-
-				return new (context)
-					BinaryOperator (lhs, rhs, opcode,
-					                context.getLogicalOperationType (),
-					                VK_RValue, OK_Ordinary, SourceLocation (),
-					                FPOptions ());
-			}
+	*condition = formulae.empty () ? NULL : formulae.back ();
+
+	return true;
+}
+
+/* Key for the template of a statement which starts at @loc, in the body of a
+ * macro expansion. This is the outermost macro the statement was expanded
+ * from, rather than the innermost: many different macros share the same
+ * inner macros (such as G_STMT_START), so the spelling location of the
+ * statement alone doesn’t identify the code it expands to. */
+static AssertionCache::TemplateKey
+_template_key (SourceLocation loc, const ASTContext& context,
+               Preprocessor& preprocessor)
+{
+	const SourceManager& sm = context.getSourceManager ();
+	SourceLocation outer = loc;
+
+	while (true) {
+		SourceLocation caller = sm.getImmediateMacroCallerLoc (outer);
+		if (!_is_macro_body_loc (caller, sm))
+			break;
+		outer = caller;
+	}
+
+	StringRef name = Lexer::getImmediateMacroName (outer, sm,
+	                                               context.getLangOpts ());
+	SourceLocation expansion =
+		sm.getExpansionLoc (sm.getImmediateExpansionRange (outer)
+		                      .getBegin ());
+	SourceLocation definition;
+
+	const MacroInfo *info =
+		preprocessor.getMacroDefinitionAtLoc (
+			preprocessor.getIdentifierInfo (name),
+			expansion).getMacroInfo ();
+	if (info != NULL)
+		definition = info->getDefinitionLoc ();
+
+	return AssertionCache::TemplateKey (
+		definition.getRawEncoding (), name.str (),
+		sm.getSpellingLoc (outer).getRawEncoding ());
+}
+
+/* Extract the condition from a statement, as documented for
+ * _is_assertion_stmt(), caching the result in @cache if the statement is a
+ * macro expansion. The returned condition is allocated from @arena. */
+const Formula*
+AssertionExtracter::is_assertion_stmt (Stmt& stmt, const ASTContext& context,
+                                       AssertionCache& cache,
+                                       FormulaArena& arena)
+{
+	const SourceManager& sm = context.getSourceManager ();
+	SourceLocation loc = stmt.getSourceRange ().getBegin ();
+	bool is_macro = _is_macro_body_loc (loc, sm);
+	AssertionCache::TemplateKey key;
+	const Formula *condition = NULL;
+
+	if (is_macro) {
+		key = _template_key (loc, context, cache._preprocessor);
+
+		std::map<AssertionCache::TemplateKey,
+		         AssertionCache::Template>::const_iterator tpl =
+			cache._templates.find (key);
+
+		if (tpl != cache._templates.end () &&
+		    _instantiate_template (tpl->second, stmt, arena,
+		                           &condition)) {
+			DEBUG ("Instantiated cached assertion template.");
+			return condition;
+		}
+	}
 
-			/* ! (S1 op S2) ↦ ! (simplify(S1) op simplify(S2)) */
-			op_sub_expr.setLHS (lhs);
-			op_sub_expr.setRHS (rhs);
-			return expr;
+	llvm::SmallVector<const Stmt*, 16> visited;
+	condition = _is_assertion_stmt (stmt, context, cache.get_funcs (),
+	                                arena, visited);
+
+	if (is_macro && !cache._templates.count (key) &&
+	    _is_macro_template (visited, sm)) {
+		AssertionCache::Template tpl;
+
+		if (_record_template (stmt, condition, visited, tpl))
+			cache._templates[key] = std::move (tpl);
+	}
+
+	return condition;
+}
+
+/* Simplify a boolean formula. Currently this lifts logical operators out of
+ * the expressions at its leaves and into the formula, eliminates extra parens,
+ * and performs basic boolean simplification according to common identities.
+ * Nothing in the AST is modified.
+ *
+ * FIXME: Ideally, this should should be a full boolean expression minimiser,
+ * returning in disjunctive normal form. */
+static const Formula*
+_simplify_formula (const Formula& formula, const ASTContext& context,
+                   FormulaArena& arena)
+{
+	switch (formula.kind) {
+	case Formula::FORMULA_TRUE:
+	case Formula::FORMULA_FALSE:
+		return &formula;
+	case Formula::FORMULA_EXPR: {
+		Expr* expr = formula.expr;
+
+		if (ExprWithCleanups* expr_cleanup =
+		    dyn_cast<ExprWithCleanups> (expr))
+			expr = expr_cleanup->getSubExpr ();
+
+		expr = expr->IgnoreParens ();
+
+		DEBUG ("Simplifying boolean expression of type " <<
+		       expr->getStmtClassName ());
+
+		UnaryOperator* un_expr = dyn_cast<UnaryOperator> (expr);
+		BinaryOperator* bin_expr = dyn_cast<BinaryOperator> (expr);
+
+		if (un_expr != NULL &&
+		    un_expr->getOpcode () == UnaryOperatorKind::UO_LNot) {
+			/* ! S ↦ simplify(¬S) */
+			const Formula* sub_expr =
+				arena.make_expr (un_expr->getSubExpr ());
+
+			return _simplify_formula (*arena.make_not (sub_expr),
+			                          context, arena);
 		}
-	} else if (expr->getStmtClass () == Expr::BinaryOperatorClass) {
-		BinaryOperator& op_expr = cast<BinaryOperator> (*expr);
-		Expr* lhs = _simplify_boolean_expr (op_expr.getLHS (), context);
-		Expr* rhs = _simplify_boolean_expr (op_expr.getRHS (), context);
-
-		/* Guaranteed one-hot. */
-		bool is_and =
-			op_expr.getOpcode () == BinaryOperatorKind::BO_LAnd;
-		bool is_or =
-			op_expr.getOpcode () == BinaryOperatorKind::BO_LOr;
-
-		if (!is_and && !is_or) {
-			/* S1 op S2 ↦ simplify(S1) op simplify(S2) */
-			op_expr.setLHS (lhs);
-			op_expr.setRHS (rhs);
-			return expr;
+
+		if (bin_expr != NULL &&
+		    (bin_expr->getOpcode () == BinaryOperatorKind::BO_LAnd ||
+		     bin_expr->getOpcode () == BinaryOperatorKind::BO_LOr)) {
+			/* S1 && S2 ↦ simplify(S1 ∧ S2)
+			 * or
+			 * S1 || S2 ↦ simplify(S1 ∨ S2) */
+			const Formula* lhs =
+				arena.make_expr (bin_expr->getLHS ());
+			const Formula* rhs =
+				arena.make_expr (bin_expr->getRHS ());
+			bool is_and = (bin_expr->getOpcode () ==
+			               BinaryOperatorKind::BO_LAnd);
+			const Formula* lifted = is_and ?
+				arena.make_and (lhs, rhs) :
+				arena.make_or (lhs, rhs);
+
+			return _simplify_formula (*lifted, context, arena);
 		}
 
 		llvm::APSInt bool_expr;
 
-		if (lhs->isIntegerConstantExpr (bool_expr, context)) {
-			if (is_or && bool_expr.getBoolValue ()) {
-				/* 1 || S2 ↦ 1 */
-				return new (context)
-					IntegerLiteral (context,
-					                context.MakeIntValue (1, context.getLogicalOperationType ()),
-					                context.getLogicalOperationType (),
-					                SourceLocation ());
-			} else if (is_and && !bool_expr.getBoolValue ()) {
-				/* 0 && S2 ↦ 0 */
-				return new (context)
-					IntegerLiteral (context,
-					                context.MakeIntValue (0, context.getLogicalOperationType ()),
-					                context.getLogicalOperationType (),
-					                SourceLocation ());
-			} else {
-				/* 1 && S2 ↦ simplify(S2)
-				 * or
-				 * 0 || S2 ↦ simplify(S2) */
-				return rhs;
-			}
-		} else if (rhs->isIntegerConstantExpr (bool_expr, context)) {
-			if (is_or && bool_expr.getBoolValue ()) {
-				/* S1 || 1 ↦ 1 */
-				return new (context)
-					IntegerLiteral (context,
-					                context.MakeIntValue (1, context.getLogicalOperationType ()),
-					                context.getLogicalOperationType (),
-					                SourceLocation ());
-			} else if (is_and && !bool_expr.getBoolValue ()) {
-				/* S2 && 0 ↦ 0 */
-				return new (context)
-					IntegerLiteral (context,
-					                context.MakeIntValue (0, context.getLogicalOperationType ()),
-					                context.getLogicalOperationType (),
-					                SourceLocation ());
-			} else {
-				/* S1 && 1 ↦ simplify(S1)
-				 * or
-				 * S1 || 0 ↦ simplify(S1) */
-				return lhs;
-			}
+		if (!expr->isValueDependent () &&
+		    expr->isIntegerConstantExpr (bool_expr, context)) {
+			/* 0 ↦ FALSE
+			 * or
+			 * I ↦ TRUE */
+			return arena.make_constant (bool_expr.getBoolValue ());
 		}
 
-		/* S1 op S2 ↦ simplify(S1) op simplify(S2) */
-		op_expr.setLHS (lhs);
-		op_expr.setRHS (rhs);
-		return expr;
+		/* S ↦ S */
+		if (expr == formula.expr)
+			return &formula;
+
+		return arena.make_expr (expr);
 	}
+	case Formula::FORMULA_NOT: {
+		const Formula* sub =
+			_simplify_formula (*formula.lhs, context, arena);
+
+		if (sub->kind == Formula::FORMULA_TRUE ||
+		    sub->kind == Formula::FORMULA_FALSE) {
+			/* ¬TRUE ↦ FALSE
+			 * or
+			 * ¬FALSE ↦ TRUE */
+			return arena.make_constant (
+				sub->kind == Formula::FORMULA_FALSE);
+		} else if (sub->kind == Formula::FORMULA_NOT) {
+			/* ¬¬S ↦ simplify(S) */
+			return sub->lhs;
+		}
+
+		/* ¬S ↦ ¬simplify(S) */
+		return arena.make_not (sub);
+	}
+	case Formula::FORMULA_AND:
+	case Formula::FORMULA_OR: {
+		const Formula* lhs =
+			_simplify_formula (*formula.lhs, context, arena);
+		const Formula* rhs =
+			_simplify_formula (*formula.rhs, context, arena);
+
+		bool is_and = (formula.kind == Formula::FORMULA_AND);
+
+		/* FALSE absorbs the other operand of ∧, and TRUE is its
+		 * identity; and vice versa for ∨. */
+		Formula::Kind absorbing = is_and ?
+			Formula::FORMULA_FALSE : Formula::FORMULA_TRUE;
+		Formula::Kind identity = is_and ?
+			Formula::FORMULA_TRUE : Formula::FORMULA_FALSE;
+
+		if (lhs->kind == absorbing || rhs->kind == absorbing) {
+			/* FALSE ∧ S2 ↦ FALSE
+			 * or
+			 * TRUE ∨ S2 ↦ TRUE
+			 * and similarly for constant S2. */
+			return arena.make_constant (!is_and);
+		} else if (lhs->kind == identity) {
+			/* TRUE ∧ S2 ↦ simplify(S2)
+			 * or
+			 * FALSE ∨ S2 ↦ simplify(S2) */
+			return rhs;
+		} else if (rhs->kind == identity) {
+			/* S1 ∧ TRUE ↦ simplify(S1)
+			 * or
+			 * S1 ∨ FALSE ↦ simplify(S1) */
+			return lhs;
+		}
 
-	return expr;
+		/* S1 op S2 ↦ simplify(S1) op simplify(S2) */
+		return is_and ? arena.make_and (lhs, rhs) :
+		                arena.make_or (lhs, rhs);
+	}
+	default:
+		assert (false);
+		return &formula;
+	}
 }
 
 /* Calculate whether an assertion is a standard GObject type check.
@@ -749,8 +1242,35 @@ _assertion_is_gobject_type_check (Expr& assertion_expr,
 	}
 }
 
+/* Calculate whether the comparison (LHS != RHS) is a non-NULL check, i.e.
+ * whether RHS is NULL and LHS is a variable reference.
+ *
+ * Insert the ValueDecl of the variable being checked into the provided
+ * unordered_set, and return the number of such insertions (0 or 1). */
+static unsigned int
+_comparison_is_nonnull_check (const BinaryOperator& bin_expr,
+                              const ASTContext& context,
+                              std::unordered_set<const ValueDecl*>& ret)
+{
+	Expr* rhs = bin_expr.getRHS ();
+	Expr::NullPointerConstantKind k =
+		rhs->isNullPointerConstant (const_cast<ASTContext&> (context),
+		                            Expr::NullPointerConstantValueDependence::NPC_ValueDependentIsNotNull);
+	if (k != Expr::NullPointerConstantKind::NPCK_NotNull &&
+	    bin_expr.getLHS ()->IgnoreParenCasts ()->getStmtClass () == Expr::DeclRefExprClass) {
+		DEBUG ("Found non-NULL check.");
+		ret.insert (cast<DeclRefExpr> (bin_expr.getLHS ()->IgnoreParenCasts ())->getDecl ());
+		return 1;
+	}
+
+	/* Either not a comparison to NULL, or the expr being compared is not a
+	 * DeclRefExpr. */
+	return 0;
+}
+
 /* Calculate whether an assertion is a standard non-NULL check.
- * e.g. (x != NULL), (x), (x != NULL && …) or (x && …).
+ * e.g. (x != NULL) or (x). Conjunctions such as (x != NULL && …) are handled
+ * by _formula_is_nonnull_check().
  *
  * Insert the ValueDecls of the variables being checked into the provided
  * unordered_set, and return the number of such insertions (this will be 0 if no
@@ -768,61 +1288,23 @@ _assertion_is_explicit_nonnull_check (Expr& assertion_expr,
 	case Expr::BinaryOperatorClass: {
 		BinaryOperator& bin_expr =
 			cast<BinaryOperator> (assertion_expr);
-		BinaryOperatorKind opcode = bin_expr.getOpcode ();
-
-		if (opcode == BinaryOperatorKind::BO_LAnd) {
-			/* LHS && RHS */
-			unsigned int lhs_count =
-				AssertionExtracter::assertion_is_nonnull_check (*(bin_expr.getLHS ()), context, ret);
-			unsigned int rhs_count =
-				AssertionExtracter::assertion_is_nonnull_check (*(bin_expr.getRHS ()), context, ret);
-
-			return lhs_count + rhs_count;
-		} else if (opcode == BinaryOperatorKind::BO_LOr) {
-			/* LHS || RHS */
-			std::unordered_set<const ValueDecl*> lhs_vars, rhs_vars;
-
-			unsigned int lhs_count =
-				AssertionExtracter::assertion_is_nonnull_check (*(bin_expr.getLHS ()), context, lhs_vars);
-			unsigned int rhs_count =
-				AssertionExtracter::assertion_is_nonnull_check (*(bin_expr.getRHS ()), context, rhs_vars);
-
-			std::set_intersection (lhs_vars.begin (),
-			                       lhs_vars.end (),
-			                       rhs_vars.begin (),
-			                       rhs_vars.end (),
-			                       std::inserter (ret, ret.end ()));
-
-			return lhs_count + rhs_count;
-		} else if (opcode == BinaryOperatorKind::BO_NE) {
-			/* LHS != RHS */
-			Expr* rhs = bin_expr.getRHS ();
-			Expr::NullPointerConstantKind k =
-				rhs->isNullPointerConstant (const_cast<ASTContext&> (context),
-				                            Expr::NullPointerConstantValueDependence::NPC_ValueDependentIsNotNull);
-			if (k != Expr::NullPointerConstantKind::NPCK_NotNull &&
-			    bin_expr.getLHS ()->IgnoreParenCasts ()->getStmtClass () == Expr::DeclRefExprClass) {
-				DEBUG ("Found non-NULL check.");
-				ret.insert (cast<DeclRefExpr> (bin_expr.getLHS ()->IgnoreParenCasts ())->getDecl ());
-				return 1;
-			}
 
-			/* Either not a comparison to NULL, or the expr being
-			 * compared is not a DeclRefExpr. */
-			return 0;
+		if (bin_expr.getOpcode () == BinaryOperatorKind::BO_NE) {
+			/* LHS != RHS */
+			return _comparison_is_nonnull_check (bin_expr, context,
+			                                     ret);
 		}
 
 		return 0;
 	}
 	case Expr::UnaryOperatorClass: {
-		/* A unary operator. For the moment, assume this isn't a
+		/* A unary operator. Logical negations have already been lifted
+		 * into the formula, so for the moment, assume this isn't a
 		 * non-null check.
 		 *
 		 * FIXME: In the future, define a proper program transformation
 		 * to check for non-null checks, since we could have expressions
 		 * like:
-		 *     !(my_var == NULL)
-		 * or (more weirdly):
 		 *     ~(my_var == NULL)
 		 */
 		return 0;
@@ -888,19 +1370,91 @@ _assertion_is_explicit_nonnull_check (Expr& assertion_expr,
 	}
 }
 
+/* Calculate whether a simplified assertion is a standard non-NULL check or
+ * GObject type check, as documented for the functions above. */
+static unsigned int
+_formula_is_nonnull_check (const Formula& assertion,
+                           const ASTContext& context,
+                           std::unordered_set<const ValueDecl*>& ret)
+{
+	DEBUG_EXPR (__func__ << ": ", assertion);
+
+	switch (assertion.kind) {
+	case Formula::FORMULA_AND: {
+		/* LHS ∧ RHS */
+		unsigned int lhs_count =
+			_formula_is_nonnull_check (*assertion.lhs, context,
+			                           ret);
+		unsigned int rhs_count =
+			_formula_is_nonnull_check (*assertion.rhs, context,
+			                           ret);
+
+		return lhs_count + rhs_count;
+	}
+	case Formula::FORMULA_OR: {
+		/* LHS ∨ RHS */
+		std::unordered_set<const ValueDecl*> lhs_vars, rhs_vars;
+
+		unsigned int lhs_count =
+			_formula_is_nonnull_check (*assertion.lhs, context,
+			                           lhs_vars);
+		unsigned int rhs_count =
+			_formula_is_nonnull_check (*assertion.rhs, context,
+			                           rhs_vars);
+
+		std::set_intersection (lhs_vars.begin (),
+		                       lhs_vars.end (),
+		                       rhs_vars.begin (),
+		                       rhs_vars.end (),
+		                       std::inserter (ret, ret.end ()));
+
+		return lhs_count + rhs_count;
+	}
+	case Formula::FORMULA_NOT: {
+		/* ¬(LHS == RHS), which is equivalent to (LHS != RHS). Other
+		 * negations aren’t non-NULL checks. */
+		if (assertion.lhs->kind != Formula::FORMULA_EXPR)
+			return 0;
+
+		const BinaryOperator* bin_expr =
+			dyn_cast<BinaryOperator> (assertion.lhs->expr);
+
+		if (bin_expr == NULL ||
+		    bin_expr->getOpcode () != BinaryOperatorKind::BO_EQ)
+			return 0;
+
+		return _comparison_is_nonnull_check (*bin_expr, context, ret);
+	}
+	case Formula::FORMULA_EXPR: {
+		unsigned int explicit_nonnull_count =
+			_assertion_is_explicit_nonnull_check (*assertion.expr,
+			                                      context, ret);
+		unsigned int type_check_count =
+			_assertion_is_gobject_type_check (*assertion.expr,
+			                                  context, ret);
+
+		return explicit_nonnull_count + type_check_count;
+	}
+	case Formula::FORMULA_TRUE:
+	case Formula::FORMULA_FALSE:
+		/* Constants can’t be nonnull checks. */
+		return 0;
+	default:
+		assert (false);
+		return 0;
+	}
+}
+
 unsigned int
-AssertionExtracter::assertion_is_nonnull_check (Expr& assertion_expr,
+AssertionExtracter::assertion_is_nonnull_check (const Formula& assertion,
                                                 const ASTContext& context,
+                                                FormulaArena& arena,
                                                 std::unordered_set<const ValueDecl*>& param_decls)
 {
-	/* After this call, assume expr is in boolean disjunctive normal
+	/* After this call, assume the formula is in boolean disjunctive normal
 	 * form. */
-	Expr* expr = _simplify_boolean_expr (&assertion_expr, context);
-
-	unsigned int explicit_nonnull_count =
-		_assertion_is_explicit_nonnull_check (*expr, context, param_decls);
-	unsigned int type_check_count =
-		_assertion_is_gobject_type_check (*expr, context, param_decls);
+	const Formula* simplified =
+		_simplify_formula (assertion, context, arena);
 
-	return explicit_nonnull_count + type_check_count;
+	return _formula_is_nonnull_check (*simplified, context, param_decls);
 }
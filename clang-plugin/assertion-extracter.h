@@ -23,18 +23,171 @@
 #ifndef TARTAN_ASSERTION_EXTRACTER_H
 #define TARTAN_ASSERTION_EXTRACTER_H
 
+#include <map>
+#include <string>
+#include <tuple>
 #include <unordered_set>
+#include <vector>
 
 #include <clang/AST/AST.h>
 #include <clang/AST/ASTContext.h>
+#include <clang/Lex/Preprocessor.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/Support/Allocator.h>
+
+#include "callee-table.h"
 
 using namespace clang;
 
 namespace AssertionExtracter {
-	Expr* is_assertion_stmt (Stmt& stmt, const ASTContext& context);
+	/* The functions is_assertion_stmt() looks for. */
+	class AssertionFuncs : public tartan::CalleeTable {
+	public:
+		AssertionFuncs ();
+	};
+
+	/* A boolean formula over expressions from the AST, as extracted from an
+	 * assertion statement. Formulae are allocated from a FormulaArena, and
+	 * only reference the expressions at their leaves, so building one
+	 * doesn’t add anything to the AST. */
+	struct Formula {
+		enum Kind {
+			FORMULA_TRUE,
+			FORMULA_FALSE,
+			/* An expression from the AST: @expr. */
+			FORMULA_EXPR,
+			FORMULA_NOT,  /* ¬@lhs */
+			FORMULA_AND,  /* @lhs ∧ @rhs */
+			FORMULA_OR,  /* @lhs ∨ @rhs */
+		} kind;
+		const Formula *lhs;
+		const Formula *rhs;
+		Expr *expr;
+
+		/* Same signature as Stmt::printPretty(), for DEBUG_EXPR(). */
+		void printPretty (raw_ostream& out, PrinterHelper *helper,
+		                  const PrintingPolicy& policy) const;
+	};
+
+	/* Allocator for Formulae. Everything allocated from it is freed when
+	 * it is destroyed, so it should live no longer than the examination of
+	 * a single function. */
+	class FormulaArena {
+	public:
+		const Formula* make_constant (bool value);
+		const Formula* make_expr (Expr *expr);
+		const Formula* make_not (const Formula *formula);
+		const Formula* make_and (const Formula *lhs,
+		                         const Formula *rhs);
+		const Formula* make_or (const Formula *lhs, const Formula *rhs);
+
+	private:
+		const Formula* _make (Formula::Kind kind, const Formula *lhs,
+		                      const Formula *rhs, Expr *expr);
+
+		llvm::BumpPtrAllocator _allocator;
+	};
+
+	/* Per-translation-unit state for is_assertion_stmt(): the functions it
+	 * looks for, and the conditions it has already extracted from macros.
+	 * One of these should be used for everything which extracts assertions
+	 * from a translation unit.
+	 *
+	 * Statements which are entire expansions of a macro (such as
+	 * g_return_if_fail()) have their condition cached by the definition
+	 * of the outermost macro they were expanded from, as a template of the
+	 * condition in terms of the expansion’s sub-expressions. Other
+	 * expansions of the same macro then only need to have their structure
+	 * checked against the template, rather than being analysed, and the
+	 * condition is instantiated into the FormulaArena given for each
+	 * lookup. */
+	class AssertionCache {
+	public:
+		AssertionCache (Preprocessor& preprocessor) :
+			_preprocessor (preprocessor)
+		{
+		}
+
+		/* A statement or expression in a Template, as the index of its
+		 * parent in Template::steps (or NO_PARENT for the root), and
+		 * its index in the parent’s children (). */
+		struct Step {
+			unsigned int parent;
+			unsigned int child_index;
+			/* Checked for the statements which were analysed, but not
+			 * for the leaves of the condition. */
+			bool check_structure;
+			Stmt::StmtClass stmt_class;
+			unsigned int n_children;
+			/* The canonical callee of a call, or the canonical
+			 * declaration referenced by a DeclRefExpr; NULL
+			 * otherwise. */
+			const Decl *decl;
+			/* The opcode of a unary or binary operator; 0
+			 * otherwise. */
+			unsigned int opcode;
+			/* The value of a literal; empty otherwise. */
+			std::string literal;
+		};
+
+		/* A node in a Template’s condition. The nodes are in
+		 * post-order, so the root is last. */
+		struct Node {
+			enum Kind {
+				NODE_TRUE,
+				NODE_FALSE,
+				/* An expression from the statement: @step. */
+				NODE_LEAF,
+				NODE_NOT,  /* ¬@lhs */
+				NODE_AND,  /* @lhs ∧ @rhs */
+				NODE_OR,  /* @lhs ∨ @rhs */
+			} kind;
+			unsigned int lhs;
+			unsigned int rhs;
+			unsigned int step;
+		};
+
+		/* The condition extracted from a macro expansion. An empty
+		 * list of @nodes means the expansion potentially changes
+		 * program state (so is_assertion_stmt() returned NULL). */
+		struct Template {
+			std::vector<Step> steps;
+			std::vector<Node> nodes;
+		};
+
+		/* The raw encoding of the definition location of the macro,
+		 * the macro’s name, and the raw encoding of the spelling
+		 * location of the statement’s expansion within the macro’s
+		 * definition. */
+		typedef std::tuple<unsigned int, std::string, unsigned int>
+			TemplateKey;
+
+		static const unsigned int NO_PARENT = ~0U;
+
+		const AssertionFuncs& get_funcs () const
+		{
+			return this->_funcs;
+		}
+
+	private:
+		AssertionFuncs _funcs;
+		Preprocessor& _preprocessor;
+
+		std::map<TemplateKey, Template> _templates;
+
+		friend const Formula* is_assertion_stmt (
+			Stmt& stmt, const ASTContext& context,
+			AssertionCache& cache, FormulaArena& arena);
+	};
+
+	const Formula* is_assertion_stmt (Stmt& stmt,
+	                                  const ASTContext& context,
+	                                  AssertionCache& cache,
+	                                  FormulaArena& arena);
 
 	unsigned int assertion_is_nonnull_check (
-		Expr& assertion_expr, const ASTContext& context,
+		const Formula& assertion, const ASTContext& context,
+		FormulaArena& arena,
 		std::unordered_set<const ValueDecl*>& param_decls);
 }
 
@@ -0,0 +1,222 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2026 Philip Withnall
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip@tecnocode.co.uk>
+ */
+
+/**
+ * ASTDispatchConsumer:
+ *
+ * Each of the nullability, GVariant and GSignal checkers is only interested in
+ * function declarations or call expressions. Rather than each of them walking
+ * the whole translation unit (including all the headers it includes) with its
+ * own RecursiveASTVisitor, they are added to this consumer, which walks it once
+ * and records those nodes.
+ *
+ * The recorded nodes are then dispatched to each enabled checker in turn, in
+ * the order the checkers were added. Each checker therefore sees the nodes in
+ * the same order as it would have done with its own traversal, and the
+ * diagnostics are emitted in the same order as if each checker were a separate
+ * consumer: all of one checker’s, then all of the next one’s.
+ *
+ * With --check-scope, the traversal is pruned at declarations in system headers
+ * or outside the main file, so the bodies of (for example) inline functions in
+ * GLib’s headers are never walked.
+ */
+
+#include <utility>
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+
+#include "ast-dispatcher.h"
+#include "stats.h"
+
+namespace tartan {
+
+/* Add @path to the directories whose files are traversed with
+ * %SCOPE_MAIN_FILE. It is made absolute and has symlinks resolved, to match the
+ * real paths of files in the source manager. */
+void
+TraversalScope::add_directory (const std::string& path)
+{
+	llvm::SmallString<256> real_path;
+
+	if (llvm::sys::fs::real_path (path, real_path)) {
+		/* Doesn’t exist yet; use it as given. */
+		real_path = path;
+		llvm::sys::fs::make_absolute (real_path);
+	}
+
+	std::string directory (real_path.begin (), real_path.end ());
+	if (!directory.empty () &&
+	    !llvm::sys::path::is_separator (directory.back ()))
+		directory += llvm::sys::path::get_separator ().str ();
+
+	this->directories.push_back (directory);
+}
+
+/* Whether @decl is in scope. Files beneath the --check-directory directories
+ * are in scope if their canonical path is beneath one of them; as that needs a
+ * system call, the result for each file is cached in @file_cache. */
+bool
+TraversalScope::contains (const Decl& decl,
+                          const SourceManager& source_manager,
+                          FileCache& file_cache) const
+{
+	if (this->mode == SCOPE_ALL)
+		return true;
+
+	SourceLocation loc = source_manager.getExpansionLoc (decl.getLocation ());
+
+	/* Such as the translation unit itself. */
+	if (loc.isInvalid ())
+		return true;
+
+	if (this->mode == SCOPE_NON_SYSTEM)
+		return !source_manager.isInSystemHeader (loc);
+
+	if (source_manager.isInMainFile (loc))
+		return true;
+
+	if (this->directories.empty ())
+		return false;
+
+	FileID file_id = source_manager.getFileID (loc);
+	FileCache::const_iterator cached = file_cache.find (file_id);
+
+	if (cached != file_cache.end ())
+		return cached->second;
+
+	const FileEntry *file = source_manager.getFileEntryForID (file_id);
+	bool retval = this->_contains_file (file);
+	file_cache.insert (std::make_pair (file_id, retval));
+
+	return retval;
+}
+
+/* Whether @file is beneath one of the directories. Its path is canonicalised
+ * in the same way as the directories’ were by add_directory(), falling back to
+ * the path it was opened by. */
+bool
+TraversalScope::_contains_file (const FileEntry *file) const
+{
+	if (file == NULL)
+		return false;
+
+	llvm::SmallString<256> file_name;
+
+	if (llvm::sys::fs::real_path (file->getName (), file_name))
+		file_name = file->getName ();
+
+	for (std::vector<std::string>::const_iterator it =
+	     this->directories.begin (); it != this->directories.end (); ++it) {
+		if (file_name.str ().substr (0, it->size ()) == *it)
+			return true;
+	}
+
+	return false;
+}
+
+void
+ASTDispatchConsumer::add_checker (std::unique_ptr<ASTChecker> checker)
+{
+	this->_checkers.push_back (std::move (checker));
+}
+
+void
+ASTDispatchConsumer::HandleTranslationUnit (ASTContext& context)
+{
+	/* Checkers may be disabled by arguments parsed after they were
+	 * created, so only check now. */
+	std::vector<ASTChecker*> enabled_checkers;
+
+	for (std::vector<std::unique_ptr<ASTChecker>>::const_iterator it =
+	     this->_checkers.begin (); it != this->_checkers.end (); ++it) {
+		if ((*it)->is_enabled ())
+			enabled_checkers.push_back (it->get ());
+	}
+
+	/* Run away if all the checkers are disabled. */
+	if (enabled_checkers.empty ()) {
+		return;
+	}
+
+	std::vector<ASTDispatchNode> nodes;
+
+	{
+		StatsTimer timer ("ast-dispatcher");
+		ASTDispatchVisitor visitor (nodes, *this->_scope.get (),
+		                            context.getSourceManager ());
+		visitor.TraverseDecl (context.getTranslationUnitDecl ());
+	}
+
+	for (std::vector<ASTChecker*>::const_iterator it =
+	     enabled_checkers.begin (); it != enabled_checkers.end (); ++it) {
+		ASTChecker *checker = *it;
+		StatsTimer timer (checker->get_name ());
+
+		for (std::vector<ASTDispatchNode>::const_iterator node =
+		     nodes.begin (); node != nodes.end (); ++node) {
+			if (node->func != NULL)
+				checker->handle_function_decl (*node->func);
+			else
+				checker->handle_call_expr (*node->call);
+		}
+	}
+}
+
+/* Prune declarations outside the scope, without visiting any of their
+ * children. Declarations which only group others, such as extern "C" blocks
+ * and namespaces, are always descended into, as they can span several files;
+ * their children are filtered instead. */
+bool
+ASTDispatchVisitor::TraverseDecl (Decl* decl)
+{
+	if (decl != NULL &&
+	    !isa<LinkageSpecDecl> (decl) && !isa<NamespaceDecl> (decl) &&
+	    !this->_scope.contains (*decl, this->_source_manager,
+	                            this->_file_cache))
+		return true;
+
+	return RecursiveASTVisitor<ASTDispatchVisitor>::TraverseDecl (decl);
+}
+
+/* Note: Specifically overriding the Traverse* method here so that the checkers
+ * see the function before its body. */
+bool
+ASTDispatchVisitor::TraverseFunctionDecl (FunctionDecl* func)
+{
+	ASTDispatchNode node = { func, NULL };
+	this->_nodes.push_back (node);
+
+	return RecursiveASTVisitor<ASTDispatchVisitor>::TraverseFunctionDecl (func);
+}
+
+bool
+ASTDispatchVisitor::VisitCallExpr (CallExpr* call)
+{
+	ASTDispatchNode node = { NULL, call };
+	this->_nodes.push_back (node);
+
+	return true;
+}
+
+} /* namespace tartan */
@@ -0,0 +1,125 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2026 Philip Withnall
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip@tecnocode.co.uk>
+ */
+
+#ifndef TARTAN_AST_DISPATCHER_H
+#define TARTAN_AST_DISPATCHER_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <clang/AST/AST.h>
+#include <clang/AST/ASTConsumer.h>
+#include <clang/AST/RecursiveASTVisitor.h>
+#include <llvm/ADT/DenseMap.h>
+
+#include "checker.h"
+
+namespace tartan {
+
+using namespace clang;
+
+/* Which declarations an ASTDispatchVisitor descends into, as set by the
+ * --check-scope and --check-directory arguments. */
+class TraversalScope {
+public:
+	enum Mode {
+		/* All declarations. */
+		SCOPE_ALL,
+		/* Declarations outside system headers. */
+		SCOPE_NON_SYSTEM,
+		/* Declarations in the main file, or in a file beneath one of
+		 * @directories. */
+		SCOPE_MAIN_FILE,
+	};
+
+	/* Whether each file is in scope, as computed by contains(). */
+	typedef llvm::DenseMap<FileID, bool> FileCache;
+
+	TraversalScope () : mode (SCOPE_ALL) {}
+
+	Mode mode;
+	/* Canonical absolute paths, each ending in a directory separator. */
+	std::vector<std::string> directories;
+
+	void add_directory (const std::string& path);
+	bool contains (const Decl& decl,
+	               const SourceManager& source_manager,
+	               FileCache& file_cache) const;
+
+private:
+	bool _contains_file (const FileEntry *file) const;
+};
+
+/* A node to dispatch to the checkers: exactly one of @func and @call is
+ * non-NULL. */
+struct ASTDispatchNode {
+	FunctionDecl *func;
+	CallExpr *call;
+};
+
+/* Walks the AST once, appending each function declaration and call expression
+ * to @nodes in the order they are visited. Declarations outside @scope are
+ * pruned, so nothing beneath them is visited. */
+class ASTDispatchVisitor : public RecursiveASTVisitor<ASTDispatchVisitor> {
+public:
+	explicit ASTDispatchVisitor (std::vector<ASTDispatchNode>& nodes,
+	                             const TraversalScope& scope,
+	                             const SourceManager& source_manager) :
+		_nodes (nodes), _scope (scope),
+		_source_manager (source_manager) {}
+
+private:
+	std::vector<ASTDispatchNode>& _nodes;
+	const TraversalScope& _scope;
+	const SourceManager& _source_manager;
+	TraversalScope::FileCache _file_cache;
+
+public:
+	bool TraverseDecl (Decl* decl);
+	bool TraverseFunctionDecl (FunctionDecl* func);
+	bool VisitCallExpr (CallExpr* call);
+};
+
+/* Owns the checkers which implement the ASTChecker::handle_*() hooks, and
+ * runs a single ASTDispatchVisitor traversal for all the enabled ones at the
+ * end of the translation unit, rather than each checker walking the whole
+ * translation unit itself. The visited nodes are then passed to each checker
+ * in turn. */
+class ASTDispatchConsumer : public ASTConsumer {
+public:
+	explicit ASTDispatchConsumer (
+		std::shared_ptr<const TraversalScope> scope) :
+		_scope (scope) {}
+
+private:
+	std::shared_ptr<const TraversalScope> _scope;
+	std::vector<std::unique_ptr<ASTChecker>> _checkers;
+
+public:
+	void add_checker (std::unique_ptr<ASTChecker> checker);
+	virtual void HandleTranslationUnit (ASTContext& context);
+};
+
+} /* namespace tartan */
+
+#endif /* !TARTAN_AST_DISPATCHER_H */
@@ -0,0 +1,73 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2026 Philip Withnall
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip@tecnocode.co.uk>
+ */
+
+#include "callee-table.h"
+
+namespace tartan {
+
+void
+CalleeTable::_resolve (const ASTContext& context) const
+{
+	if (this->_idents == &context.Idents)
+		return;
+
+	this->_values.clear ();
+
+	for (std::vector<Name>::const_iterator it = this->_names.begin ();
+	     it != this->_names.end (); ++it) {
+		this->_values[&context.Idents.get (it->name)] = it->value;
+	}
+
+	this->_idents = &context.Idents;
+}
+
+/* Add @name to the table. @value must be non-zero, and @name must remain
+ * valid for the lifetime of the table. */
+void
+CalleeTable::add (const char *name, unsigned int value)
+{
+	Name entry = { name, value };
+
+	this->_names.push_back (entry);
+	this->_idents = NULL;
+}
+
+/* Returns the value @func’s name was added to the table with, or 0 if it isn’t
+ * in the table. */
+unsigned int
+CalleeTable::lookup (const FunctionDecl& func) const
+{
+	/* Operators, constructors, etc. don’t have identifiers, so can’t be
+	 * in the table. */
+	const IdentifierInfo *ident = func.getIdentifier ();
+	if (ident == NULL)
+		return 0;
+
+	this->_resolve (func.getASTContext ());
+
+	std::unordered_map<const IdentifierInfo*, unsigned int>::const_iterator it =
+		this->_values.find (ident);
+
+	return (it != this->_values.end ()) ? it->second : 0;
+}
+
+} /* namespace tartan */
@@ -0,0 +1,73 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2026 Philip Withnall
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip@tecnocode.co.uk>
+ */
+
+#ifndef TARTAN_CALLEE_TABLE_H
+#define TARTAN_CALLEE_TABLE_H
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+#include <clang/AST/AST.h>
+
+namespace tartan {
+
+using namespace clang;
+
+/* Classifies functions by name, for checkers which are only interested in calls
+ * to (or declarations of) a fixed set of GLib functions.
+ *
+ * The names are resolved to IdentifierInfos from the translation unit’s
+ * identifier table the first time the table is used, so each lookup is a
+ * pointer comparison rather than a string comparison, and needs no
+ * allocation. A table should be kept for the lifetime of a translation unit,
+ * such as in a consumer or visitor; it is re-resolved if used with a different
+ * one. */
+class CalleeTable {
+public:
+	struct Name {
+		const char *name;
+		/* Non-zero value returned by lookup() for the name. */
+		unsigned int value;
+	};
+
+	CalleeTable () : _idents (NULL) {}
+	CalleeTable (const Name *names, size_t n_names) :
+		_names (names, names + n_names), _idents (NULL) {}
+
+private:
+	std::vector<Name> _names;
+
+	/* Identifier table @_values was resolved against. */
+	mutable const IdentifierTable *_idents;
+	mutable std::unordered_map<const IdentifierInfo*, unsigned int> _values;
+
+	void _resolve (const ASTContext& context) const;
+
+public:
+	void add (const char *name, unsigned int value);
+	unsigned int lookup (const FunctionDecl& func) const;
+};
+
+} /* namespace tartan */
+
+#endif /* !TARTAN_CALLEE_TABLE_H */
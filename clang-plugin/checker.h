@@ -63,6 +63,11 @@ protected:
 
 public:
 	bool is_enabled () const;
+
+	/* Called by ASTDispatchConsumer for each node of the translation unit,
+	 * for checkers which are added to it. */
+	virtual void handle_function_decl (FunctionDecl& /* func */) {}
+	virtual void handle_call_expr (CallExpr& /* call */) {}
 };
 
 } /* namespace tartan */
@@ -27,13 +27,16 @@
 #include <clang/AST/Attr.h>
 #include <clang/Lex/Lexer.h>
 
-#include "assertion-extracter.h"
 #include "debug.h"
 #include "gassert-attributes.h"
 
 namespace tartan {
 
-GAssertAttributesConsumer::GAssertAttributesConsumer ()
+GAssertAttributesConsumer::GAssertAttributesConsumer (
+	std::shared_ptr<PreconditionStore> precondition_store,
+	std::shared_ptr<NonNullAccumulator> nonnull_accumulator) :
+	_precondition_store (precondition_store),
+	_nonnull_accumulator (nonnull_accumulator)
 {
 	/* Nothing to see here. */
 }
@@ -43,41 +46,20 @@ GAssertAttributesConsumer::~GAssertAttributesConsumer ()
 	/* Nothing to see here. */
 }
 
-/* Given an expression which is asserted to be true by an assertion statement,
- * work out what type of assertion it is (e.g. GObject type check, non-NULL
- * check, etc.) and modify the FunctionDecl as appropriate. For example, for
- * non-NULL checks this involves adding a nonnull attribute on the function.
- *
- * assertion_expr may be modified in-place to simplify its boolean form. */
+/* Given the preconditions asserted at the start of a function’s body, work out
+ * what the FunctionDecl should be annotated with. For example, parameters
+ * which are checked to be non-NULL are added to @nonnull_accumulator, to be
+ * covered by a nonnull attribute on the function. */
 static void
-_handle_assertion (FunctionDecl& func, Expr& assertion_expr,
-                   const ASTContext& context)
+_handle_preconditions (FunctionDecl& func,
+                       const FunctionPreconditions& preconditions,
+                       NonNullAccumulator& nonnull_accumulator)
 {
-	DEBUG_EXPR ("Handling assertion: ", assertion_expr);
-
-	/* If the assertion is a non-NULL check, add nonnull attributes to the
-	 * function’s parameters accordingly. */
-	std::unordered_set<const ValueDecl*> ret;
-	AssertionExtracter::assertion_is_nonnull_check (assertion_expr,
-	                                                context, ret);
-
-	if (ret.size () == 0)
-		return;
-
-	/* TODO: Factor out the code to augment a nonnull attribute. */
-	std::vector<ParamIdx> non_null_args;
-
-	NonNullAttr* nonnull_attr = func.getAttr<NonNullAttr> ();
-	if (nonnull_attr != NULL) {
-		/* Extend and replace the existing attribute. */
-		DEBUG ("Extending existing attribute.");
-		non_null_args.insert (non_null_args.begin (),
-		                      nonnull_attr->args_begin (),
-		                      nonnull_attr->args_end ());
-	}
+	const std::unordered_set<const ValueDecl*>& ret =
+		preconditions.nonnull_decls;
 
-	for (std::unordered_set<const ValueDecl*>::iterator si = ret.begin (),
-	     se = ret.end (); si != se; ++si) {
+	for (std::unordered_set<const ValueDecl*>::const_iterator si =
+	     ret.begin (), se = ret.end (); si != se; ++si) {
 		const ValueDecl* val_decl = *si;
 
 		const ParmVarDecl* parm_decl = dyn_cast<ParmVarDecl> (val_decl);
@@ -92,64 +74,21 @@ _handle_assertion (FunctionDecl& func, Expr& assertion_expr,
 		unsigned int j = parm_decl->getFunctionScopeIndex ();
 		DEBUG ("Got nonnull arg " << j << " (" <<
 		       val_decl->getNameAsString () << ") from assertion.");
-		/* ParamIdx is 1-based. */
-		non_null_args.push_back (ParamIdx (j + 1, &func));
-	}
-
-	if (non_null_args.size () > 0) {
-		nonnull_attr = ::new (func.getASTContext ())
-			NonNullAttr (func.getSourceRange (),
-			             func.getASTContext (),
-			             non_null_args.data (),
-			             non_null_args.size (), 0);
-		func.addAttr (nonnull_attr);
+		nonnull_accumulator.add (func, j);
 	}
 }
 
 void
 GAssertAttributesConsumer::_handle_function_decl (FunctionDecl& func)
 {
-	/* Can only handle functions which have a body defined. */
-	Stmt* func_body = func.getBody ();
-	if (func_body == NULL) {
-		return;
-	}
-
-	/* The body should be a compound statement, e.g.
-	 * { stmt; stmt; } */
-	CompoundStmt* stmt = dyn_cast<CompoundStmt> (func_body);
-	if (stmt == NULL) {
-		DEBUG ("Ignoring function " << func.getNameAsString () <<
-		       " due to having a non-compound statement body.");
-		return;
-	}
-
 	DEBUG ("Examining " << func.getNameAsString());
 
-	ASTContext& context = func.getASTContext ();
-
-	/* Iterate through the function body until the first non-assertion and
-	 * non-declaration statement is reached. Specifically stop before the
-	 * first assignment, as that could affect the outcome of any subsequent
-	 * assertions. */
-	for (CompoundStmt::const_body_iterator it = stmt->body_begin (),
-	     ie = stmt->body_end (); it != ie; ++it) {
-		Stmt* body_stmt = *it;
-
-		Expr* assertion_expr =
-			AssertionExtracter::is_assertion_stmt (*body_stmt,
-			                                       context);
+	/* Functions without a body (yet) have no preconditions. */
+	const FunctionPreconditions& preconditions =
+		this->_precondition_store->get_preconditions (func);
 
-		if (assertion_expr == NULL) {
-			/* Potential program state mutation reached, so run
-			 * away. */
-			break;
-		}
-
-		/* Modify the FunctionDecl to take advantage of the extracted
-		 * assertion expression. */
-		_handle_assertion (func, *assertion_expr, context);
-	}
+	_handle_preconditions (func, preconditions,
+	                       *this->_nonnull_accumulator);
 
 	DEBUG ("");
 }
@@ -23,20 +23,29 @@
 #ifndef TARTAN_GASSERT_ATTRIBUTES_H
 #define TARTAN_GASSERT_ATTRIBUTES_H
 
+#include <memory>
+
 #include <clang/AST/AST.h>
 #include <clang/AST/ASTConsumer.h>
 #include <clang/Frontend/CompilerInstance.h>
 
+#include "nonnull-accumulator.h"
+#include "precondition-store.h"
+
 namespace tartan {
 
 using namespace clang;
 
 class GAssertAttributesConsumer : public clang::ASTConsumer {
 public:
-	GAssertAttributesConsumer ();
+	GAssertAttributesConsumer (std::shared_ptr<PreconditionStore> precondition_store,
+	                           std::shared_ptr<NonNullAccumulator> nonnull_accumulator);
 	~GAssertAttributesConsumer ();
 
 private:
+	std::shared_ptr<PreconditionStore> _precondition_store;
+	std::shared_ptr<NonNullAccumulator> _nonnull_accumulator;
+
 	void _handle_function_decl (FunctionDecl& func);
 public:
 	virtual bool HandleTopLevelDecl (DeclGroupRef decl_group);
@@ -34,39 +34,6 @@
 
 namespace tartan {
 
-/* Determine whether a type should be const, given its (transfer) annotation and
- * base type. */
-static bool
-_type_should_be_const (GITransfer transfer, GITypeTag type_tag)
-{
-	return (transfer == GI_TRANSFER_NOTHING &&
-	        (type_tag == GI_TYPE_TAG_UTF8 ||
-	         type_tag == GI_TYPE_TAG_FILENAME ||
-	         type_tag == GI_TYPE_TAG_ARRAY ||
-	         type_tag == GI_TYPE_TAG_GLIST ||
-	         type_tag == GI_TYPE_TAG_GSLIST ||
-	         type_tag == GI_TYPE_TAG_GHASH ||
-	         type_tag == GI_TYPE_TAG_ERROR));
-}
-
-/* Determine whether an argument is definitely required to be non-NULL given
- * its (nullable) and (optional) annotations, direction annotation and type.
- *
- * If it’s an array type, it may be NULL if its associated length parameter is
- * 0. Since we can’t currently analyse array bounds, assume that all C array
- * parameters may be NULL. (Other array types are structs, so may not be
- * NULL.) */
-static bool
-_arg_is_nonnull (GIArgInfo arg, GITypeInfo type_info)
-{
-	return ((g_type_info_is_pointer (&type_info) ||
-	         g_arg_info_get_direction (&arg) == GI_DIRECTION_OUT) &&
-	        !g_arg_info_may_be_null (&arg) &&
-	        !g_arg_info_is_optional (&arg) &&
-	        !(g_type_info_get_tag (&type_info) == GI_TYPE_TAG_ARRAY &&
-	          g_type_info_get_array_type (&type_info) == GI_ARRAY_TYPE_C));
-}
-
 /* Determine whether a return type is constant. Typically, this will be used
  * for constant pointer types, in which case pointer_type will be non-NULL. */
 static bool
@@ -86,48 +53,77 @@ _function_return_type_is_const (FunctionDecl& func)
 	        canonical_type.isConstQualified ());
 }
 
-/* Make the return type of a FunctionType const. This will go one level of
- * typing below the return type, so it won’t constify the top-level pointer
- * return. e.g.:
- *     char* → const char *          (pointer to const char)
- * and not:
- *     char* → char * const          (const pointer to char)
- *     char* → const char * const    (const pointer to const char) */
-static void
-_constify_function_return_type (FunctionDecl& func)
+/* Build the constified version of the function type @type, as described for
+ * _constify_function_return_type(). Returns a null type if the return type
+ * isn’t a pointer. */
+static QualType
+_constified_function_type (QualType type, ASTContext& context)
 {
 	/* We have to construct a new type because the existing FunctionType
 	 * is immutable. */
-	const FunctionType* f_type = func.getType ()->getAs<FunctionType> ();
-	ASTContext& context = func.getASTContext ();
+	const FunctionType* f_type = type->getAs<FunctionType> ();
 	const QualType old_result_type = f_type->getReturnType ();
 
 	const PointerType* old_result_pointer_type = dyn_cast<PointerType> (old_result_type);
 	if (old_result_pointer_type == NULL)
-		return;
+		return QualType ();
 
 	QualType new_result_pointee_type =
 		old_result_pointer_type->getPointeeType ().withConst ();
 	QualType new_result_type = context.getPointerType (new_result_pointee_type);
 
+	const FunctionNoProtoType* f_n_type =
+		dyn_cast<FunctionNoProtoType> (f_type);
+
+	if (f_n_type != NULL) {
+		return context.getFunctionNoProtoType (new_result_type,
+		                                       f_n_type->getExtInfo ());
+	}
+
+	const FunctionProtoType *f_p_type = cast<FunctionProtoType> (f_type);
+	ArrayRef<QualType> param_types = f_p_type->getParamTypes ();
+
+	return context.getFunctionType (new_result_type, param_types,
+	                                f_p_type->getExtProtoInfo ());
+}
+
+/* Make the return type of a FunctionType const. This will go one level of
+ * typing below the return type, so it won’t constify the top-level pointer
+ * return. e.g.:
+ *     char* → const char *          (pointer to const char)
+ * and not:
+ *     char* → char * const          (const pointer to char)
+ *     char* → const char * const    (const pointer to const char)
+ *
+ * All the redeclarations of @func are given the new type. New types are cached
+ * in @constified_types, keyed by the type they were built from, so each is only
+ * built once per translation unit however many times a function is
+ * redeclared. */
+static void
+_constify_function_return_type (FunctionDecl& func,
+                                std::unordered_map<const Type*, QualType>& constified_types)
+{
+	const Type *old_type = func.getType ().getTypePtr ();
+	std::unordered_map<const Type*, QualType>::const_iterator cached =
+		constified_types.find (old_type);
+	QualType t;
+
+	if (cached != constified_types.end ()) {
+		t = cached->second;
+	} else {
+		t = _constified_function_type (func.getType (),
+		                               func.getASTContext ());
+		constified_types.emplace (old_type, t);
+	}
+
+	if (t.isNull ())
+		return;
+
 	for (FunctionDecl* func_decl = func.getMostRecentDecl ();
 	     func_decl != NULL; func_decl = func_decl->getPreviousDecl ()) {
-		const FunctionNoProtoType* f_n_type =
-			dyn_cast<FunctionNoProtoType> (f_type);
-		QualType t;
-
-		if (f_n_type != NULL) {
-			t = context.getFunctionNoProtoType (new_result_type,
-			                                    f_n_type->getExtInfo ());
-		} else {
-			const FunctionProtoType *f_p_type =
-				cast<FunctionProtoType> (f_type);
-			ArrayRef<QualType> param_types = f_p_type->getParamTypes ();
-
-			t = context.getFunctionType (new_result_type,
-			                             param_types,
-			                             f_p_type->getExtProtoInfo ());
-		}
+		/* Earlier redeclarations have already been done. */
+		if (func_decl->getType () == t)
+			continue;
 
 		DEBUG ("Constifying type " <<
 		       func_decl->getType ().getAsString () << " → " <<
@@ -136,224 +132,166 @@ _constify_function_return_type (FunctionDecl& func)
 	}
 }
 
-/* Determine whether the given function should be excluded from having extra
- * nonnull attributes added due to being GLib-internal. Such functions are
- * exported as symbols from libglib-2.0.so, but are deliberately not in the GIR
- * file — and hence we can’t pick up annotations on them. */
-static bool
-_ignore_glib_internal_func (const std::string func_name)
-{
-	static const char *internal_funcs[] = {
-		"g_assertion_message",
-		"g_assertion_message_cmpnum",
-		"g_assertion_message_cmpstr",
-		"g_assertion_message_error",
-		"g_assertion_message_expr",
-		"g_test_trap_assertions",
-		"g_return_if_fail_warning",
-		"g_warn_message",
-	};
-
-	for (unsigned int i = 0; i < G_N_ELEMENTS (internal_funcs); i++) {
-		if (strcmp (func_name.c_str (), internal_funcs[i]) == 0) {
-			return true;
-		}
-	}
-
-	return false;
-}
-
-void
-GirAttributesConsumer::_handle_function_decl (FunctionDecl& func)
+/* Functions which should be excluded from having extra nonnull attributes
+ * added due to being GLib-internal. Such functions are exported as symbols from
+ * libglib-2.0.so, but are deliberately not in the GIR file — and hence we can’t
+ * pick up annotations on them. */
+static const CalleeTable::Name glib_internal_funcs[] = {
+	{ "g_assertion_message", 1 },
+	{ "g_assertion_message_cmpnum", 1 },
+	{ "g_assertion_message_cmpstr", 1 },
+	{ "g_assertion_message_error", 1 },
+	{ "g_assertion_message_expr", 1 },
+	{ "g_test_trap_assertions", 1 },
+	{ "g_return_if_fail_warning", 1 },
+	{ "g_warn_message", 1 },
+};
+
+/* Find the GIR annotation summary for a function declaration, shared between
+ * the annotater and the checker. Returns %NULL if the function has no GIR
+ * data, or if its GIR data doesn’t match its declaration.
+ *
+ * Redeclarations of a function share its summary, so lookups (including
+ * failed ones) are cached in @summaries by canonical declaration. */
+static const FunctionSummary *
+_find_function_summary (FunctionDecl& func, const GirManager& gir_manager,
+                        FunctionSummaryCache& summaries)
 {
 	/* Ignore static functions immediately; they shouldn’t have any
 	 * GIR data, and searching for it massively slows down
 	 * compilation. */
 	StorageClass sc = func.getStorageClass ();
 	if (sc != SC_None && sc != SC_Extern)
-		return;
-
-	/* Try to find typelib information about the function. */
-	const std::string func_name = func.getNameAsString ();  /* TODO: expensive? */
-	GIBaseInfo *info = this->_gir_manager.get ()->find_function_info (func_name);
-
-	if (info == NULL)
-		return;
+		return NULL;
+
+	/* Try to find typelib information about the function. Functions
+	 * without a plain identifier as their name (such as C++ operators)
+	 * can’t have any. */
+	const IdentifierInfo *func_ident = func.getIdentifier ();
+	if (func_ident == NULL)
+		return NULL;
+
+	const FunctionDecl *canonical_decl = func.getCanonicalDecl ();
+	FunctionSummaryCache::const_iterator cached =
+		summaries.find (canonical_decl);
+	const FunctionSummary *summary;
+
+	if (cached != summaries.end ()) {
+		summary = cached->second;
+	} else {
+		summary = gir_manager.find_function_summary (func_ident->getName ());
+		summaries.emplace (canonical_decl, summary);
+	}
 
-	/* Extract information from the GIBaseInfo and add AST attributes
-	 * accordingly. */
-	switch (g_base_info_get_type (info)) {
-	case GI_INFO_TYPE_FUNCTION: {
-		GICallableInfo *callable_info = (GICallableInfo *) info;
-
-		/* GError formal parameters aren’t included in the number of
-		 * callable arguments. */
-		unsigned int k = g_callable_info_get_n_args (callable_info);
-		unsigned int err_params =
-			(g_function_info_get_flags (callable_info) &
-			 GI_FUNCTION_THROWS) ? 1 : 0;
-		unsigned int obj_params =
-			(g_base_info_get_container (info) != NULL &&
-			 g_function_info_get_flags (callable_info) &
-			 GI_FUNCTION_IS_METHOD) ? 1 : 0;
-
-		/* Sanity check. */
-		if (obj_params + k + err_params != func.getNumParams ()) {
-			WARN ("Number of GIR callable parameters (" <<
-			      obj_params + k + err_params << ") "
-			      "differs from number of C formal parameters (" <<
-			      func.getNumParams () << "). Ignoring function " <<
-			      func_name << "().");
-			break;
-		}
+	if (summary == NULL)
+		return NULL;
+
+	/* Sanity check. GError formal parameters aren’t included in the
+	 * number of callable arguments, but n_c_params() accounts for them. */
+	if (summary->n_c_params () != func.getNumParams ()) {
+		WARN ("Number of GIR callable parameters (" <<
+		      summary->n_c_params () << ") "
+		      "differs from number of C formal parameters (" <<
+		      func.getNumParams () << "). Ignoring function " <<
+		      func.getNameAsString () << "().");
+		return NULL;
+	}
 
-		std::vector<ParamIdx> non_null_args;
-		unsigned int j;
+	return summary;
+}
 
-		NonNullAttr* nonnull_attr = func.getAttr<NonNullAttr> ();
-		if (nonnull_attr != NULL) {
-			/* Extend and replace the existing attribute. */
-			DEBUG ("Extending existing attribute.");
-			non_null_args.insert (non_null_args.begin (),
-			                      nonnull_attr->args_begin (),
-			                      nonnull_attr->args_end ());
-		}
+GirAttributesConsumer::GirAttributesConsumer (
+	std::shared_ptr<const GirManager> gir_manager,
+	std::shared_ptr<NonNullAccumulator> nonnull_accumulator) :
+	_gir_manager (gir_manager),
+	_nonnull_accumulator (nonnull_accumulator),
+	_internal_funcs (glib_internal_funcs, G_N_ELEMENTS (glib_internal_funcs))
+{
+}
 
-		for (j = 0; j < k; j++) {
-			GIArgInfo arg;
-			GITypeInfo type_info;
-			GITransfer transfer;
-			GITypeTag type_tag;
-
-			g_callable_info_load_arg (callable_info, j, &arg);
-			g_arg_info_load_type (&arg, &type_info);
-			transfer = g_arg_info_get_ownership_transfer (&arg);
-			type_tag = g_type_info_get_tag (&type_info);
-
-			DEBUG ("GirAttributes: " << func_name << "(" << j <<
-			       ")\n"
-			       "\tTransfer: " << transfer << "\n"
-			       "\tDirection: " <<
-			       g_arg_info_get_direction (&arg) << "\n"
-			       "\tNullable: " <<
-			       g_arg_info_may_be_null (&arg) << "\n"
-			       "\tOptional: " <<
-			       g_arg_info_is_optional (&arg) << "\n"
-			       "\tIs pointer: " <<
-			       g_type_info_is_pointer (&type_info) << "\n"
-			       "\tType tag: " <<
-			       g_type_tag_to_string (
-			           g_type_info_get_tag (&type_info)) << "\n"
-			       "\tArray type: " <<
-			       ((g_type_info_get_tag (&type_info) == GI_TYPE_TAG_ARRAY) ?
-						g_type_info_get_array_type (&type_info) :
-						-1) << "\n"
-			       "\tArray length: " <<
-			       g_type_info_get_array_length (&type_info) << "\n"
-			       "\tArray fixed size: " <<
-			       g_type_info_get_array_fixed_size (&type_info));
-
-			if (_arg_is_nonnull (arg, type_info)) {
-				DEBUG ("Got nonnull arg " << obj_params + j <<
-				       " from GIR.");
-				/* ParamIdx is 1-based. */
-				non_null_args.push_back (ParamIdx (obj_params + j + 1, &func));
-			}
-
-			if (_type_should_be_const (transfer, type_tag)) {
-				ParmVarDecl *parm = func.getParamDecl (obj_params + j);
-				QualType t = parm->getType ();
-
-				if (!t.isConstant (parm->getASTContext ()))
-					parm->setType (t.withConst ());
-			}
-		}
+void
+GirAttributesConsumer::_handle_function_decl (FunctionDecl& func)
+{
+	const FunctionSummary *summary =
+		_find_function_summary (func, *this->_gir_manager.get (),
+		                        this->_summaries);
 
-		if (non_null_args.size () > 0 &&
-		    !_ignore_glib_internal_func (func_name)) {
-			nonnull_attr = ::new (func.getASTContext ())
-				NonNullAttr (func.getSourceRange (),
-				             func.getASTContext (),
-				             non_null_args.data (),
-				             non_null_args.size (), 0);
-			func.addAttr (nonnull_attr);
-		}
+	if (summary == NULL)
+		return;
 
-		/* Process the function’s return type. */
-		/* FIXME: Support returns_nonnull when Clang supports it.
-		 * http://llvm.org/bugs/show_bug.cgi?id=4832 */
-		GITypeInfo return_type_info;
-		GITransfer return_transfer;
-		GITypeTag return_type_tag;
-
-		g_callable_info_load_return_type (info, &return_type_info);
-		return_transfer = g_callable_info_get_caller_owns (info);
-		return_type_tag = g_type_info_get_tag (&return_type_info);
-
-		if (return_transfer != GI_TRANSFER_NOTHING) {
-			WarnUnusedAttr* warn_unused_attr =
-				::new (func.getASTContext ())
-				WarnUnusedAttr (func.getSourceRange (),
-				                func.getASTContext (), 0);
-			func.addAttr (warn_unused_attr);
-		} else if (_type_should_be_const (return_transfer,
-		                                  return_type_tag)) {
-			_constify_function_return_type (func);
+	unsigned int k = summary->n_args;
+	unsigned int obj_params =
+		summary->has_flag (FunctionSummary::IS_METHOD) ? 1 : 0;
+
+	DEBUG ("GirAttributes: " << func.getNameAsString () << "()\n"
+	       "\tNon-null args: " << summary->nonnull_args << "\n"
+	       "\tNullable args: " << summary->nullable_args << "\n"
+	       "\tOut args: " << summary->out_args << "\n"
+	       "\tConst args: " << summary->const_args << "\n"
+	       "\tReturn transfer: " << (int) summary->return_transfer << "\n"
+	       "\tFlags: " << summary->flags);
+
+	bool is_internal = (this->_internal_funcs.lookup (func) != 0);
+	llvm::StringRef func_name = func.getIdentifier ()->getName ();
+	unsigned int j;
+
+	for (j = 0; j < k; j++) {
+		unsigned int arg_flags =
+			this->_gir_manager.get ()->get_arg_flags (func_name,
+			                                          *summary, j);
+
+		if ((arg_flags & FunctionSummary::ARG_NONNULL) &&
+		    !is_internal) {
+			DEBUG ("Got nonnull arg " << obj_params + j <<
+			       " from GIR.");
+			this->_nonnull_accumulator->add (func, obj_params + j);
 		}
 
-		/* Mark the function as deprecated if it wasn’t already. The
-		 * typelib file doesn’t contain a deprecation message, version,
-		 * or replacement function so we can’t make use of them. */
-		if (g_base_info_is_deprecated (info) &&
-		    !func.hasAttr<DeprecatedAttr> ()) {
-			DeprecatedAttr* deprecated_attr =
-				::new (func.getASTContext ())
-				DeprecatedAttr (func.getSourceRange (),
-				                func.getASTContext (),
-				                0);
-			func.addAttr (deprecated_attr);
-		}
+		if (arg_flags & FunctionSummary::ARG_SHOULD_BE_CONST) {
+			ParmVarDecl *parm = func.getParamDecl (obj_params + j);
+			QualType t = parm->getType ();
 
-		/* Mark the function as allocating memory if it’s a
-		 * constructor. */
-		if (g_function_info_get_flags (info) &
-		    GI_FUNCTION_IS_CONSTRUCTOR &&
-		    !func.hasAttr<RestrictAttr> ()) {
-			RestrictAttr* malloc_attr =
-				::new (func.getASTContext ())
-				RestrictAttr (func.getSourceRange (),
-				              func.getASTContext (), 0);
-			func.addAttr (malloc_attr);
+			if (!t.isConstant (parm->getASTContext ()))
+				parm->setType (t.withConst ());
 		}
+	}
 
-		break;
+	/* Process the function’s return type. */
+	/* FIXME: Support returns_nonnull when Clang supports it.
+	 * http://llvm.org/bugs/show_bug.cgi?id=4832 */
+	if (summary->return_transfer != GI_TRANSFER_NOTHING) {
+		WarnUnusedAttr* warn_unused_attr =
+			::new (func.getASTContext ())
+			WarnUnusedAttr (func.getSourceRange (),
+			                func.getASTContext (), 0);
+		func.addAttr (warn_unused_attr);
+	} else if (summary->has_flag (FunctionSummary::RETURN_SHOULD_BE_CONST)) {
+		_constify_function_return_type (func,
+		                                this->_constified_types);
 	}
-	case GI_INFO_TYPE_CALLBACK:
-	case GI_INFO_TYPE_STRUCT:
-	case GI_INFO_TYPE_BOXED:
-	case GI_INFO_TYPE_ENUM:
-	case GI_INFO_TYPE_FLAGS:
-	case GI_INFO_TYPE_OBJECT:
-	case GI_INFO_TYPE_INTERFACE:
-	case GI_INFO_TYPE_CONSTANT:
-	case GI_INFO_TYPE_INVALID_0:
-	case GI_INFO_TYPE_UNION:
-	case GI_INFO_TYPE_VALUE:
-	case GI_INFO_TYPE_SIGNAL:
-	case GI_INFO_TYPE_VFUNC:
-	case GI_INFO_TYPE_PROPERTY:
-	case GI_INFO_TYPE_FIELD:
-	case GI_INFO_TYPE_ARG:
-	case GI_INFO_TYPE_TYPE:
-	case GI_INFO_TYPE_UNRESOLVED:
-	case GI_INFO_TYPE_INVALID:
-	default:
-		WARN ("Error: Unhandled GI type " <<
-		      g_base_info_get_type (info) << " in introspection info "
-		      "for function ‘" << func_name << "’.");
+
+	/* Mark the function as deprecated if it wasn’t already. The typelib
+	 * file doesn’t contain a deprecation message, version, or replacement
+	 * function so we can’t make use of them. */
+	if (summary->has_flag (FunctionSummary::DEPRECATED) &&
+	    !func.hasAttr<DeprecatedAttr> ()) {
+		DeprecatedAttr* deprecated_attr =
+			::new (func.getASTContext ())
+			DeprecatedAttr (func.getSourceRange (),
+			                func.getASTContext (),
+			                0);
+		func.addAttr (deprecated_attr);
 	}
 
-	g_base_info_unref (info);
+	/* Mark the function as allocating memory if it’s a constructor. */
+	if (summary->has_flag (FunctionSummary::IS_CONSTRUCTOR) &&
+	    !func.hasAttr<RestrictAttr> ()) {
+		RestrictAttr* malloc_attr =
+			::new (func.getASTContext ())
+			RestrictAttr (func.getSourceRange (),
+			              func.getASTContext (), 0);
+		func.addAttr (malloc_attr);
+	}
 }
 
 bool
@@ -379,122 +317,50 @@ GirAttributesConsumer::HandleTopLevelDecl (DeclGroupRef decl_group)
 void
 GirAttributesChecker::_handle_function_decl (FunctionDecl& func)
 {
-	/* TODO: Factor this out and share it with the implementation above. */
-	/* Ignore static functions immediately; they shouldn’t have any
-	 * GIR data, and searching for it massively slows down
-	 * compilation. */
-	StorageClass sc = func.getStorageClass ();
-	if (sc != SC_None && sc != SC_Extern)
-		return;
+	const FunctionSummary *summary =
+		_find_function_summary (func, *this->_gir_manager.get (),
+		                        this->_summaries);
 
-	/* Try to find typelib information about the function. */
-	const std::string func_name = func.getNameAsString ();  /* TODO: expensive? */
-	GIBaseInfo *info = this->_gir_manager.get ()->find_function_info (func_name);
-
-	if (info == NULL)
+	if (summary == NULL)
 		return;
 
-	/* Extract information from the GIBaseInfo and check AST attributes
-	 * accordingly. */
-	switch (g_base_info_get_type (info)) {
-	case GI_INFO_TYPE_FUNCTION: {
-		GICallableInfo *callable_info = (GICallableInfo *) info;
-
-		/* GError formal parameters aren’t included in the number of
-		 * callable arguments. */
-		unsigned int k = g_callable_info_get_n_args (callable_info);
-		unsigned int err_params =
-			(g_function_info_get_flags (callable_info) &
-			 GI_FUNCTION_THROWS) ? 1 : 0;
-		unsigned int obj_params =
-			(g_base_info_get_container (info) != NULL &&
-			 g_function_info_get_flags (callable_info) &
-			 GI_FUNCTION_IS_METHOD) ? 1 : 0;
-
-		/* Sanity check. */
-		if (obj_params + k + err_params != func.getNumParams ()) {
-			WARN ("Number of GIR callable parameters (" <<
-			      obj_params + k + err_params << ") "
-			      "differs from number of C formal parameters (" <<
-			      func.getNumParams () << "). Ignoring function " <<
-			      func_name << "().");
-			break;
-		}
-
-		/* Process the function’s return type. */
-		GITypeInfo return_type_info;
-		GITransfer return_transfer;
-		GITypeTag return_type_tag;
-
-		g_callable_info_load_return_type (info, &return_type_info);
-		return_transfer = g_callable_info_get_caller_owns (info);
-		return_type_tag = g_type_info_get_tag (&return_type_info);
-
-		/* If the return type is const-qualified but no (transfer none)
-		 * annotation exists, emit a warning.
-		 *
-		 * Similarly, if a (transfer none) annotation exists but the
-		 * return type is not const-qualified, emit a warning. */
-		if (_function_return_type_is_const (func) &&
-		    return_transfer != GI_TRANSFER_NOTHING) {
-			Debug::emit_error (
-				"Missing (transfer none) annotation on the "
-				"return value of function %0() (already has a "
-				"const modifier).",
-				this->_compiler,
+	/* Process the function’s return type.
+	 *
+	 * If the return type is const-qualified but no (transfer none)
+	 * annotation exists, emit a warning.
+	 *
+	 * Similarly, if a (transfer none) annotation exists but the return type
+	 * is not const-qualified, emit a warning. */
+	if (_function_return_type_is_const (func) &&
+	    summary->return_transfer != GI_TRANSFER_NOTHING) {
+		Debug::emit_error (
+			"Missing (transfer none) annotation on the return "
+			"value of function %0() (already has a const "
+			"modifier).",
+			this->_compiler,
 #ifdef HAVE_LLVM_8_0
-				func.getBeginLoc ()
+			func.getBeginLoc ()
 #else
-				func.getLocStart ()
+			func.getLocStart ()
 #endif
-				)
-			<< func.getNameAsString ();
-		} else if (return_transfer == GI_TRANSFER_NOTHING &&
-		           _type_should_be_const (return_transfer,
-		                                  return_type_tag) &&
-		           !_function_return_type_is_const (func)) {
-			Debug::emit_error (
-				"Missing const modifier on the return value of "
-				"function %0() (already has a (transfer none) "
-				"annotation).",
-				this->_compiler,
+			)
+		<< func.getNameAsString ();
+	} else if (summary->return_transfer == GI_TRANSFER_NOTHING &&
+	           summary->has_flag (FunctionSummary::RETURN_SHOULD_BE_CONST) &&
+	           !_function_return_type_is_const (func)) {
+		Debug::emit_error (
+			"Missing const modifier on the return value of "
+			"function %0() (already has a (transfer none) "
+			"annotation).",
+			this->_compiler,
 #ifdef HAVE_LLVM_8_0
-				func.getBeginLoc ()
+			func.getBeginLoc ()
 #else
-				func.getLocStart ()
+			func.getLocStart ()
 #endif
-				)
-			<< func.getNameAsString ();
-		}
-
-		break;
+			)
+		<< func.getNameAsString ();
 	}
-	case GI_INFO_TYPE_CALLBACK:
-	case GI_INFO_TYPE_STRUCT:
-	case GI_INFO_TYPE_BOXED:
-	case GI_INFO_TYPE_ENUM:
-	case GI_INFO_TYPE_FLAGS:
-	case GI_INFO_TYPE_OBJECT:
-	case GI_INFO_TYPE_INTERFACE:
-	case GI_INFO_TYPE_CONSTANT:
-	case GI_INFO_TYPE_INVALID_0:
-	case GI_INFO_TYPE_UNION:
-	case GI_INFO_TYPE_VALUE:
-	case GI_INFO_TYPE_SIGNAL:
-	case GI_INFO_TYPE_VFUNC:
-	case GI_INFO_TYPE_PROPERTY:
-	case GI_INFO_TYPE_FIELD:
-	case GI_INFO_TYPE_ARG:
-	case GI_INFO_TYPE_TYPE:
-	case GI_INFO_TYPE_UNRESOLVED:
-	case GI_INFO_TYPE_INVALID:
-	default:
-		WARN ("Error: Unhandled GI type " <<
-		      g_base_info_get_type (info) << " in introspection info "
-		      "for function ‘" << func_name << "’.");
-	}
-
-	g_base_info_unref (info);
 }
 
 bool
@@ -23,6 +23,7 @@
 #ifndef TARTAN_GIR_ATTRIBUTES_H
 #define TARTAN_GIR_ATTRIBUTES_H
 
+#include <unordered_map>
 #include <unordered_set>
 
 #include <clang/AST/AST.h>
@@ -31,22 +32,34 @@
 
 #include <girepository.h>
 
+#include "callee-table.h"
 #include "checker.h"
 #include "gir-manager.h"
+#include "nonnull-accumulator.h"
 
 namespace tartan {
 
 using namespace clang;
 
+/* GIR summaries of functions, keyed by canonical declaration; %NULL for
+ * functions without one. */
+typedef std::unordered_map<const FunctionDecl*,
+                           const FunctionSummary*> FunctionSummaryCache;
+
 class GirAttributesConsumer : public clang::ASTConsumer {
 
 public:
 	explicit GirAttributesConsumer (
-		std::shared_ptr<const GirManager> gir_manager) :
-		_gir_manager (gir_manager) {}
+		std::shared_ptr<const GirManager> gir_manager,
+		std::shared_ptr<NonNullAccumulator> nonnull_accumulator);
 
 private:
 	std::shared_ptr<const GirManager> _gir_manager;
+	std::shared_ptr<NonNullAccumulator> _nonnull_accumulator;
+	CalleeTable _internal_funcs;
+	FunctionSummaryCache _summaries;
+	/* Function type → the same type with a constified return type. */
+	std::unordered_map<const Type*, QualType> _constified_types;
 
 	void _handle_function_decl (FunctionDecl& func);
 public:
@@ -64,6 +77,8 @@ public:
 		ASTChecker (compiler, gir_manager, disabled_plugins) {}
 
 private:
+	FunctionSummaryCache _summaries;
+
 	void _handle_function_decl (FunctionDecl& func);
 public:
 	virtual bool HandleTopLevelDecl (DeclGroupRef decl_group);
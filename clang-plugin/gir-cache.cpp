@@ -0,0 +1,289 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2026 Philip Withnall
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip@tecnocode.co.uk>
+ */
+
+/**
+ * GirCache:
+ *
+ * A GIR cache file is laid out as a #CacheHeader, followed by an array of
+ * #CacheEntrys, an array of hash buckets and a string table. Each bucket holds
+ * the index of the first entry in its chain (or %CHAIN_END), and each entry
+ * holds the index of the next entry in the chain. Symbol names are stored as
+ * nul-terminated strings in the string table, and entries refer to them by
+ * offset from the start of the table.
+ *
+ * All integers are in host byte order: the cache is only ever read by the
+ * machine which wrote it.
+ */
+
+#include "config.h"
+
+#include <cstring>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "debug.h"
+#include "gir-cache.h"
+
+#define CACHE_MAGIC "TARTANGC"
+#define CACHE_FORMAT_VERSION 2
+#define CHAIN_END G_MAXUINT32
+
+struct CacheHeader {
+	gchar magic[8];
+	guint32 format_version;
+	guint32 n_entries;
+	guint32 n_buckets;  /* power of two */
+	guint32 entries_offset;
+	guint32 buckets_offset;
+	guint32 strings_offset;
+	guint32 strings_size;
+	guint32 typelib_path;  /* offset into the string table */
+	guint64 typelib_mtime;
+	guint64 typelib_mtime_nsec;
+	guint64 typelib_size;
+	guint64 typelib_inode;
+	gchar tartan_version[32];  /* nul-padded */
+};
+
+struct CacheEntry {
+	guint32 symbol;  /* offset into the string table */
+	guint32 next;  /* index of the next entry in the chain, or CHAIN_END */
+	FunctionSummary summary;
+};
+
+static_assert (sizeof (CacheHeader) % 8 == 0,
+               "CacheHeader must keep the entries 8-byte aligned");
+static_assert (sizeof (CacheEntry) % 8 == 0,
+               "CacheEntry must keep subsequent entries 8-byte aligned");
+static_assert (sizeof (VERSION) <= sizeof (((CacheHeader *) NULL)->tartan_version),
+               "Tartan version string too long for the GIR cache header");
+
+/* FNV-1a. This must be stable across processes, so std::hash can’t be used. */
+static guint32
+_hash_symbol (const char *symbol, size_t length)
+{
+	guint32 hash = 2166136261u;
+
+	for (size_t i = 0; i < length; i++) {
+		hash ^= (guint8) symbol[i];
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+GirCache::GirCache (GMappedFile *mapped_file) :
+	_mapped_file (mapped_file),
+	_data (g_mapped_file_get_contents (mapped_file)),
+	_length (g_mapped_file_get_length (mapped_file))
+{
+}
+
+GirCache::~GirCache ()
+{
+	g_mapped_file_unref (this->_mapped_file);
+}
+
+/* Get the stamp of the typelib at @typelib_path. Returns %false if it can’t be
+ * stat()ed. */
+bool
+GirCache::stamp (const std::string& typelib_path, Stamp& stamp)
+{
+	GStatBuf buf;
+
+	if (g_stat (typelib_path.c_str (), &buf) != 0)
+		return false;
+
+	stamp.mtime = buf.st_mtime;
+#ifdef HAVE_STRUCT_STAT_ST_MTIM_TV_NSEC
+	stamp.mtime_nsec = buf.st_mtim.tv_nsec;
+#else
+	stamp.mtime_nsec = 0;
+#endif
+	stamp.size = buf.st_size;
+	stamp.inode = buf.st_ino;
+
+	return true;
+}
+
+/* Map the cache file at @cache_path and check it’s valid for the given
+ * typelib. Returns %NULL if the cache doesn’t exist, is invalid or is out of
+ * date. */
+GirCache*
+GirCache::open (const std::string& cache_path,
+                const std::string& typelib_path,
+                const Stamp& typelib_stamp)
+{
+	GMappedFile *mapped_file;
+
+	mapped_file = g_mapped_file_new (cache_path.c_str (), FALSE, NULL);
+	if (mapped_file == NULL)
+		return NULL;
+
+	const gchar *data = g_mapped_file_get_contents (mapped_file);
+	gsize length = g_mapped_file_get_length (mapped_file);
+	const CacheHeader *header = (const CacheHeader *) data;
+	bool valid;
+
+	/* Check the header, and that all the sections lie within the file. */
+	valid = (data != NULL && length >= sizeof (CacheHeader) &&
+	         memcmp (header->magic, CACHE_MAGIC,
+	                 sizeof (header->magic)) == 0 &&
+	         header->format_version == CACHE_FORMAT_VERSION &&
+	         strncmp (header->tartan_version, VERSION,
+	                  sizeof (header->tartan_version)) == 0 &&
+	         header->typelib_mtime == typelib_stamp.mtime &&
+	         header->typelib_mtime_nsec == typelib_stamp.mtime_nsec &&
+	         header->typelib_size == typelib_stamp.size &&
+	         header->typelib_inode == typelib_stamp.inode &&
+	         header->n_buckets > 0 &&
+	         (header->n_buckets & (header->n_buckets - 1)) == 0 &&
+	         header->entries_offset % 8 == 0 &&
+	         header->entries_offset <= length &&
+	         header->n_entries <=
+	         (length - header->entries_offset) / sizeof (CacheEntry) &&
+	         header->buckets_offset % 4 == 0 &&
+	         header->buckets_offset <= length &&
+	         header->n_buckets <=
+	         (length - header->buckets_offset) / sizeof (guint32) &&
+	         header->strings_offset <= length &&
+	         header->strings_size > 0 &&
+	         header->strings_size <= length - header->strings_offset &&
+	         data[header->strings_offset + header->strings_size - 1] == '\0' &&
+	         header->typelib_path < header->strings_size &&
+	         typelib_path == data + header->strings_offset +
+	                         header->typelib_path);
+
+	if (!valid) {
+		DEBUG ("Ignoring invalid or out of date GIR cache " <<
+		       cache_path);
+		g_mapped_file_unref (mapped_file);
+		return NULL;
+	}
+
+	return new GirCache (mapped_file);
+}
+
+/* Write a cache file for the given typelib, containing @entries. The file is
+ * written atomically, so concurrent readers and writers will see either the old
+ * or new version. */
+bool
+GirCache::write (const std::string& cache_path,
+                 const std::string& typelib_path,
+                 const Stamp& typelib_stamp,
+                 const std::vector<Entry>& entries,
+                 GError** error)
+{
+	CacheHeader header;
+	std::string strings;
+	std::vector<CacheEntry> cache_entries;
+	std::vector<guint32> buckets;
+	guint32 n_buckets = 1;
+
+	while (n_buckets < entries.size ())
+		n_buckets *= 2;
+
+	buckets.assign (n_buckets, CHAIN_END);
+	cache_entries.reserve (entries.size ());
+
+	/* Build the string table, starting with the typelib path. */
+	strings.append (typelib_path.c_str (), typelib_path.size () + 1);
+
+	for (std::vector<Entry>::const_iterator it = entries.begin (),
+	     ie = entries.end (); it != ie; ++it) {
+		const std::string& symbol = it->first;
+		guint32 bucket = _hash_symbol (symbol.data (), symbol.size ()) &
+		                 (n_buckets - 1);
+		CacheEntry entry;
+
+		entry.symbol = strings.size ();
+		entry.next = buckets[bucket];
+		entry.summary = it->second;
+
+		buckets[bucket] = cache_entries.size ();
+		cache_entries.push_back (entry);
+		strings.append (symbol.c_str (), symbol.size () + 1);
+	}
+
+	memset (&header, 0, sizeof (header));
+	memcpy (header.magic, CACHE_MAGIC, sizeof (header.magic));
+	header.format_version = CACHE_FORMAT_VERSION;
+	header.n_entries = cache_entries.size ();
+	header.n_buckets = n_buckets;
+	header.entries_offset = sizeof (header);
+	header.buckets_offset = header.entries_offset +
+	                        cache_entries.size () * sizeof (CacheEntry);
+	header.strings_offset = header.buckets_offset +
+	                        buckets.size () * sizeof (guint32);
+	header.strings_size = strings.size ();
+	header.typelib_path = 0;
+	header.typelib_mtime = typelib_stamp.mtime;
+	header.typelib_mtime_nsec = typelib_stamp.mtime_nsec;
+	header.typelib_size = typelib_stamp.size;
+	header.typelib_inode = typelib_stamp.inode;
+	strncpy (header.tartan_version, VERSION,
+	         sizeof (header.tartan_version));
+
+	std::string contents;
+	contents.reserve (header.strings_offset + header.strings_size);
+	contents.append ((const gchar *) &header, sizeof (header));
+	contents.append ((const gchar *) cache_entries.data (),
+	                 cache_entries.size () * sizeof (CacheEntry));
+	contents.append ((const gchar *) buckets.data (),
+	                 buckets.size () * sizeof (guint32));
+	contents.append (strings);
+
+	return g_file_set_contents (cache_path.c_str (), contents.data (),
+	                            contents.size (), error);
+}
+
+/* Look up the summary for the function with C symbol @symbol. The returned
+ * pointer is valid for the lifetime of the #GirCache. */
+const FunctionSummary*
+GirCache::lookup (llvm::StringRef symbol) const
+{
+	const CacheHeader *header = (const CacheHeader *) this->_data;
+	const CacheEntry *entries =
+		(const CacheEntry *) (this->_data + header->entries_offset);
+	const guint32 *buckets =
+		(const guint32 *) (this->_data + header->buckets_offset);
+	const gchar *strings = this->_data + header->strings_offset;
+
+	guint32 bucket = _hash_symbol (symbol.data (), symbol.size ()) &
+	                 (header->n_buckets - 1);
+
+	/* Bound the chain length, in case the file is corrupt. */
+	guint32 i = buckets[bucket];
+	for (guint32 n = 0; i != CHAIN_END && n < header->n_entries; n++) {
+		if (i >= header->n_entries ||
+		    entries[i].symbol >= header->strings_size)
+			return NULL;
+
+		if (symbol == strings + entries[i].symbol)
+			return &entries[i].summary;
+
+		i = entries[i].next;
+	}
+
+	return NULL;
+}
@@ -0,0 +1,81 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2026 Philip Withnall
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip@tecnocode.co.uk>
+ */
+
+#ifndef TARTAN_GIR_CACHE_H
+#define TARTAN_GIR_CACHE_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <glib.h>
+
+#include <llvm/ADT/StringRef.h>
+
+#include "gir-manager.h"
+
+/* On-disk cache of the #FunctionSummary for every function in a typelib, so
+ * that compiler invocations other than the first don’t need to load the typelib
+ * at all. Cache files are mapped read-only, so concurrent compiler processes
+ * share them through the page cache.
+ *
+ * A cache file is only valid for the typelib path and #GirCache::Stamp it was
+ * generated from, and for the version of Tartan which generated it. */
+class GirCache {
+public:
+	typedef std::pair<std::string, FunctionSummary> Entry;
+
+	/* Identifies the contents of a typelib file. The modification time has
+	 * nanosecond precision where the platform supports it, as a typelib
+	 * may be rewritten within a second of the cache being generated; the
+	 * inode catches typelibs which are replaced by renaming. */
+	struct Stamp {
+		guint64 mtime;
+		guint64 mtime_nsec;  /* 0 if not supported */
+		guint64 size;
+		guint64 inode;
+	};
+
+	~GirCache ();
+
+	static bool stamp (const std::string& typelib_path, Stamp& stamp);
+
+	static GirCache* open (const std::string& cache_path,
+	                       const std::string& typelib_path,
+	                       const Stamp& typelib_stamp);
+	static bool write (const std::string& cache_path,
+	                   const std::string& typelib_path,
+	                   const Stamp& typelib_stamp,
+	                   const std::vector<Entry>& entries,
+	                   GError** error);
+
+	const FunctionSummary* lookup (llvm::StringRef symbol) const;
+
+private:
+	GirCache (GMappedFile *mapped_file);
+
+	GMappedFile *_mapped_file;  /* owned */
+	const gchar *_data;  /* unowned; points into @_mapped_file */
+	gsize _length;
+};
+
+#endif /* !TARTAN_GIR_CACHE_H */
@@ -20,227 +20,1201 @@
  *     Philip Withnall <philip.withnall@collabora.co.uk>
  */
 
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <tuple>
+#include <unordered_set>
+#include <utility>
+
 #include <girepository.h>
 #include <gitypes.h>
+#include <glib/gstdio.h>
 
 #include <clang/AST/Attr.h>
 
 #include "debug.h"
+#include "gir-cache.h"
 #include "gir-manager.h"
+#include "stats.h"
+#include "typelib-reader.h"
+
+GirManager::GIIndex::~GIIndex ()
+{
+	for (llvm::StringMap<IndexEntry>::const_iterator
+	     it = this->functions.begin (), ie = this->functions.end ();
+	     it != ie; ++it) {
+		g_base_info_unref (it->second.info);
+	}
+
+	for (llvm::StringMap<GIBaseInfo*>::const_iterator
+	     it = this->types.begin (), ie = this->types.end ();
+	     it != ie; ++it) {
+		if (it->second != NULL)
+			g_base_info_unref (it->second);
+	}
+}
+
+GirManager::Nspace::Nspace () :
+	loaded (false), load_error (NULL), required (false), typelib (NULL),
+	gi_index (NULL)
+{
+}
+
+GirManager::Nspace::~Nspace ()
+{
+	GError *error = this->load_error.load (std::memory_order_relaxed);
+
+	if (error != NULL)
+		g_error_free (error);
+
+	delete this->gi_index.load (std::memory_order_relaxed);
+}
 
-GirManager::GirManager ()
+GirManager::GirManager () :
+	_nspaces (std::make_shared<NspaceList> ()),
+	_object_cache_generation (0),
+	_n_hierarchy_interfaces (0)
 {
 	this->_repo = g_irepository_get_default ();
 }
 
+GirManager::~GirManager ()
+{
+	for (llvm::StringMap<GIBaseInfo*>::const_iterator
+	     it = this->_object_cache.begin (), ie = this->_object_cache.end ();
+	     it != ie; ++it) {
+		if (it->second != NULL)
+			g_base_info_unref (it->second);
+	}
+}
+
+/* Set the directory to store GIR caches in. Caches are keyed by the typelib
+ * path, so can be shared between projects. An empty @cache_dir disables
+ * caching. */
+void
+GirManager::set_cache_dir (const std::string& cache_dir)
+{
+	std::lock_guard<std::mutex> lock (this->_mutex);
+	this->_cache_dir = cache_dir;
+}
+
+std::string
+GirManager::get_cache_dir () const
+{
+	std::lock_guard<std::mutex> lock (this->_mutex);
+	return this->_cache_dir;
+}
+
+/* Look up the namespace entry for (@gi_namespace, @gi_version), returning
+ * %false if it hasn’t been loaded or registered. Must be called with the lock
+ * held. */
+bool
+GirManager::_find_nspace (const std::string& gi_namespace,
+                          const std::string& gi_version,
+                          size_t& nspace_index) const
+{
+	for (size_t i = 0; i < this->_typelibs.size (); i++) {
+		if (this->_typelibs[i]->nspace == gi_namespace &&
+		    this->_typelibs[i]->version == gi_version) {
+			nspace_index = i;
+			return true;
+		}
+	}
+
+	return false;
+}
+
 void
 GirManager::load_namespace (const std::string& gi_namespace,
                             const std::string& gi_version,
                             GError** error)
 {
-	/* Load the GIR typelib. */
-	GITypelib* typelib = g_irepository_require (this->_repo,
-	                                            gi_namespace.c_str (),
-	                                            gi_version.c_str (),
-	                                            (GIRepositoryLoadFlags) 0,
-	                                            error);
+	std::lock_guard<std::mutex> lock (this->_mutex);
+	this->_load_namespace_locked (gi_namespace, gi_version, error);
+}
+
+void
+GirManager::_load_namespace_locked (const std::string& gi_namespace,
+                                    const std::string& gi_version,
+                                    GError** error)
+{
+	/* Already loaded or registered? g_irepository_require() would happily
+	 * return the same typelib again, but there is no point in re-indexing
+	 * it. */
+	size_t existing;
 
-	if (typelib == NULL)
+	if (this->_find_nspace (gi_namespace, gi_version, existing)) {
+		this->_load_nspace (*this->_typelibs[existing], error);
 		return;
+	}
 
-	/* Get the C prefix from the repository and convert it to lower case. */
-	const char *c_prefix =
-		g_irepository_get_c_prefix (this->_repo,
-		                            gi_namespace.c_str ());
-	if (c_prefix == NULL) {
-		c_prefix = "";
+	std::unique_ptr<Nspace> r (new Nspace ());
+	r->nspace = gi_namespace;
+	r->version = gi_version;
+
+	/* Load the GIR typelib. This fills in the C prefix. */
+	r->loaded = true;
+	this->_require_nspace (*r, error);
+
+	if (r->typelib == NULL)
+		return;
+
+	this->_add_nspace (std::move (r));
+}
+
+bool
+GirManager::_c_prefix_is_longer (const Nspace* a, const Nspace* b)
+{
+	return a->c_prefix.size () > b->c_prefix.size ();
+}
+
+/* Add a newly loaded or registered namespace, publish a new snapshot of the
+ * namespaces, and invalidate everything which depends on the set of namespaces.
+ * Must be called with the lock held. */
+void
+GirManager::_add_nspace (std::unique_ptr<Nspace> r)
+{
+	std::shared_ptr<NspaceList> nspaces =
+		std::make_shared<NspaceList> (*this->_current_nspaces ());
+
+	nspaces->by_registration.push_back (r.get ());
+	nspaces->by_c_prefix.push_back (r.get ());
+	std::stable_sort (nspaces->by_c_prefix.begin (),
+	                  nspaces->by_c_prefix.end (), _c_prefix_is_longer);
+
+	this->_typelibs.push_back (std::move (r));
+	std::atomic_store (&this->_nspaces,
+	                   std::shared_ptr<const NspaceList> (nspaces));
+
+	std::lock_guard<std::mutex> lock (this->_object_cache_mutex);
+
+	for (llvm::StringMap<GIBaseInfo*>::const_iterator
+	     it = this->_object_cache.begin (), ie = this->_object_cache.end ();
+	     it != ie; ++it) {
+		if (it->second != NULL)
+			g_base_info_unref (it->second);
+	}
+
+	this->_object_cache.clear ();
+	this->_object_cache_generation++;
+}
+
+std::shared_ptr<const GirManager::NspaceList>
+GirManager::_current_nspaces () const
+{
+	return std::atomic_load (&this->_nspaces);
+}
+
+/* Register a namespace without loading it. The typelib is mapped, but only its
+ * C prefix is read from the header; the typelib itself is indexed the first
+ * time a function or type with that C prefix is looked up (or by
+ * preload_namespaces()). If the typelib header can’t be read, this falls back
+ * to load_namespace(). */
+void
+GirManager::register_namespace (const std::string& gi_namespace,
+                                const std::string& gi_version,
+                                const std::string& typelib_path,
+                                GError** error)
+{
+	std::lock_guard<std::mutex> lock (this->_mutex);
+	size_t existing;
+
+	if (this->_find_nspace (gi_namespace, gi_version, existing))
+		return;
+
+	std::unique_ptr<Nspace> r (new Nspace ());
+
+	r->reader.reset (TypelibReader::open (typelib_path, gi_namespace,
+	                                      gi_version));
+
+	if (r->reader == nullptr) {
+		DEBUG ("Couldn’t read header of typelib " << typelib_path <<
+		       "; loading it instead.");
+		this->_load_namespace_locked (gi_namespace, gi_version,
+		                              error);
+		return;
 	}
 
-	Nspace r;
-	r.nspace = gi_namespace;
-	r.version = gi_version;
-	r.c_prefix = std::string (c_prefix);
-	r.c_prefix_lower = std::string (c_prefix);
-	r.typelib = typelib;
+	r->nspace = gi_namespace;
+	r->version = gi_version;
+	r->c_prefix = r->reader->get_c_prefix ();
+	r->c_prefix_lower = r->c_prefix;
+	r->typelib_path = typelib_path;
 
-	std::transform (r.c_prefix_lower.begin (), r.c_prefix_lower.end (),
-	                r.c_prefix_lower.begin (), ::tolower);
+	std::transform (r->c_prefix_lower.begin (), r->c_prefix_lower.end (),
+	                r->c_prefix_lower.begin (), ::tolower);
 
-	this->_typelibs.push_back (r);
+	this->_add_nspace (std::move (r));
 }
 
-/* Returns a reference to the #GIFunctionInfo, or %NULL. */
-static GIFunctionInfo *
-_find_function_in_function (GIFunctionInfo *info, const std::string &func_name)
+/* Whether another version of the same namespace is already in use. The
+ * #GIRepository can only hold one version of each namespace, so only the first
+ * version to be loaded is used; this applies the same rule to namespaces which
+ * are loaded from the GIR cache or read in place. If it is, @error is set.
+ * Must be called with the lock held. */
+bool
+GirManager::_nspace_version_conflicts (const Nspace& r, GError** error) const
 {
-	if (g_function_info_get_symbol (info) == func_name) {
-		return g_base_info_ref (info);
+	for (std::vector<std::unique_ptr<Nspace>>::const_iterator it =
+	     this->_typelibs.begin (), ie = this->_typelibs.end ();
+	     it != ie; ++it) {
+		const Nspace& other = **it;
+
+		if (&other == &r || other.nspace != r.nspace ||
+		    other.version == r.version ||
+		    (other.cache == nullptr && other.blob_index == nullptr &&
+		     other.typelib == NULL))
+			continue;
+
+		g_set_error (error, G_IREPOSITORY_ERROR,
+		             G_IREPOSITORY_ERROR_NAMESPACE_VERSION_CONFLICT,
+		             "Requiring namespace ‘%s’ version ‘%s’, "
+		             "but another version is already loaded",
+		             r.nspace.c_str (), r.version.c_str ());
+		return true;
 	}
 
-	return NULL;
+	return false;
+}
+
+/* Load @r if that hasn’t already been attempted, and report any error,
+ * including one from preload_namespaces(). This doesn’t take the lock once the
+ * namespace has been loaded and any error reported. */
+void
+GirManager::_ensure_loaded (Nspace& r) const
+{
+	if (r.loaded.load (std::memory_order_acquire) &&
+	    r.load_error.load (std::memory_order_relaxed) == NULL)
+		return;
+
+	GError *error = NULL;
+
+	{
+		std::lock_guard<std::mutex> lock (this->_mutex);
+		this->_load_nspace (r, &error);
+	}
+
+	this->_warn_load_error (r, error);
+}
+
+/* Activate a registered namespace, if that hasn’t already been attempted. If
+ * caching is enabled, this maps the namespace’s GIR cache; otherwise (or if the
+ * cache is out of date) it indexes the typelib, and writes a new cache. If
+ * activating it in preload_namespaces() failed, that error is returned, once.
+ * Must be called with the lock held. */
+void
+GirManager::_load_nspace (Nspace& r, GError** error) const
+{
+	if (r.loaded.load (std::memory_order_relaxed)) {
+		GError *load_error =
+			r.load_error.exchange (NULL, std::memory_order_relaxed);
+
+		if (load_error != NULL)
+			g_propagate_error (error, load_error);
+
+		return;
+	}
+
+	if (r.reader != nullptr) {
+		std::unique_ptr<GirCache> cache;
+		std::unique_ptr<BlobIndex> blob_index;
+		tartan::Stats& stats = tartan::Stats::current ();
+
+		_prepare_nspace (r, this->_cache_dir, stats, cache,
+		                 blob_index);
+		this->_activate_nspace (r, std::move (cache),
+		                        std::move (blob_index), stats, error);
+	} else {
+		this->_require_nspace (r, error);
+	}
+
+	/* Publish the cache and index to lookups which don’t hold the lock. */
+	r.loaded.store (true, std::memory_order_release);
+}
+
+/* Do the expensive part of activating a registered namespace: map its GIR
+ * cache if caching is enabled and the cache is up to date, or index its typelib
+ * in place otherwise. If the typelib can’t be read in place, neither is
+ * returned, and the typelib should be loaded into the #GIRepository instead.
+ * This only reads fields of @r which are fixed when it is registered, so
+ * doesn’t need the lock. */
+void
+GirManager::_prepare_nspace (const Nspace& r, const std::string& cache_dir,
+                             tartan::Stats& stats,
+                             std::unique_ptr<GirCache>& cache,
+                             std::unique_ptr<BlobIndex>& blob_index)
+{
+	GirCache::Stamp stamp;
+
+	if (!cache_dir.empty () && GirCache::stamp (r.typelib_path, stamp)) {
+		cache.reset (GirCache::open (_cache_path (cache_dir, r),
+		                             r.typelib_path, stamp));
+
+		if (cache != nullptr)
+			return;
+	}
+
+	tartan::StatsTimer timer (stats, stats.typelib_load);
+
+	blob_index.reset (new BlobIndex ());
+
+	if (!_index_typelib (*r.reader, r.c_prefix_lower, *blob_index)) {
+		DEBUG ("Couldn’t read typelib " << r.typelib_path <<
+		       " in place; loading it instead.");
+		blob_index.reset ();
+	}
+}
+
+/* Install the GIR cache or index returned by _prepare_nspace(), loading the
+ * typelib into the #GIRepository if there is neither, and write a new GIR cache
+ * if caching is enabled and @cache is NULL. Must be called with the lock
+ * held. */
+void
+GirManager::_activate_nspace (Nspace& r, std::unique_ptr<GirCache> cache,
+                              std::unique_ptr<BlobIndex> blob_index,
+                              tartan::Stats& stats, GError** error) const
+{
+	if (this->_nspace_version_conflicts (r, error))
+		return;
+
+	if (cache != nullptr) {
+		DEBUG ("Using GIR cache for " << r.nspace << " " << r.version);
+		stats.count (stats.gir_cache_maps);
+		r.cache = std::move (cache);
+		return;
+	}
+
+	if (blob_index != nullptr) {
+		DEBUG ("Read typelib " << r.nspace << " " << r.version <<
+		       " in place");
+		r.blob_index = std::move (blob_index);
+	} else {
+		this->_require_nspace (r, error);
+	}
+
+	if (!this->_cache_dir.empty ())
+		this->_write_cache (r);
+}
+
+/* Maximum number of threads preload_namespaces() uses. Indexing a typelib in
+ * place is quick, so more threads than this would mostly wait for the disk. */
+#define MAX_PRELOAD_THREADS 4
+
+/* Activate all the registered namespaces which haven’t been activated yet,
+ * mapping their GIR caches or indexing their typelibs in place on a few threads
+ * at once. Otherwise, namespaces are activated one at a time, with the lock
+ * held, the first time they’re needed. Namespaces which can’t be read in place,
+ * or which conflict with another version, are left to be loaded (and the error
+ * reported) as usual. */
+void
+GirManager::preload_namespaces ()
+{
+	std::vector<Nspace*> nspaces;
+	std::string cache_dir;
+
+	{
+		std::lock_guard<std::mutex> lock (this->_mutex);
+
+		cache_dir = this->_cache_dir;
+
+		for (std::vector<std::unique_ptr<Nspace>>::const_iterator it =
+		     this->_typelibs.begin (), ie = this->_typelibs.end ();
+		     it != ie; ++it) {
+			Nspace& r = **it;
+
+			if (r.reader != nullptr &&
+			    !r.loaded.load (std::memory_order_relaxed))
+				nspaces.push_back (&r);
+		}
+	}
+
+	unsigned int n_threads = std::thread::hardware_concurrency ();
+	n_threads = std::max (n_threads, 1u);
+	n_threads = std::min (n_threads, (unsigned int) MAX_PRELOAD_THREADS);
+	n_threads = std::min (n_threads, (unsigned int) nspaces.size ());
+
+	/* Stats::current() is per thread, so each of the other threads records
+	 * into its own Stats, which are added to this thread’s once they have
+	 * finished. */
+	tartan::Stats& stats = tartan::Stats::current ();
+	std::vector<tartan::Stats> thread_stats (std::max (n_threads, 1u) - 1);
+
+	/* Each namespace is prepared into its own element of @prepared, so the
+	 * threads don’t need the lock. */
+	std::vector<PreparedNspace> prepared (nspaces.size ());
+
+	/* This thread does its share too. */
+	std::atomic<size_t> next (0);
+	std::vector<std::thread> threads;
+
+	for (unsigned int i = 1; i < n_threads; i++) {
+		tartan::Stats& worker_stats = thread_stats[i - 1];
+
+		worker_stats.enabled = stats.enabled;
+		threads.push_back (std::thread (&GirManager::_prepare_nspaces,
+		                                std::cref (nspaces),
+		                                std::cref (cache_dir),
+		                                std::ref (next),
+		                                std::ref (prepared),
+		                                std::ref (worker_stats)));
+	}
+
+	_prepare_nspaces (nspaces, cache_dir, next, prepared, stats);
+
+	for (std::vector<std::thread>::iterator it = threads.begin (),
+	     ie = threads.end (); it != ie; ++it)
+		it->join ();
+
+	for (std::vector<tartan::Stats>::const_iterator it =
+	     thread_stats.begin (), ie = thread_stats.end (); it != ie; ++it)
+		stats.add (*it);
+
+	/* Activate the namespaces one at a time, in the order they were
+	 * registered, so that when several versions of a namespace are
+	 * installed, the first one on the typelib search path wins however
+	 * long each took to prepare. If a version can’t be read in place, the
+	 * later versions are left to be loaded after it, as usual. An
+	 * activation error is kept in the namespace, to be reported by the
+	 * first lookup which needs it, rather than activating it again. */
+	std::unordered_set<std::string> deferred;
+	std::lock_guard<std::mutex> lock (this->_mutex);
+
+	for (size_t i = 0; i < nspaces.size (); i++) {
+		Nspace& r = *nspaces[i];
+		GError *error = NULL;
+
+		if (r.loaded.load (std::memory_order_relaxed) ||
+		    deferred.count (r.nspace) > 0)
+			continue;
+
+		if (prepared[i].cache == nullptr &&
+		    prepared[i].blob_index == nullptr) {
+			deferred.insert (r.nspace);
+			continue;
+		}
+
+		this->_activate_nspace (r, std::move (prepared[i].cache),
+		                        std::move (prepared[i].blob_index),
+		                        stats, &error);
+
+		r.load_error.store (error, std::memory_order_relaxed);
+		r.loaded.store (true, std::memory_order_release);
+	}
+}
+
+/* Worker for preload_namespaces(): take namespaces from @nspaces until there
+ * are none left, preparing each into the same element of @prepared.
+ * Statistics are recorded in @stats. */
+void
+GirManager::_prepare_nspaces (const std::vector<Nspace*>& nspaces,
+                              const std::string& cache_dir,
+                              std::atomic<size_t>& next,
+                              std::vector<PreparedNspace>& prepared,
+                              tartan::Stats& stats)
+{
+	for (size_t i = next++; i < nspaces.size (); i = next++)
+		_prepare_nspace (*nspaces[i], cache_dir, stats,
+		                 prepared[i].cache, prepared[i].blob_index);
+}
+
+/* Load and index the namespace’s typelib, if that hasn’t already been
+ * attempted. This is needed for anything other than function summaries, even
+ * if the namespace’s GIR cache has been mapped or its typelib read in place.
+ * It isn’t loaded if another version of the namespace is in use, so that all
+ * the information about a namespace comes from the same version. Must be
+ * called with the lock held. */
+void
+GirManager::_require_nspace (Nspace& r, GError** error) const
+{
+	if (r.required.load (std::memory_order_relaxed))
+		return;
+
+	if (this->_nspace_version_conflicts (r, error)) {
+		r.required.store (true, std::memory_order_release);
+		return;
+	}
+
+	DEBUG ("Loading typelib " << r.nspace << " " << r.version);
+
+	tartan::StatsTimer timer (tartan::Stats::current ().typelib_load);
+
+	r.typelib = g_irepository_require (this->_repo,
+	                                   r.nspace.c_str (),
+	                                   r.version.c_str (),
+	                                   (GIRepositoryLoadFlags) 0,
+	                                   error);
+
+	if (r.typelib != NULL) {
+		/* Get the C prefix from the repository and convert it to lower
+		 * case, unless it was already read from the typelib header.
+		 * This only happens before the namespace is published. */
+		if (r.typelib_path.empty ()) {
+			const char *c_prefix =
+				g_irepository_get_c_prefix (this->_repo,
+				                            r.nspace.c_str ());
+			if (c_prefix == NULL) {
+				c_prefix = "";
+			}
+
+			r.c_prefix = std::string (c_prefix);
+			r.c_prefix_lower = std::string (c_prefix);
+
+			std::transform (r.c_prefix_lower.begin (),
+			                r.c_prefix_lower.end (),
+			                r.c_prefix_lower.begin (), ::tolower);
+		}
+
+		this->_index_namespace (r);
+	}
+
+	r.required.store (true, std::memory_order_release);
 }
 
-/* Returns a reference to the #GIFunctionInfo, or %NULL. */
-static GIFunctionInfo *
-_find_function_in_struct (GIStructInfo *info, const std::string &func_name)
+/* Get the indexes of @r’s loaded typelib, loading it if that hasn’t been
+ * attempted yet. Returns %NULL if loading it failed. This only takes the lock
+ * if the typelib has to be loaded. */
+GirManager::GIIndex*
+GirManager::_require_gi_index (Nspace& r) const
 {
-	GIFunctionInfo *f_info = NULL;
-	gint n_methods = g_struct_info_get_n_methods (info);
+	if (!r.required.load (std::memory_order_acquire)) {
+		std::lock_guard<std::mutex> lock (this->_mutex);
+		GError *error = NULL;
 
-	for (gint i = 0; i < n_methods && f_info == NULL; i++) {
-		GIFunctionInfo *_info = g_struct_info_get_method (info, i);
-		f_info = _find_function_in_function (_info, func_name);
-		g_base_info_unref (_info);
+		this->_require_nspace (r, &error);
+		this->_warn_load_error (r, error);
 	}
 
-	return f_info;
+	return r.gi_index.load (std::memory_order_acquire);
 }
 
-/* Returns a reference to the #GIFunctionInfo, or %NULL. */
-static GIFunctionInfo *
-_find_function_in_enum (GIEnumInfo *info, const std::string &func_name)
+/* Report a failure to lazily load a namespace. As when loading typelibs up
+ * front, version conflicts are expected (when several versions of a namespace
+ * are installed) and are not reported. */
+void
+GirManager::_warn_load_error (const Nspace& r, GError *error) const
 {
-	GIFunctionInfo *f_info = NULL;
-	gint n_methods = g_enum_info_get_n_methods (info);
+	if (error == NULL)
+		return;
 
-	for (gint i = 0; i < n_methods && f_info == NULL; i++) {
-		GIFunctionInfo *_info = g_enum_info_get_method (info, i);
-		f_info = _find_function_in_function (_info, func_name);
-		g_base_info_unref (_info);
+	if (!g_error_matches (error, G_IREPOSITORY_ERROR,
+	                      G_IREPOSITORY_ERROR_NAMESPACE_VERSION_CONFLICT)) {
+		WARN ("Failed to load GI repository ‘" << r.nspace <<
+		      "’ (version " << r.version << "): " << error->message);
 	}
 
-	return f_info;
+	g_error_free (error);
+}
+
+/* Path of the GIR cache file for @r. Several versions of a typelib may be
+ * installed in different directories, so the file name includes a hash of the
+ * typelib path. */
+std::string
+GirManager::_cache_path (const std::string& cache_dir, const Nspace& r)
+{
+	gchar *file_name = g_strdup_printf ("%s-%s-%08x.cache",
+	                                    r.nspace.c_str (),
+	                                    r.version.c_str (),
+	                                    g_str_hash (r.typelib_path.c_str ()));
+	gchar *path = g_build_filename (cache_dir.c_str (), file_name, NULL);
+	std::string retval (path);
+
+	g_free (path);
+	g_free (file_name);
+
+	return retval;
 }
 
-/* Returns a reference to the #GIFunctionInfo, or %NULL. */
-static GIFunctionInfo *
-_find_function_in_object (GIObjectInfo *info, const std::string &func_name)
+/* Determine whether a type should be const, given its (transfer) annotation and
+ * base type. */
+static bool
+_type_should_be_const (GITransfer transfer, GITypeTag type_tag)
 {
-	GIFunctionInfo *f_info = NULL;
-	gint n_methods = g_object_info_get_n_methods (info);
+	return (transfer == GI_TRANSFER_NOTHING &&
+	        (type_tag == GI_TYPE_TAG_UTF8 ||
+	         type_tag == GI_TYPE_TAG_FILENAME ||
+	         type_tag == GI_TYPE_TAG_ARRAY ||
+	         type_tag == GI_TYPE_TAG_GLIST ||
+	         type_tag == GI_TYPE_TAG_GSLIST ||
+	         type_tag == GI_TYPE_TAG_GHASH ||
+	         type_tag == GI_TYPE_TAG_ERROR));
+}
+
+/* Determine whether an argument is definitely required to be non-NULL given
+ * its (nullable) and (optional) annotations, direction annotation and type.
+ *
+ * If it’s an array type, it may be NULL if its associated length parameter is
+ * 0. Since we can’t currently analyse array bounds, assume that all C array
+ * parameters may be NULL. (Other array types are structs, so may not be
+ * NULL.) */
+static bool
+_arg_is_nonnull (const TypelibReader::Arg& arg)
+{
+	return ((arg.type.is_pointer || arg.direction == GI_DIRECTION_OUT) &&
+	        !arg.may_be_null &&
+	        !arg.is_optional &&
+	        !(arg.type.tag == GI_TYPE_TAG_ARRAY &&
+	          arg.type.array_type == GI_ARRAY_TYPE_C));
+}
+
+/* Get the #FunctionSummary::ArgFlags for an argument. */
+static unsigned int
+_arg_flags (const TypelibReader::Arg& arg)
+{
+	unsigned int flags = 0;
+
+	if (_arg_is_nonnull (arg))
+		flags |= FunctionSummary::ARG_NONNULL;
+	if (arg.may_be_null || arg.is_optional)
+		flags |= FunctionSummary::ARG_NULLABLE;
+	if (arg.direction == GI_DIRECTION_OUT ||
+	    arg.direction == GI_DIRECTION_INOUT)
+		flags |= FunctionSummary::ARG_OUT;
+	if (_type_should_be_const (arg.transfer, arg.type.tag))
+		flags |= FunctionSummary::ARG_SHOULD_BE_CONST;
+
+	return flags;
+}
+
+/* Record the annotations on the @j-th argument of a function in @summary. */
+static void
+_summarise_arg (const TypelibReader::Arg& arg, unsigned int j,
+                FunctionSummary& summary)
+{
+	guint64 bit = G_GUINT64_CONSTANT (1) << j;
+	unsigned int flags = _arg_flags (arg);
+
+	if (flags & FunctionSummary::ARG_NONNULL)
+		summary.nonnull_args |= bit;
+	if (flags & FunctionSummary::ARG_NULLABLE)
+		summary.nullable_args |= bit;
+	if (flags & FunctionSummary::ARG_OUT)
+		summary.out_args |= bit;
+	if (flags & FunctionSummary::ARG_SHOULD_BE_CONST)
+		summary.const_args |= bit;
+}
+
+/* Load the @j-th argument of @callable_info in the same form as
+ * TypelibReader::get_arg() does. */
+static void
+_load_arg (GICallableInfo *callable_info, unsigned int j,
+           TypelibReader::Arg& arg)
+{
+	GIArgInfo arg_info;
+	GITypeInfo type_info;
+
+	g_callable_info_load_arg (callable_info, j, &arg_info);
+	g_arg_info_load_type (&arg_info, &type_info);
+
+	arg.direction = g_arg_info_get_direction (&arg_info);
+	arg.transfer = g_arg_info_get_ownership_transfer (&arg_info);
+	arg.may_be_null = g_arg_info_may_be_null (&arg_info);
+	arg.is_optional = g_arg_info_is_optional (&arg_info);
+	arg.type.is_pointer = g_type_info_is_pointer (&type_info);
+	arg.type.tag = g_type_info_get_tag (&type_info);
+	arg.type.array_type = (arg.type.tag == GI_TYPE_TAG_ARRAY) ?
+	                      g_type_info_get_array_type (&type_info) :
+	                      GI_ARRAY_TYPE_C;
+}
+
+/* Extract everything the annotaters and checkers need to know about a
+ * function from its #GIFunctionInfo. */
+static void
+_summarise_function (GIFunctionInfo *info, FunctionSummary& summary)
+{
+	GICallableInfo *callable_info = (GICallableInfo *) info;
+	GIFunctionInfoFlags flags = g_function_info_get_flags (info);
+	unsigned int n_args = g_callable_info_get_n_args (callable_info);
+
+	memset (&summary, 0, sizeof (summary));
+	summary.n_args = n_args;
+
+	if (g_base_info_get_container (info) != NULL &&
+	    (flags & GI_FUNCTION_IS_METHOD))
+		summary.flags |= FunctionSummary::IS_METHOD;
+	if (flags & GI_FUNCTION_IS_CONSTRUCTOR)
+		summary.flags |= FunctionSummary::IS_CONSTRUCTOR;
+	if (flags & GI_FUNCTION_THROWS)
+		summary.flags |= FunctionSummary::THROWS;
+	if (g_base_info_is_deprecated (info))
+		summary.flags |= FunctionSummary::DEPRECATED;
 
-	for (gint i = 0; i < n_methods && f_info == NULL; i++) {
-		GIFunctionInfo *_info = g_object_info_get_method (info, i);
-		f_info = _find_function_in_function (_info, func_name);
-		g_base_info_unref (_info);
+	if (n_args > FunctionSummary::MAX_ARGS) {
+		DEBUG ("Not summarising arguments beyond " <<
+		       FunctionSummary::MAX_ARGS << " of " <<
+		       g_function_info_get_symbol (info) << "().");
+		summary.flags |= FunctionSummary::ARGS_TRUNCATED;
+		n_args = FunctionSummary::MAX_ARGS;
 	}
 
-	return f_info;
+	for (unsigned int j = 0; j < n_args; j++) {
+		TypelibReader::Arg arg;
+
+		_load_arg (callable_info, j, arg);
+		_summarise_arg (arg, j, summary);
+	}
+
+	/* Process the function’s return type. */
+	GITypeInfo return_type_info;
+	GITransfer return_transfer;
+
+	g_callable_info_load_return_type (callable_info, &return_type_info);
+	return_transfer = g_callable_info_get_caller_owns (callable_info);
+
+	summary.return_transfer = return_transfer;
+	if (_type_should_be_const (return_transfer,
+	                           g_type_info_get_tag (&return_type_info)))
+		summary.flags |= FunctionSummary::RETURN_SHOULD_BE_CONST;
 }
 
-/* Returns a reference to the #GIFunctionInfo, or %NULL. */
-static GIFunctionInfo *
-_find_function_in_interface (GIInterfaceInfo *info, const std::string &func_name)
+/* As _summarise_function(), but reading the function’s blobs in place. Returns
+ * %false if they are malformed. */
+static bool
+_summarise_typelib_function (const TypelibReader& reader,
+                             const TypelibReader::Function& function,
+                             FunctionSummary& summary)
 {
-	GIFunctionInfo *f_info = NULL;
-	gint n_methods = g_interface_info_get_n_methods (info);
+	unsigned int n_args = function.n_args;
+
+	memset (&summary, 0, sizeof (summary));
+	summary.n_args = n_args;
+
+	if (function.is_method)
+		summary.flags |= FunctionSummary::IS_METHOD;
+	if (function.is_constructor)
+		summary.flags |= FunctionSummary::IS_CONSTRUCTOR;
+	if (function.throws)
+		summary.flags |= FunctionSummary::THROWS;
+	if (function.deprecated)
+		summary.flags |= FunctionSummary::DEPRECATED;
 
-	for (gint i = 0; i < n_methods && f_info == NULL; i++) {
-		GIFunctionInfo *_info = g_interface_info_get_method (info, i);
-		f_info = _find_function_in_function (_info, func_name);
-		g_base_info_unref (_info);
+	if (n_args > FunctionSummary::MAX_ARGS) {
+		DEBUG ("Not summarising arguments beyond " <<
+		       FunctionSummary::MAX_ARGS << " of " <<
+		       function.symbol << "().");
+		summary.flags |= FunctionSummary::ARGS_TRUNCATED;
+		n_args = FunctionSummary::MAX_ARGS;
 	}
 
-	return f_info;
+	for (unsigned int j = 0; j < n_args; j++) {
+		TypelibReader::Arg arg;
+
+		if (!reader.get_arg (function, j, arg))
+			return false;
+
+		_summarise_arg (arg, j, summary);
+	}
+
+	summary.return_transfer = function.return_transfer;
+	if (_type_should_be_const (function.return_transfer,
+	                           function.return_type.tag))
+		summary.flags |= FunctionSummary::RETURN_SHOULD_BE_CONST;
+
+	return true;
 }
 
-/* Returns a reference to the #GIFunctionInfo, or %NULL. */
-static GIFunctionInfo *
-_find_function_in_union (GIUnionInfo *info, const std::string &func_name)
+/* Summarise @entry’s function if that hasn’t already been done. Must be called
+ * with the lock held. */
+const FunctionSummary&
+GirManager::_summarise_entry (IndexEntry& entry)
 {
-	GIFunctionInfo *f_info = NULL;
-	gint n_methods = g_union_info_get_n_methods (info);
+	if (!entry.summarised.load (std::memory_order_relaxed)) {
+		_summarise_function (entry.info, entry.summary);
+		entry.summarised.store (true, std::memory_order_release);
+	}
+
+	return entry.summary;
+}
+
+/* Write the GIR cache for @r, which must have been indexed from its typelib,
+ * either in place or by loading it. Failure to write the cache is not fatal, as
+ * it will be retried by the next compiler invocation. Must be called with the
+ * lock held. */
+void
+GirManager::_write_cache (Nspace& r) const
+{
+	GirCache::Stamp stamp;
+	GError *error = NULL;
+	std::vector<GirCache::Entry> entries;
+
+	if ((r.blob_index == nullptr && r.typelib == NULL) ||
+	    !GirCache::stamp (r.typelib_path, stamp))
+		return;
+
+	if (r.blob_index != nullptr) {
+		entries.reserve (r.blob_index->size ());
+
+		for (BlobIndex::const_iterator it = r.blob_index->begin (),
+		     ie = r.blob_index->end (); it != ie; ++it) {
+			entries.push_back (GirCache::Entry (it->symbol.str (),
+			                                    it->summary));
+		}
+	} else {
+		GIIndex *index = r.gi_index.load (std::memory_order_relaxed);
+
+		entries.reserve (index->functions.size ());
+
+		for (llvm::StringMap<IndexEntry>::iterator it =
+		     index->functions.begin (), ie = index->functions.end ();
+		     it != ie; ++it) {
+			llvm::StringRef symbol = it->getKey ();
+			const FunctionSummary& summary =
+				_summarise_entry (it->second);
 
-	for (gint i = 0; i < n_methods && f_info == NULL; i++) {
-		GIFunctionInfo *_info = g_union_info_get_method (info, i);
-		f_info = _find_function_in_function (_info, func_name);
-		g_base_info_unref (_info);
+			entries.push_back (GirCache::Entry (symbol.str (),
+			                                    summary));
+		}
 	}
 
-	return f_info;
+	if (g_mkdir_with_parents (this->_cache_dir.c_str (), 0755) != 0 ||
+	    !GirCache::write (_cache_path (this->_cache_dir, r), r.typelib_path,
+	                      stamp, entries, &error)) {
+		WARN ("Failed to write GIR cache for ‘" << r.nspace <<
+		      "’ (version " << r.version << ") in " <<
+		      this->_cache_dir <<
+		      ((error != NULL) ? ": " : "") <<
+		      ((error != NULL) ? error->message : ""));
+	} else {
+		tartan::Stats& stats = tartan::Stats::current ();
+
+		stats.count (stats.gir_cache_writes);
+	}
+
+	g_clear_error (&error);
+}
+
+/* Check whether @func_name can belong to the namespace with the given
+ * lower-case C prefix.
+ * e.g. g_irepository_find_by_name → (g_irepository_, find_by_name). */
+static bool
+_function_matches_prefix (llvm::StringRef func_name,
+                          llvm::StringRef c_prefix_lower)
+{
+	return (c_prefix_lower.empty () ||
+	        (func_name.size () > c_prefix_lower.size () &&
+	         func_name.substr (0, c_prefix_lower.size ()) ==
+	         c_prefix_lower &&
+	         func_name[c_prefix_lower.size ()] == '_'));
+}
+
+/* Check whether @type_name can belong to the namespace with the given C
+ * prefix. e.g. GObject → (G, Object). */
+static bool
+_type_matches_prefix (llvm::StringRef type_name, llvm::StringRef c_prefix)
+{
+	return (c_prefix.empty () ||
+	        (type_name.size () > c_prefix.size () &&
+	         type_name.substr (0, c_prefix.size ()) == c_prefix));
 }
 
-/* Try to find typelib information about the function.
+static bool
+_is_gtype_info (GIBaseInfo *info)
+{
+	return (g_base_info_get_type (info) == GI_INFO_TYPE_OBJECT ||
+	        g_base_info_get_type (info) == GI_INFO_TYPE_INTERFACE);
+}
+
+/* Add @info to the namespace’s function index under its C symbol, if it
+ * matches the namespace’s C prefix. The first info with a given symbol wins,
+ * matching the order of a linear scan over the namespace. */
+void
+GirManager::_index_function (const Nspace& r, GIIndex& index,
+                             GIFunctionInfo *info) const
+{
+	llvm::StringRef symbol (g_function_info_get_symbol (info));
+
+	if (!_function_matches_prefix (symbol, r.c_prefix_lower))
+		return;
+
+	if (index.functions.try_emplace (symbol, info).second)
+		g_base_info_ref (info);
+}
+
+/* Build the symbol → #GIFunctionInfo index for every function in the
+ * namespace, including the methods of every struct, enum, object, interface
+ * and union, and the name → #GIObjectInfo index of its types, then publish
+ * them. This is done once per namespace, so that find_function_info() and
+ * find_object_info() do not have to iterate over the entire typelib or use the
+ * #GIRepository for every lookup. Must be called with the lock held. */
+void
+GirManager::_index_namespace (Nspace& r) const
+{
+	GIIndex *index = new GIIndex ();
+	guint n_infos = g_irepository_get_n_infos (this->_repo,
+	                                           r.nspace.c_str ());
+
+	for (guint i = 0; i < n_infos; i++) {
+		GIBaseInfo *info;
+		gint n_methods;
+
+		info = g_irepository_get_info (this->_repo,
+		                               r.nspace.c_str (), i);
+
+		/* As with g_irepository_find_by_name(), the first type with a
+		 * given name wins. */
+		GIBaseInfo *type_info = _is_gtype_info (info) ? info : NULL;
+
+		if (index->types.try_emplace (g_base_info_get_name (info),
+		                              type_info).second &&
+		    type_info != NULL)
+			g_base_info_ref (type_info);
+
+		switch (g_base_info_get_type (info)) {
+		case GI_INFO_TYPE_FUNCTION:
+			this->_index_function (r, *index, info);
+			break;
+		case GI_INFO_TYPE_STRUCT:
+			n_methods = g_struct_info_get_n_methods (info);
+
+			for (gint j = 0; j < n_methods; j++) {
+				GIFunctionInfo *_info =
+					g_struct_info_get_method (info, j);
+				this->_index_function (r, *index, _info);
+				g_base_info_unref (_info);
+			}
+
+			break;
+		case GI_INFO_TYPE_ENUM:
+			n_methods = g_enum_info_get_n_methods (info);
+
+			for (gint j = 0; j < n_methods; j++) {
+				GIFunctionInfo *_info =
+					g_enum_info_get_method (info, j);
+				this->_index_function (r, *index, _info);
+				g_base_info_unref (_info);
+			}
+
+			break;
+		case GI_INFO_TYPE_OBJECT:
+			n_methods = g_object_info_get_n_methods (info);
+
+			for (gint j = 0; j < n_methods; j++) {
+				GIFunctionInfo *_info =
+					g_object_info_get_method (info, j);
+				this->_index_function (r, *index, _info);
+				g_base_info_unref (_info);
+			}
+
+			break;
+		case GI_INFO_TYPE_INTERFACE:
+			n_methods = g_interface_info_get_n_methods (info);
+
+			for (gint j = 0; j < n_methods; j++) {
+				GIFunctionInfo *_info =
+					g_interface_info_get_method (info, j);
+				this->_index_function (r, *index, _info);
+				g_base_info_unref (_info);
+			}
+
+			break;
+		case GI_INFO_TYPE_UNION:
+			n_methods = g_union_info_get_n_methods (info);
+
+			for (gint j = 0; j < n_methods; j++) {
+				GIFunctionInfo *_info =
+					g_union_info_get_method (info, j);
+				this->_index_function (r, *index, _info);
+				g_base_info_unref (_info);
+			}
+
+			break;
+		case GI_INFO_TYPE_INVALID:
+		case GI_INFO_TYPE_CALLBACK:
+		case GI_INFO_TYPE_BOXED:
+		case GI_INFO_TYPE_FLAGS:
+		case GI_INFO_TYPE_CONSTANT:
+		case GI_INFO_TYPE_INVALID_0:
+		case GI_INFO_TYPE_VALUE:
+		case GI_INFO_TYPE_SIGNAL:
+		case GI_INFO_TYPE_VFUNC:
+		case GI_INFO_TYPE_PROPERTY:
+		case GI_INFO_TYPE_FIELD:
+		case GI_INFO_TYPE_ARG:
+		case GI_INFO_TYPE_TYPE:
+		case GI_INFO_TYPE_UNRESOLVED:
+		default:
+			/* Doesn’t have methods — ignore. */
+			break;
+		}
+
+		g_base_info_unref (info);
+	}
+
+	r.gi_index.store (index, std::memory_order_release);
+}
+
+bool
+GirManager::_blob_entry_is_less (const BlobEntry& a, const BlobEntry& b)
+{
+	return a.symbol < b.symbol;
+}
+
+bool
+GirManager::_blob_entry_has_same_symbol (const BlobEntry& a,
+                                         const BlobEntry& b)
+{
+	return a.symbol == b.symbol;
+}
+
+bool
+GirManager::_blob_entry_is_before (const BlobEntry& entry,
+                                   llvm::StringRef symbol)
+{
+	return entry.symbol < symbol;
+}
+
+/* Build the symbol → #FunctionSummary index for every function in a typelib,
+ * including the methods of every struct, enum, object, interface and union, by
+ * reading the typelib in place. This visits functions in the same order as
+ * _index_namespace(), but nothing is allocated per function: the symbols point
+ * into the mapped typelib, and the index is a single sorted array. It doesn’t
+ * use the #GIRepository, so can be called without the lock held. Returns
+ * %false if the typelib is malformed. */
+bool
+GirManager::_index_typelib (const TypelibReader& reader,
+                            const std::string& c_prefix_lower,
+                            BlobIndex& blob_index)
+{
+	unsigned int n_entries = reader.get_n_entries ();
+
+	for (unsigned int i = 0; i < n_entries; i++) {
+		GIInfoType type;
+		guint32 offset, first_method;
+		unsigned int n_methods;
+
+		if (!reader.get_entry (i, type, offset))
+			return false;
+
+		if (type == GI_INFO_TYPE_FUNCTION) {
+			if (!_index_typelib_function (reader, offset, false,
+			                              c_prefix_lower,
+			                              blob_index))
+				return false;
+
+			continue;
+		}
+
+		if (!reader.get_methods (type, offset, first_method, n_methods))
+			return false;
+
+		for (unsigned int j = 0; j < n_methods; j++) {
+			guint32 method_offset =
+				reader.get_method_offset (first_method, j);
+
+			if (!_index_typelib_function (reader, method_offset,
+			                              true, c_prefix_lower,
+			                              blob_index))
+				return false;
+		}
+	}
+
+	/* As in _index_function(), the first function with a given symbol
+	 * wins. */
+	std::stable_sort (blob_index.begin (), blob_index.end (),
+	                  _blob_entry_is_less);
+	blob_index.erase (std::unique (blob_index.begin (), blob_index.end (),
+	                               _blob_entry_has_same_symbol),
+	                  blob_index.end ());
+
+	return true;
+}
+
+/* Summarise the function blob at @offset into @blob_index, if it matches the
+ * namespace’s C prefix. */
+bool
+GirManager::_index_typelib_function (const TypelibReader& reader,
+                                     guint32 offset,
+                                     bool has_container,
+                                     const std::string& c_prefix_lower,
+                                     BlobIndex& blob_index)
+{
+	TypelibReader::Function function;
+
+	if (!reader.get_function (offset, has_container, function))
+		return false;
+
+	if (!_function_matches_prefix (function.symbol, c_prefix_lower))
+		return true;
+
+	blob_index.push_back (BlobEntry ());
+	blob_index.back ().symbol = function.symbol;
+
+	return _summarise_typelib_function (reader, function,
+	                                    blob_index.back ().summary);
+}
+
+const FunctionSummary*
+GirManager::_blob_index_lookup (const BlobIndex& index,
+                                llvm::StringRef symbol)
+{
+	BlobIndex::const_iterator it =
+		std::lower_bound (index.begin (), index.end (), symbol,
+		                  _blob_entry_is_before);
+
+	if (it == index.end () || it->symbol != symbol)
+		return NULL;
+
+	return &it->summary;
+}
+
+/* Try to find typelib information about the function. Namespaces are searched
+ * in the order they were loaded or registered, and lazily loaded as needed.
+ * This always needs the typelib, so callers which only need the function’s
+ * annotations should use find_function_summary() instead.
  * Note: This returns a reference which needs freeing using
  * g_base_info_unref(). */
 GIBaseInfo*
-GirManager::find_function_info (const std::string& func_name) const
+GirManager::find_function_info (llvm::StringRef func_name) const
+{
+	tartan::Stats& stats = tartan::Stats::current ();
+
+	if (!stats.enabled)
+		return this->_find_function_info (func_name);
+
+	guint64 start = tartan::Stats::now ();
+	GIBaseInfo *info = this->_find_function_info (func_name);
+	stats.find_function_info.add (tartan::Stats::now () - start,
+	                              info != NULL);
+
+	return info;
+}
+
+GIBaseInfo*
+GirManager::_find_function_info (llvm::StringRef func_name) const
 {
+	std::shared_ptr<const NspaceList> nspaces = this->_current_nspaces ();
 	GIBaseInfo *info = NULL;
 
-	for (std::vector<Nspace>::const_iterator it = this->_typelibs.begin (),
-	     ie = this->_typelibs.end (); it != ie && info == NULL; ++it) {
-		const Nspace r = *it;
-
-		/* Check the function matches this namespace.
-		 * e.g. g_irepository_find_by_name →
-		 *      (g_irepository_, find_by_name). */
-		if (!r.c_prefix_lower.empty () &&
-		    (func_name.size () <= r.c_prefix_lower.size () ||
-		     func_name.compare (0, r.c_prefix_lower.size (),
-		                        r.c_prefix_lower) != 0 ||
-		     func_name[r.c_prefix_lower.size ()] != '_')) {
+	for (std::vector<Nspace*>::const_iterator it =
+	     nspaces->by_registration.begin (),
+	     ie = nspaces->by_registration.end ();
+	     it != ie && info == NULL; ++it) {
+		Nspace& r = **it;
+
+		if (!_function_matches_prefix (func_name, r.c_prefix_lower))
 			continue;
-		}
 
-		/* Iterate through every info in the namespace, trying to match
-		 * the entire @func_name against the info, or one of the methods
-		 * it contains. */
-		guint n_infos = g_irepository_get_n_infos (this->_repo,
-		                                           r.nspace.c_str ());
-
-		for (guint i = 0; i < n_infos && info == NULL; i++) {
-			GIBaseInfo *_info;
-
-			_info = g_irepository_get_info (this->_repo,
-			                                r.nspace.c_str (), i);
-
-			switch (g_base_info_get_type (_info)) {
-			case GI_INFO_TYPE_FUNCTION:
-				info = _find_function_in_function (_info,
-				                                   func_name);
-				break;
-			case GI_INFO_TYPE_STRUCT:
-				info = _find_function_in_struct (_info,
-				                                 func_name);
-				break;
-			case GI_INFO_TYPE_ENUM:
-				info = _find_function_in_enum (_info,
-				                               func_name);
-				break;
-			case GI_INFO_TYPE_OBJECT:
-				info = _find_function_in_object (_info,
-				                                 func_name);
-				break;
-			case GI_INFO_TYPE_INTERFACE:
-				info = _find_function_in_interface (_info,
-				                                    func_name);
-				break;
-			case GI_INFO_TYPE_UNION:
-				info = _find_function_in_union (_info,
-				                                func_name);
-				break;
-			case GI_INFO_TYPE_INVALID:
-			case GI_INFO_TYPE_CALLBACK:
-			case GI_INFO_TYPE_BOXED:
-			case GI_INFO_TYPE_FLAGS:
-			case GI_INFO_TYPE_CONSTANT:
-			case GI_INFO_TYPE_INVALID_0:
-			case GI_INFO_TYPE_VALUE:
-			case GI_INFO_TYPE_SIGNAL:
-			case GI_INFO_TYPE_VFUNC:
-			case GI_INFO_TYPE_PROPERTY:
-			case GI_INFO_TYPE_FIELD:
-			case GI_INFO_TYPE_ARG:
-			case GI_INFO_TYPE_TYPE:
-			case GI_INFO_TYPE_UNRESOLVED:
-			default:
-				/* Doesn’t have methods — ignore. */
-				break;
-			}
+		/* The GIR cache and the in-place index list every function in
+		 * the namespace, so the typelib only needs loading if the
+		 * function is in it. */
+		this->_ensure_loaded (r);
 
-			g_base_info_unref (_info);
-		}
+		if ((r.cache != nullptr &&
+		     r.cache->lookup (func_name) == NULL) ||
+		    (r.blob_index != nullptr &&
+		     _blob_index_lookup (*r.blob_index, func_name) == NULL))
+			continue;
+
+		GIIndex *index = this->_require_gi_index (r);
+
+		if (index == NULL)
+			continue;
+
+		llvm::StringMap<IndexEntry>::const_iterator f =
+			index->functions.find (func_name);
+		if (f != index->functions.end ())
+			info = g_base_info_ref (f->second.info);
 	}
 
 	/* Double-check that this isn’t a shadowed function, since the parameter
@@ -253,65 +1227,239 @@ GirManager::find_function_info (const std::string& func_name) const
 	return info;
 }
 
+/* Find the annotation summary for the function, using the GIR cache if
+ * possible, or the typelib otherwise. The returned pointer is valid for the
+ * lifetime of the #GirManager. Returns %NULL if the function isn’t in any
+ * namespace. This only takes the lock if it has to load a namespace or
+ * summarise the function. */
+const FunctionSummary*
+GirManager::find_function_summary (llvm::StringRef func_name) const
+{
+	tartan::Stats& stats = tartan::Stats::current ();
+
+	if (!stats.enabled)
+		return this->_find_function_summary (func_name);
+
+	guint64 start = tartan::Stats::now ();
+	const FunctionSummary *summary =
+		this->_find_function_summary (func_name);
+	stats.find_function_summary.add (tartan::Stats::now () - start,
+	                                 summary != NULL);
+
+	return summary;
+}
+
+const FunctionSummary*
+GirManager::_find_function_summary (llvm::StringRef func_name) const
+{
+	std::shared_ptr<const NspaceList> nspaces = this->_current_nspaces ();
+
+	for (std::vector<Nspace*>::const_iterator it =
+	     nspaces->by_registration.begin (),
+	     ie = nspaces->by_registration.end (); it != ie; ++it) {
+		Nspace& r = **it;
+
+		if (!_function_matches_prefix (func_name, r.c_prefix_lower))
+			continue;
+
+		this->_ensure_loaded (r);
+
+		if (r.cache != nullptr) {
+			const FunctionSummary *summary =
+				r.cache->lookup (func_name);
+
+			if (summary != NULL)
+				return summary;
+
+			continue;
+		}
+
+		if (r.blob_index != nullptr) {
+			const FunctionSummary *summary =
+				_blob_index_lookup (*r.blob_index, func_name);
+
+			if (summary != NULL)
+				return summary;
+
+			continue;
+		}
+
+		GIIndex *index = r.gi_index.load (std::memory_order_acquire);
+
+		if (index == NULL)
+			continue;
+
+		llvm::StringMap<IndexEntry>::iterator f =
+			index->functions.find (func_name);
+		if (f == index->functions.end ())
+			continue;
+
+		IndexEntry& entry = f->second;
+
+		if (!entry.summarised.load (std::memory_order_acquire)) {
+			std::lock_guard<std::mutex> lock (this->_mutex);
+
+			/* As in find_function_info(), double-check the
+			 * info. */
+			assert (g_base_info_get_type (entry.info) ==
+			        GI_INFO_TYPE_FUNCTION);
+
+			_summarise_entry (entry);
+		}
+
+		return &entry.summary;
+	}
+
+	return NULL;
+}
+
+/* Get the #FunctionSummary::ArgFlags for the @arg-th argument (counted as in
+ * #FunctionSummary) of the function @func_name, whose summary is @summary.
+ * Annotations on arguments beyond FunctionSummary::MAX_ARGS aren’t in the
+ * summary, so are read from the typelib, loading it if needed. */
+unsigned int
+GirManager::get_arg_flags (llvm::StringRef func_name,
+                           const FunctionSummary& summary,
+                           unsigned int arg) const
+{
+	if (arg < FunctionSummary::MAX_ARGS ||
+	    !summary.has_flag (FunctionSummary::ARGS_TRUNCATED))
+		return summary.arg_flags (arg);
+
+	if (arg >= summary.n_args)
+		return 0;
+
+	GIBaseInfo *info = this->find_function_info (func_name);
+
+	if (info == NULL)
+		return 0;
+
+	std::lock_guard<std::mutex> lock (this->_mutex);
+	TypelibReader::Arg arg_info;
+
+	_load_arg ((GICallableInfo *) info, arg, arg_info);
+	g_base_info_unref (info);
+
+	return _arg_flags (arg_info);
+}
+
 /* Try to find typelib information about the type. The type could be a GObject
- * or a GInterface.
+ * or a GInterface. Results, including misses, are cached.
  *
  * Note: This returns a reference which needs freeing using
  * g_base_info_unref(). The GIBaseInfo* is guaranteed to be a valid
  * GIObjectInfo*. */
 GIBaseInfo*
-GirManager::find_object_info (const std::string& type_name) const
+GirManager::find_object_info (llvm::StringRef type_name) const
 {
-	GIBaseInfo *info = NULL;
-	std::string type_name_stripped;
+	tartan::Stats& stats = tartan::Stats::current ();
 
-	for (std::vector<Nspace>::const_iterator it = this->_typelibs.begin (),
-	     ie = this->_typelibs.end (); it != ie; ++it) {
-		const Nspace r = *it;
+	if (!stats.enabled)
+		return this->_find_object_info (type_name);
 
-		/* The type_name includes the namespace, which needs stripping.
-		 * e.g. GObject → Object. */
-		if (!r.c_prefix.empty () &&
-		    type_name.size () > r.c_prefix.size () &&
-		    type_name.compare (0, r.c_prefix.size (),
-		                       r.c_prefix) == 0) {
-			size_t prefix_len = r.c_prefix.size ();
-			type_name_stripped = type_name.substr (prefix_len);
-		} else if (r.c_prefix.empty ()) {
-			type_name_stripped = type_name;
-		} else {
-			continue;
-		}
+	guint64 start = tartan::Stats::now ();
+	GIBaseInfo *info = this->_find_object_info (type_name);
+	stats.find_object_info.add (tartan::Stats::now () - start,
+	                            info != NULL);
 
-		info = g_irepository_find_by_name (this->_repo,
-		                                   r.nspace.c_str (),
-		                                   type_name_stripped.c_str ());
+	return info;
+}
 
-		if (info != NULL) {
-			/* Successfully found an entry in the typelib. */
-			break;
+GIBaseInfo*
+GirManager::_find_object_info (llvm::StringRef type_name) const
+{
+	unsigned int generation;
+
+	{
+		std::lock_guard<std::mutex> lock (this->_object_cache_mutex);
+		llvm::StringMap<GIBaseInfo*>::const_iterator it =
+			this->_object_cache.find (type_name);
+
+		if (it != this->_object_cache.end ()) {
+			tartan::Stats& stats = tartan::Stats::current ();
+			stats.count (stats.object_info_cache_hits);
+			return (it->second != NULL) ?
+			       g_base_info_ref (it->second) : NULL;
 		}
+
+		generation = this->_object_cache_generation;
 	}
 
-	/* Check it is actually a GObject. */
-	if (info != NULL &&
-	    g_base_info_get_type (info) != GI_INFO_TYPE_OBJECT &&
-	    g_base_info_get_type (info) != GI_INFO_TYPE_INTERFACE) {
-		DEBUG ("Ignoring type " << type_name << " as its GI info "
-		       "indicates it’s not a GObject.");
+	GIBaseInfo *info = this->_look_up_object_info (type_name);
 
-		g_base_info_unref (info);
-		info = NULL;
+	std::lock_guard<std::mutex> lock (this->_object_cache_mutex);
+
+	/* Don’t cache the result if a namespace was added in the meantime, as
+	 * it may now be wrong. If another thread looked the type up at the
+	 * same time, keep its result. */
+	if (generation == this->_object_cache_generation) {
+		std::pair<llvm::StringMap<GIBaseInfo*>::iterator, bool> inserted =
+			this->_object_cache.try_emplace (type_name, info);
+
+		if (!inserted.second) {
+			if (info != NULL)
+				g_base_info_unref (info);
+			info = inserted.first->second;
+		}
+
+		return (info != NULL) ? g_base_info_ref (info) : NULL;
 	}
 
 	return info;
 }
 
+/* Uncached implementation of find_object_info(). Namespaces are searched in
+ * order of decreasing C prefix length, so a type is looked up in the most
+ * specific namespace first (e.g. GtkWidget in Gtk, rather than GLib), and less
+ * specific namespaces are only loaded if needed. This only takes the lock if
+ * it has to load a namespace. */
+GIBaseInfo*
+GirManager::_look_up_object_info (llvm::StringRef type_name) const
+{
+	std::shared_ptr<const NspaceList> nspaces = this->_current_nspaces ();
+
+	for (std::vector<Nspace*>::const_iterator it =
+	     nspaces->by_c_prefix.begin (), ie = nspaces->by_c_prefix.end ();
+	     it != ie; ++it) {
+		Nspace& r = **it;
+
+		/* The type_name includes the namespace, which needs stripping.
+		 * e.g. GObject → Object. */
+		if (!_type_matches_prefix (type_name, r.c_prefix))
+			continue;
+
+		const GIIndex *index = this->_require_gi_index (r);
+
+		if (index == NULL)
+			continue;
+
+		llvm::StringRef name = type_name.substr (r.c_prefix.size ());
+		llvm::StringMap<GIBaseInfo*>::const_iterator t =
+			index->types.find (name);
+
+		if (t == index->types.end ())
+			continue;
+
+		/* Successfully found an entry in the typelib. Check it is
+		 * actually a GObject. */
+		if (t->second == NULL) {
+			DEBUG ("Ignoring type " << type_name << " as its GI "
+			       "info indicates it’s not a GObject.");
+			return NULL;
+		}
+
+		return g_base_info_ref (t->second);
+	}
+
+	return NULL;
+}
+
 /* Return the full C name of a type. For example, this is ‘GObject’ for a
  * GObject. The prefix in this case is ‘G’ and the symbol name is ‘Object’. */
 std::string
 GirManager::get_c_name_for_type (GIBaseInfo *base_info) const
 {
+	std::lock_guard<std::mutex> lock (this->_mutex);
 	std::string symbol_name (g_base_info_get_name (base_info));
 	const gchar *c_prefix = g_irepository_get_c_prefix (this->_repo,
 	                                                    g_base_info_get_namespace (base_info));
@@ -322,3 +1470,164 @@ GirManager::get_c_name_for_type (GIBaseInfo *base_info) const
 		return std::string (c_prefix) + symbol_name;
 	}
 }
+
+static void
+_bitset_set (std::vector<bool>& bitset, unsigned int i)
+{
+	if (i >= bitset.size ())
+		bitset.resize (i + 1);
+	bitset[i] = true;
+}
+
+static bool
+_bitset_test (const std::vector<bool>& bitset, unsigned int i)
+{
+	return (i < bitset.size () && bitset[i]);
+}
+
+static void
+_bitset_union (std::vector<bool>& bitset, const std::vector<bool>& other)
+{
+	if (other.size () > bitset.size ())
+		bitset.resize (other.size ());
+	for (size_t i = 0; i < other.size (); i++) {
+		if (other[i])
+			bitset[i] = true;
+	}
+}
+
+/* Get the hierarchy index node for @info, which must be a #GIObjectInfo or a
+ * #GIInterfaceInfo, adding it (and its ancestors, interfaces and
+ * prerequisites) to the index if needed. Must be called with the lock held.
+ *
+ * Parents, interfaces and prerequisites from namespaces which aren’t loaded
+ * can’t be resolved, so are ignored. */
+const GirManager::GTypeNode*
+GirManager::_hierarchy_node (GIBaseInfo *info) const
+{
+	std::string name = std::string (g_base_info_get_namespace (info)) +
+	                   "." + g_base_info_get_name (info);
+	std::unordered_map<std::string, std::unique_ptr<GTypeNode>>::const_iterator it =
+		this->_hierarchy.find (name);
+
+	if (it != this->_hierarchy.end ())
+		return it->second.get ();
+
+	GTypeNode *node = new GTypeNode ();
+	this->_hierarchy.emplace (name, std::unique_ptr<GTypeNode> (node));
+
+	node->id = this->_hierarchy.size () - 1;
+	node->is_interface =
+		(g_base_info_get_type (info) == GI_INFO_TYPE_INTERFACE);
+	node->is_gobject = (name == "GObject.Object");
+	node->interface_index = 0;
+
+	if (node->is_interface) {
+		node->interface_index = this->_n_hierarchy_interfaces++;
+
+		for (gint i = 0; i < g_interface_info_get_n_prerequisites (info); i++) {
+			GIBaseInfo *prereq =
+				g_interface_info_get_prerequisite (info, i);
+
+			if (_is_gtype_info (prereq)) {
+				const GTypeNode *p = this->_hierarchy_node (prereq);
+
+				if (p->is_interface) {
+					_bitset_union (node->prerequisite_classes,
+					               p->prerequisite_classes);
+				} else {
+					for (std::vector<const GTypeNode*>::const_iterator a =
+					     p->ancestors.begin ();
+					     a != p->ancestors.end (); ++a)
+						_bitset_set (node->prerequisite_classes,
+						             (*a)->id);
+				}
+			}
+
+			g_base_info_unref (prereq);
+		}
+
+		return node;
+	}
+
+	GIObjectInfo *parent = g_object_info_get_parent (info);
+
+	if (parent != NULL) {
+		if (_is_gtype_info (parent)) {
+			const GTypeNode *p = this->_hierarchy_node (parent);
+
+			node->ancestors = p->ancestors;
+			node->interfaces = p->interfaces;
+		}
+
+		g_base_info_unref (parent);
+	}
+
+	node->ancestors.push_back (node);
+
+	for (gint i = 0; i < g_object_info_get_n_interfaces (info); i++) {
+		GIInterfaceInfo *iface = g_object_info_get_interface (info, i);
+
+		if (_is_gtype_info (iface)) {
+			_bitset_set (node->interfaces,
+			             this->_hierarchy_node (iface)->interface_index);
+		}
+
+		g_base_info_unref (iface);
+	}
+
+	return node;
+}
+
+/* Returns true iff
+ *  • @a is a GObject, @b is a GObject, and @a is equal to or a subclass of @b;
+ *  • @a is a GInterface, @b is a GInterface, and @a is equal to @b;
+ *  • @a is a GInterface, @b is a GObject, and at least one of @a’s
+ *    prerequisites is equal to or a subtype of @b;
+ *  • @a is a GObject, @b is a GInterface, and @a or one of its superclasses
+ *    implements @b.
+ *
+ * Note that prerequisites may be classes or interfaces, and all interfaces have
+ * GObject as an implicit prerequisite.
+ *
+ * Each type’s ancestors, implemented interfaces and prerequisites are indexed
+ * the first time it’s queried, so this takes constant time afterwards. The
+ * index only grows, so it doesn’t need rebuilding when namespaces are loaded
+ * lazily. */
+bool
+GirManager::is_gtype_subclass (GIBaseInfo *a, GIBaseInfo *b) const
+{
+	std::lock_guard<std::mutex> lock (this->_mutex);
+
+	assert (_is_gtype_info (a));
+	assert (_is_gtype_info (b));
+
+	DEBUG ("Checking whether " << g_base_info_get_name (a) << " is a "
+	       "subtype of " << g_base_info_get_name (b) << ".");
+
+	const GTypeNode *node_a = this->_hierarchy_node (a);
+	const GTypeNode *node_b = this->_hierarchy_node (b);
+
+	/* The case where @a and @b are equal. */
+	if (node_a == node_b)
+		return true;
+
+	/* The case where @a is a subclass of @b. */
+	if (!node_a->is_interface && !node_b->is_interface) {
+		size_t depth = node_b->ancestors.size ();
+
+		return (depth > 0 && depth <= node_a->ancestors.size () &&
+		        node_a->ancestors[depth - 1] == node_b);
+	}
+
+	/* The case where @a or one of its superclasses implements @b. */
+	if (!node_a->is_interface && node_b->is_interface)
+		return _bitset_test (node_a->interfaces, node_b->interface_index);
+
+	/* The case where one of @a’s prerequisites is a subtype of @b. */
+	if (node_a->is_interface && !node_b->is_interface)
+		return (node_b->is_gobject ||
+		        _bitset_test (node_a->prerequisite_classes, node_b->id));
+
+	return false;
+}
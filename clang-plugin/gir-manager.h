@@ -23,13 +23,159 @@
 #ifndef TARTAN_GIR_MANAGER_H
 #define TARTAN_GIR_MANAGER_H
 
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <girepository.h>
 
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringRef.h>
+
+class GirCache;
+class TypelibReader;
+
+namespace tartan {
+class Stats;
+}
+
+/* Compact summary of the GIR annotations on a function: everything the
+ * annotaters and checkers need, so that they don’t have to introspect the
+ * #GIFunctionInfo for each declaration. The argument bitsets are indexed by GI
+ * argument index, i.e. not counting the instance parameter of a method or the
+ * trailing #GError parameter of a throwing function.
+ *
+ * This is stored verbatim in the GIR cache, so must remain a POD type; bump
+ * the cache format version if its layout changes. */
+struct FunctionSummary {
+	enum Flags {
+		/* Has a container and %GI_FUNCTION_IS_METHOD is set. */
+		IS_METHOD = 1 << 0,
+		IS_CONSTRUCTOR = 1 << 1,
+		THROWS = 1 << 2,
+		DEPRECATED = 1 << 3,
+		/* The return type is (transfer none) and should be const. */
+		RETURN_SHOULD_BE_CONST = 1 << 4,
+		/* There are more than MAX_ARGS arguments, so the annotations
+		 * on the rest have to be read from the typelib. */
+		ARGS_TRUNCATED = 1 << 5,
+	};
+
+	/* Annotations on a single argument. */
+	enum ArgFlags {
+		ARG_NONNULL = 1 << 0,
+		ARG_NULLABLE = 1 << 1,
+		ARG_OUT = 1 << 2,
+		ARG_SHOULD_BE_CONST = 1 << 3,
+	};
+
+	/* Arguments beyond this have no annotations recorded; use
+	 * GirManager::get_arg_flags() to look them up. */
+	static const unsigned int MAX_ARGS = 64;
+
+	guint32 flags;
+	guint16 n_args;
+	guint8 return_transfer;  /* GITransfer */
+	guint8 reserved;
+
+	guint64 nonnull_args;  /* definitely required to be non-NULL */
+	guint64 nullable_args;  /* (nullable) or (optional) */
+	guint64 out_args;  /* (out) or (inout) */
+	guint64 const_args;  /* (transfer none) and should be const */
+
+	bool has_flag (Flags flag) const { return (this->flags & flag) != 0; }
+
+	static bool
+	arg_bit (guint64 bits, unsigned int arg)
+	{
+		return (arg < MAX_ARGS && ((bits >> arg) & 1) != 0);
+	}
+
+	bool arg_is_nonnull (unsigned int arg) const
+		{ return arg_bit (this->nonnull_args, arg); }
+	bool arg_is_nullable (unsigned int arg) const
+		{ return arg_bit (this->nullable_args, arg); }
+	bool arg_is_out (unsigned int arg) const
+		{ return arg_bit (this->out_args, arg); }
+	bool arg_should_be_const (unsigned int arg) const
+		{ return arg_bit (this->const_args, arg); }
+
+	unsigned int
+	arg_flags (unsigned int arg) const
+	{
+		return (this->arg_is_nonnull (arg) ? ARG_NONNULL : 0) |
+		       (this->arg_is_nullable (arg) ? ARG_NULLABLE : 0) |
+		       (this->arg_is_out (arg) ? ARG_OUT : 0) |
+		       (this->arg_should_be_const (arg) ?
+		        ARG_SHOULD_BE_CONST : 0);
+	}
+
+	/* Number of C formal parameters the function should have. */
+	unsigned int
+	n_c_params () const
+	{
+		return this->n_args +
+		       (this->has_flag (IS_METHOD) ? 1 : 0) +
+		       (this->has_flag (THROWS) ? 1 : 0);
+	}
+};
+
+/* The GirManager is shared by every translation unit in the process, and may be
+ * used from several threads at once. Function and object lookups don’t lock
+ * once their namespace has been loaded: the list of namespaces is an immutable
+ * snapshot which is replaced whenever a namespace is added, and each
+ * namespace’s indexes are only published once they are complete. Everything
+ * else which uses the #GIRepository is serialised by a single lock. */
 class GirManager {
 private:
+	struct IndexEntry {
+		GIFunctionInfo *info;  /* owned */
+
+		/* Computed the first time it’s needed, with the lock held. */
+		std::atomic<bool> summarised;
+		FunctionSummary summary;
+
+		explicit IndexEntry (GIFunctionInfo *_info) :
+			info (_info), summarised (false) {}
+	};
+
+	/* Summary of a function read directly from a typelib. @symbol
+	 * points into the mapped typelib. */
+	struct BlobEntry {
+		llvm::StringRef symbol;
+		FunctionSummary summary;
+	};
+
+	/* Sorted by symbol. */
+	typedef std::vector<BlobEntry> BlobIndex;
+
+	/* A namespace prepared by preload_namespaces() which hasn’t been
+	 * activated yet. */
+	struct PreparedNspace {
+		std::unique_ptr<GirCache> cache;
+		std::unique_ptr<BlobIndex> blob_index;
+	};
+
+	/* Indexes of a namespace’s typelib once it has been loaded into the
+	 * #GIRepository. Built with the lock held, and not modified once
+	 * published (apart from the lazily computed summaries), so lookups
+	 * read them without the lock. */
+	struct GIIndex {
+		/* C symbol → function info for all functions in the
+		 * namespace, including methods. */
+		llvm::StringMap<IndexEntry> functions;
+
+		/* Type name, without the C prefix → object or interface info,
+		 * or NULL if the type is something else. Each info holds a
+		 * reference. */
+		llvm::StringMap<GIBaseInfo*> types;
+
+		~GIIndex ();
+	};
+
 	struct Nspace {
 		/* All non-NULL. */
 		std::string nspace;
@@ -37,22 +183,187 @@ private:
 		std::string c_prefix_lower;
 		std::string c_prefix;
 
-		GITypelib* typelib;  /* unowned */
+		/* Path of the typelib file, and the typelib mapped for reading
+		 * in place, for namespaces which were registered rather than
+		 * loaded directly. Empty and NULL otherwise. */
+		std::string typelib_path;
+		std::unique_ptr<TypelibReader> reader;
+
+		/* Whether activating the namespace has been attempted: either
+		 * its cache has been mapped, or its typelib has been loaded.
+		 * Set once everything below is filled in. */
+		std::atomic<bool> loaded;
+
+		/* Error from activating the namespace in
+		 * preload_namespaces(), which hasn’t been reported yet, or
+		 * NULL. Owned; taken with the lock held. */
+		std::atomic<GError*> load_error;
+
+		/* Mapped GIR cache for the namespace, or NULL if caching is
+		 * disabled or the cache was missing or out of date. */
+		std::unique_ptr<GirCache> cache;
+
+		/* Summaries of all the functions in the namespace, read from
+		 * @reader, or NULL if @cache was mapped instead or the typelib
+		 * couldn’t be read in place. */
+		std::unique_ptr<BlobIndex> blob_index;
+
+		/* Whether loading the typelib into the #GIRepository has been
+		 * attempted. @typelib is NULL until then, or if that failed.
+		 * Set once @gi_index has been published. */
+		std::atomic<bool> required;
+		GITypelib* typelib;  /* unowned; only accessed with the lock */
+
+		/* Indexes of the loaded typelib, or NULL if it hasn’t been
+		 * loaded or loading it failed. Owned, and only accessed
+		 * atomically. */
+		std::atomic<GIIndex*> gi_index;
+
+		Nspace ();
+		~Nspace ();
+	};
+
+	/* Node in the index of the GObject class and GInterface hierarchy. */
+	struct GTypeNode {
+		unsigned int id;
+		bool is_interface;
+		bool is_gobject;  /* GObject.Object itself */
+		unsigned int interface_index;  /* interfaces only */
+
+		/* Classes only: the chain of classes from the root down to
+		 * this one, inclusive, so ancestors[d] is the ancestor at
+		 * depth d. */
+		std::vector<const GTypeNode*> ancestors;
+		/* Classes only: the interfaces this class or any of its
+		 * ancestors implements, indexed by @interface_index. */
+		std::vector<bool> interfaces;
+		/* Interfaces only: the classes which this interface’s
+		 * prerequisites are or derive from, indexed by @id. */
+		std::vector<bool> prerequisite_classes;
+	};
+
+	struct NspaceList {
+		/* In the order the namespaces were loaded or registered. */
+		std::vector<Nspace*> by_registration;
+
+		/* In the order to search them for a C type name: longest C
+		 * prefix first, and in registration order for equal
+		 * lengths. */
+		std::vector<Nspace*> by_c_prefix;
 	};
 
 	GIRepository* _repo;  /* unowned */
-	std::vector<Nspace> _typelibs;
+
+	/* Held while using @_repo, loading a namespace, or adding one. */
+	mutable std::mutex _mutex;
+
+	/* Directory to store GIR caches in; empty if caching is disabled. */
+	std::string _cache_dir;
+
+	/* All namespaces, in registration order. Only accessed with @_mutex
+	 * held; lookups use @_nspaces instead. */
+	std::vector<std::unique_ptr<Nspace>> _typelibs;
+
+	/* Current snapshot of @_typelibs. Only accessed atomically. Namespaces
+	 * which have been registered are loaded lazily, the first time a
+	 * symbol or type with their C prefix is looked up. */
+	std::shared_ptr<const NspaceList> _nspaces;
+
+	/* C type name → object or interface info, or NULL if the type is not
+	 * a known GObject or GInterface. Each info holds a reference. Cleared
+	 * whenever a namespace is added, which also bumps the generation so
+	 * that lookups which were in progress aren’t cached. */
+	mutable std::mutex _object_cache_mutex;
+	mutable llvm::StringMap<GIBaseInfo*> _object_cache;
+	mutable unsigned int _object_cache_generation;
+
+	/* Hierarchy index, built on demand as types are queried, keyed by the
+	 * type’s qualified name (e.g. ‘GObject.Object’). Only accessed with
+	 * @_mutex held. */
+	mutable std::unordered_map<std::string, std::unique_ptr<GTypeNode>> _hierarchy;
+	mutable unsigned int _n_hierarchy_interfaces;
+
+	bool _find_nspace (const std::string& gi_namespace,
+	                   const std::string& gi_version,
+	                   size_t& nspace_index) const;
+	bool _nspace_version_conflicts (const Nspace& r, GError** error) const;
+	std::shared_ptr<const NspaceList> _current_nspaces () const;
+	void _ensure_loaded (Nspace& r) const;
+	void _load_nspace (Nspace& r, GError** error) const;
+	static void _prepare_nspace (const Nspace& r,
+	                             const std::string& cache_dir,
+	                             tartan::Stats& stats,
+	                             std::unique_ptr<GirCache>& cache,
+	                             std::unique_ptr<BlobIndex>& blob_index);
+	void _activate_nspace (Nspace& r, std::unique_ptr<GirCache> cache,
+	                       std::unique_ptr<BlobIndex> blob_index,
+	                       tartan::Stats& stats, GError** error) const;
+	static void _prepare_nspaces (const std::vector<Nspace*>& nspaces,
+	                              const std::string& cache_dir,
+	                              std::atomic<size_t>& next,
+	                              std::vector<PreparedNspace>& prepared,
+	                              tartan::Stats& stats);
+	void _require_nspace (Nspace& r, GError** error) const;
+	GIIndex* _require_gi_index (Nspace& r) const;
+	void _load_namespace_locked (const std::string& gi_namespace,
+	                             const std::string& gi_version,
+	                             GError** error);
+	void _warn_load_error (const Nspace& r, GError *error) const;
+	void _index_namespace (Nspace& r) const;
+	void _index_function (const Nspace& r, GIIndex& index,
+	                      GIFunctionInfo *info) const;
+	static bool _index_typelib (const TypelibReader& reader,
+	                            const std::string& c_prefix_lower,
+	                            BlobIndex& blob_index);
+	static bool _index_typelib_function (const TypelibReader& reader,
+	                                     guint32 offset,
+	                                     bool has_container,
+	                                     const std::string& c_prefix_lower,
+	                                     BlobIndex& blob_index);
+	static bool _blob_entry_is_less (const BlobEntry& a,
+	                                 const BlobEntry& b);
+	static bool _blob_entry_has_same_symbol (const BlobEntry& a,
+	                                         const BlobEntry& b);
+	static bool _blob_entry_is_before (const BlobEntry& entry,
+	                                   llvm::StringRef symbol);
+	static const FunctionSummary* _blob_index_lookup (const BlobIndex& index,
+	                                                  llvm::StringRef symbol);
+	static const FunctionSummary& _summarise_entry (IndexEntry& entry);
+	static std::string _cache_path (const std::string& cache_dir,
+	                                const Nspace& r);
+	void _write_cache (Nspace& r) const;
+	void _add_nspace (std::unique_ptr<Nspace> r);
+	static bool _c_prefix_is_longer (const Nspace* a, const Nspace* b);
+	GIBaseInfo* _find_function_info (llvm::StringRef func_name) const;
+	const FunctionSummary* _find_function_summary (llvm::StringRef func_name) const;
+	GIBaseInfo* _find_object_info (llvm::StringRef type_name) const;
+	GIBaseInfo* _look_up_object_info (llvm::StringRef type_name) const;
+	const GTypeNode* _hierarchy_node (GIBaseInfo *info) const;
 
 public:
 	GirManager ();
+	~GirManager ();
+
+	void set_cache_dir (const std::string& cache_dir);
+	std::string get_cache_dir () const;
 
 	void load_namespace (const std::string& gi_namespace,
 	                     const std::string& gi_version,
 	                     GError** error);
+	void register_namespace (const std::string& gi_namespace,
+	                         const std::string& gi_version,
+	                         const std::string& typelib_path,
+	                         GError** error);
+	void preload_namespaces ();
 
-	GIBaseInfo* find_function_info (const std::string& func_name) const;
-	GIBaseInfo* find_object_info (const std::string& type_name) const;
+	GIBaseInfo* find_function_info (llvm::StringRef func_name) const;
+	const FunctionSummary* find_function_summary (llvm::StringRef func_name) const;
+	unsigned int get_arg_flags (llvm::StringRef func_name,
+	                            const FunctionSummary& summary,
+	                            unsigned int arg) const;
+	GIBaseInfo* find_object_info (llvm::StringRef type_name) const;
 	std::string get_c_name_for_type (GIBaseInfo *base_info) const;
+	bool is_gtype_subclass (GIBaseInfo *a, GIBaseInfo *b) const;
 };
 
 #endif /* !TARTAN_GIR_MANAGER_H */
@@ -115,23 +115,35 @@ static const SignalFuncInfo gsignal_connect_funcs[] = {
 };
 
 
+/* @connect_funcs maps the names of the gsignal_connect_funcs to their indices
+ * plus one. */
 static const SignalFuncInfo *
-_func_is_gsignal_connect (const FunctionDecl& func)
+_func_is_gsignal_connect (const FunctionDecl& func,
+                          const CalleeTable& connect_funcs)
 {
-	const std::string func_name = func.getNameAsString ();
-	guint i;
+	unsigned int i = connect_funcs.lookup (func);
 
-	/* Fast path elimination of irrelevant functions. */
-	if (func_name[0] != 'g')
+	if (i == 0)
 		return NULL;
 
-	for (i = 0; i < G_N_ELEMENTS (gsignal_connect_funcs); i++) {
-		if (func_name == gsignal_connect_funcs[i].func_name) {
-			return &gsignal_connect_funcs[i];
-		}
-	}
+	return &gsignal_connect_funcs[i - 1];
+}
 
-	return NULL;
+/* Get the name to look @type up in the GIR with, if it could be a GObject (or
+ * subclass, or a GInterface): i.e. if it is a typedef, such as ‘GObject’.
+ * Other types can’t be found in the GIR, so an empty string is returned for
+ * them. This doesn’t allocate. */
+static StringRef
+_gtype_name_for_type (QualType type)
+{
+	/* getAs<>() looks through the ElaboratedType (from LLVM 16) and
+	 * ParenType sugar around the typedef. */
+	const TypedefType *typedef_type = type->getAs<TypedefType> ();
+
+	if (typedef_type == NULL)
+		return StringRef ();
+
+	return typedef_type->getDecl ()->getName ();
 }
 
 /* If an expression is a reference to a GObject (or subclass, or a GInterface),
@@ -151,9 +163,11 @@ _expr_to_gtype (const Expr *expr,
 	}
 
 	/* We have the GObject pointee type, so try and resolve it. */
-	std::string gobject_type_str =
-		gobject_type.getUnqualifiedType ().getAsString ();
-	return gir_manager.find_object_info (gobject_type_str);
+	StringRef gobject_type_name = _gtype_name_for_type (gobject_type);
+	if (gobject_type_name.empty ())
+		return NULL;
+
+	return gir_manager.find_object_info (gobject_type_name);
 }
 
 /* Look up a named signal in a #GIObjectInfo or #GIInterfaceInfo,
@@ -354,11 +368,11 @@ _type_array_info_to_type (GITypeInfo *array_info,
 		}
 	}
 	case GI_ARRAY_TYPE_ARRAY:
-		return type_manager.find_pointer_type_by_name ("GArray");
+		return type_manager.well_known_types ().garray_pointer;
 	case GI_ARRAY_TYPE_PTR_ARRAY:
-		return type_manager.find_pointer_type_by_name ("GPtrArray");
+		return type_manager.well_known_types ().gptrarray_pointer;
 	case GI_ARRAY_TYPE_BYTE_ARRAY:
-		return type_manager.find_pointer_type_by_name ("GByteArray");
+		return type_manager.well_known_types ().gbytearray_pointer;
 	default:
 		WARN ("Warning: Unexpected array type " <<
 		      g_type_info_get_array_type (array_info) <<
@@ -381,7 +395,7 @@ _type_info_to_type (GITypeInfo *type_info,
 	case GI_TYPE_TAG_VOID:
 		return context.VoidTy;
 	case GI_TYPE_TAG_BOOLEAN:
-		return type_manager.find_type_by_name ("gboolean");
+		return type_manager.well_known_types ().gboolean;
 	case GI_TYPE_TAG_INT8:
 		return context.getIntTypeForBitwidth (8, true);
 	case GI_TYPE_TAG_UINT8:
@@ -419,13 +433,13 @@ _type_info_to_type (GITypeInfo *type_info,
 		return _type_interface_info_to_type (type_info, context,
 		                                     gir_manager, type_manager);
 	case GI_TYPE_TAG_GLIST:
-		return type_manager.find_pointer_type_by_name ("GList");
+		return type_manager.well_known_types ().glist_pointer;
 	case GI_TYPE_TAG_GSLIST:
-		return type_manager.find_pointer_type_by_name ("GSList");
+		return type_manager.well_known_types ().gslist_pointer;
 	case GI_TYPE_TAG_GHASH:
-		return type_manager.find_pointer_type_by_name ("GHashTable");
+		return type_manager.well_known_types ().ghashtable_pointer;
 	case GI_TYPE_TAG_ERROR:
-		return type_manager.find_pointer_type_by_name ("GError");
+		return type_manager.well_known_types ().gerror_pointer;
 	default:
 		WARN ("Warning: Unexpected base info type " <<
 		      g_base_info_get_type (type_info) <<
@@ -435,92 +449,93 @@ _type_info_to_type (GITypeInfo *type_info,
 	}
 }
 
-/* Returns true iff
- *  • @a is a GObject, @b is a GObject, and @a is equal to or a subclass of @b;
- *  • @a is a GInterface, @b is a GInterface, and @a is equal to @b;
- *  • @a is a GInterface, @b is a GObject, and at least one of @a’s
- *    prerequisites is equal to or a subtype of @b;
- *  • @a is a GObject, @b is a GInterface, and @a or one of its superclasses
- *    implements @b.
- */
-static bool
-_is_gtype_subclass (GIBaseInfo *a, GIBaseInfo *b)
+ResolvedSignal::ResolvedSignal () :
+	dynamic_instance_info (NULL), static_instance_info (NULL),
+	signal_info (NULL), name (NULL), dynamic_is_static_subclass (false),
+	return_type_name (NULL)
 {
-	GIInfoType a_type, b_type;
-
-	a_type = g_base_info_get_type (a);
-	b_type = g_base_info_get_type (b);
+}
 
-	DEBUG ("Checking whether " << g_base_info_get_name (a) << " is a "
-	       "subtype of " << g_base_info_get_name (b) << ".");
+ResolvedSignal::~ResolvedSignal ()
+{
+	if (this->signal_info != NULL)
+		g_base_info_unref (this->signal_info);
+	if (this->static_instance_info != NULL)
+		g_base_info_unref (this->static_instance_info);
+	g_base_info_unref (this->dynamic_instance_info);
+}
 
-	assert (a_type == GI_INFO_TYPE_OBJECT ||
-	        a_type == GI_INFO_TYPE_INTERFACE);
-	assert (b_type == GI_INFO_TYPE_OBJECT ||
-	        b_type == GI_INFO_TYPE_INTERFACE);
+/* Look up the signal named @signal_name on @dynamic_instance_info, and resolve
+ * the types its handlers are expected to have. This is cached for the
+ * translation unit in @cache, so that connecting to the same signal many times
+ * only queries the GIR metadata once. Negative results are cached too; in that
+ * case the returned signal’s @signal_info is %NULL. */
+static const ResolvedSignal *
+_look_up_resolved_signal (GIObjectInfo *dynamic_instance_info,
+                          const std::string &signal_name,
+                          const ASTContext &context,
+                          const GirManager &gir_manager,
+                          TypeManager &type_manager,
+                          ResolvedSignalCache &cache)
+{
+	ResolvedSignalCache::key_type key (dynamic_instance_info, signal_name);
+	ResolvedSignalCache::const_iterator cached = cache.find (key);
 
-	/* The case where @a and @b are equal. */
-	if (g_base_info_equal (a, b)) {
-		return true;
+	if (cached != cache.end ()) {
+		return cached->second.get ();
 	}
 
-	/* The case where @a implements @b. */
-	if (a_type == GI_INFO_TYPE_OBJECT &&
-	    b_type == GI_INFO_TYPE_INTERFACE) {
-		for (gint i = 0; i < g_object_info_get_n_interfaces (a); i++) {
-			GIInterfaceInfo *iface;
+	ResolvedSignal *signal = new ResolvedSignal ();
+	cache.emplace (key, std::unique_ptr<ResolvedSignal> (signal));
 
-			iface = g_object_info_get_interface (a, i);
-			bool eq = g_base_info_equal (iface, b);
-			g_base_info_unref (iface);
+	/* Keep the key’s #GIObjectInfo alive for as long as the entry. */
+	signal->dynamic_instance_info = g_base_info_ref (dynamic_instance_info);
+	signal->signal_info = _gtype_look_up_signal (dynamic_instance_info,
+	                                             &signal->static_instance_info,
+	                                             signal_name.c_str ());
 
-			if (eq) {
-				return true;
-			}
-		}
+	if (signal->signal_info == NULL) {
+		signal->dynamic_c_name =
+			gir_manager.get_c_name_for_type (dynamic_instance_info);
+		return signal;
 	}
 
-	/* The case where one of @a’s prerequisites is a subtype of @b. Note
-	 * that prerequisites may be classes or interfaces, and all interfaces
-	 * have GObject as an implicit prerequisite. */
-	if (a_type == GI_INFO_TYPE_INTERFACE &&
-	    b_type == GI_INFO_TYPE_OBJECT) {
-		/* GObject prerequisite. */
-		if (strcmp (g_base_info_get_namespace (b), "GObject") == 0 &&
-		    strcmp (g_base_info_get_name (b), "Object") == 0) {
-			return true;
-		}
-
-		/* Normal prerequisites. */
-		for (gint i = 0; i < g_interface_info_get_n_prerequisites (a); i++) {
-			GIBaseInfo *prereq;
-
-			prereq = g_interface_info_get_prerequisite (a, i);
-			bool subtype = _is_gtype_subclass (prereq, b);
-			g_base_info_unref (prereq);
-
-			if (subtype) {
-				return true;
-			}
-		}
+	signal->name = g_base_info_get_name (signal->signal_info);
+	signal->static_c_name =
+		gir_manager.get_c_name_for_type (signal->static_instance_info);
+	signal->self_type =
+		type_manager.find_pointer_type_by_name (signal->static_c_name);
+	signal->dynamic_is_static_subclass =
+		gir_manager.is_gtype_subclass (dynamic_instance_info,
+		                               signal->static_instance_info);
+
+	GICallableInfo *callable_info = signal->signal_info;
+	gint n_args = g_callable_info_get_n_args (callable_info);
+	GITypeInfo type_info;
+
+	for (gint i = 0; i < n_args; i++) {
+		GIArgInfo arg_info;
+		ResolvedSignal::Arg arg;
+
+		g_callable_info_load_arg (callable_info, i, &arg_info);
+		g_arg_info_load_type (&arg_info, &type_info);
+
+		arg.name = g_base_info_get_name (&arg_info);
+		arg.type = _type_info_to_type (&type_info, context,
+		                               gir_manager, type_manager);
+		arg.type_name = arg.type.isNull () ?
+		                g_base_info_get_name (&type_info) : NULL;
+
+		signal->args.push_back (arg);
 	}
 
-	/* The case where @a is a subclass of @b, or a subclass of a class which
-	 * implements @b. */
-	if (a_type == GI_INFO_TYPE_OBJECT) {
-		GIObjectInfo *ap = g_object_info_get_parent (a);
-
-		if (ap == NULL) {
-			return false;
-		}
-
-		bool subclass = _is_gtype_subclass (ap, b);
-		g_base_info_unref (ap);
-
-		return subclass;
-	}
+	g_callable_info_load_return_type (callable_info, &type_info);
+	signal->return_type = _type_info_to_type (&type_info, context,
+	                                          gir_manager, type_manager);
+	signal->return_type_name = signal->return_type.isNull () ?
+	                           g_base_info_get_name (&type_info) : NULL;
 
-	return false;
+	return signal;
 }
 
 /* A safe calling convention is any convention which is caller-cleanup and where
@@ -653,12 +668,12 @@ calling_convention_is_safe (CallingConv conv)
 
 /* Check the type of the callback in @expr (which is assumed to be a function
  * pointer or cast of a function pointer), asserting that it matches the type
- * of @signal_info.
+ * of @signal.
  *
  * @dynamic_instance_info is information about the GObject subclass being passed
- * to g_signal_connect(). @static_instance_info is information about the GObject
- * subclass which the signal is defined on. @dynamic_instance_info should be a
- * (non-strict) subclass of @static_instance_info.
+ * to g_signal_connect(). @signal holds information about the GObject subclass
+ * which the signal is defined on, and the types the signal expects.
+ * @dynamic_instance_info should be a (non-strict) subclass of the former.
  *
  * @data_type is the qualified type of the user data parameter passed to
  * g_signal_connect(). It is checked against the first parameter of the callback
@@ -670,15 +685,15 @@ calling_convention_is_safe (CallingConv conv)
 static bool
 _check_signal_callback_type (const Expr *expr,
                              GIBaseInfo *dynamic_instance_info,
-                             GIBaseInfo *static_instance_info,
+                             const ResolvedSignal &signal,
                              const QualType data_type,
                              bool is_swapped,
-                             GISignalInfo *signal_info,
                              CompilerInstance &compiler,
                              const ASTContext &context,
-                             const GirManager &gir_manager,
-                             TypeManager &type_manager)
+                             const GirManager &gir_manager)
 {
+	GIBaseInfo *static_instance_info = signal.static_instance_info;
+
 	const FunctionProtoType *callback_type = NULL;
 	SourceRange decl_range;  /* for the callback definition */
 
@@ -707,8 +722,8 @@ _check_signal_callback_type (const Expr *expr,
 			                     expr->getLocStart ()
 #endif
 			                     )
-			<< gir_manager.get_c_name_for_type (static_instance_info)
-			<< g_base_info_get_name (signal_info)
+			<< signal.static_c_name
+			<< signal.name
 			<< decl_range;
 
 			return false;
@@ -732,11 +747,9 @@ _check_signal_callback_type (const Expr *expr,
 
 		return _check_signal_callback_type (paren_expr->getSubExpr (),
 		                                    dynamic_instance_info,
-		                                    static_instance_info,
-		                                    data_type, is_swapped,
-		                                    signal_info, compiler,
-		                                    context, gir_manager,
-		                                    type_manager);
+		                                    signal, data_type,
+		                                    is_swapped, compiler,
+		                                    context, gir_manager);
 	}
 	case Stmt::StmtClass::ImplicitCastExprClass:
 	case Stmt::StmtClass::CStyleCastExprClass: {
@@ -745,11 +758,9 @@ _check_signal_callback_type (const Expr *expr,
 
 		return _check_signal_callback_type (cast_expr->getSubExprAsWritten (),
 		                                    dynamic_instance_info,
-		                                    static_instance_info,
-		                                    data_type, is_swapped,
-		                                    signal_info, compiler,
-		                                    context, gir_manager,
-		                                    type_manager);
+		                                    signal, data_type,
+		                                    is_swapped, compiler,
+		                                    context, gir_manager);
 	}
 	case Stmt::StmtClass::NoStmtClass:
 	default:
@@ -777,11 +788,9 @@ _check_signal_callback_type (const Expr *expr,
 	 * See the documentation for calling_convention_is_safe() for an
 	 * analysis.
 	 */
-	GICallableInfo *callable_info = signal_info;
-	guint n_signal_args = g_callable_info_get_n_args (callable_info) + 2;
+	guint n_signal_args = signal.args.size () + 2;
 	guint n_callback_args = callback_type->getNumParams ();
 
-	GITypeInfo expected_type_info;
 	QualType actual_type, expected_type;
 
 	if ((!calling_convention_is_safe (callback_type->getCallConv ()) &&
@@ -800,8 +809,8 @@ _check_signal_callback_type (const Expr *expr,
 		                   expr->getLocStart ()
 #endif
 		                   )
-		<< gir_manager.get_c_name_for_type (static_instance_info)
-		<< g_base_info_get_name (signal_info)
+		<< signal.static_c_name
+		<< signal.name
 		<< n_signal_args
 		<< n_callback_args
 		<< decl_range;
@@ -823,8 +832,8 @@ _check_signal_callback_type (const Expr *expr,
 			 * %G_CONNECT_SWAPPED flag has been passed, in which
 			 * case it’s the user_data, which is handled in the
 			 * ‘else’ block below. */
-			std::string c_type (gir_manager.get_c_name_for_type (static_instance_info));
-			expected_type = type_manager.find_pointer_type_by_name (c_type);
+			const std::string& c_type = signal.static_c_name;
+			expected_type = signal.self_type;
 			arg_name = "self";
 
 			QualType atp = actual_type;
@@ -832,10 +841,10 @@ _check_signal_callback_type (const Expr *expr,
 				atp = atp->getPointeeType ();
 			}
 
-			std::string actual_type_str =
-				atp.getUnqualifiedType ().getAsString ();
+			StringRef actual_type_name = _gtype_name_for_type (atp);
 			GIBaseInfo *actual_type_info =
-				gir_manager.find_object_info (actual_type_str);
+				actual_type_name.empty () ? NULL :
+				gir_manager.find_object_info (actual_type_name);
 
 			if (actual_type_info == NULL && is_swapped) {
 				/* Allow the instance argument to be a gpointer
@@ -867,8 +876,8 @@ _check_signal_callback_type (const Expr *expr,
 				                     )
 				<< arg_name
 				<< c_type
-				<< g_base_info_get_name (signal_info)
-				<< actual_type_str
+				<< signal.name
+				<< atp.getUnqualifiedType ().getAsString ()
 				<< decl_range;
 
 				continue;
@@ -894,12 +903,11 @@ _check_signal_callback_type (const Expr *expr,
 				 * checking for the first parameter. */
 				type_error = (actual_type_info == NULL ||
 				              atp.isConstQualified () ||
-				              !_is_gtype_subclass (dynamic_instance_info,
-				                                   actual_type_info) ||
-				              !_is_gtype_subclass (static_instance_info,
-				                                   actual_type_info) ||
-				              !_is_gtype_subclass (dynamic_instance_info,
-				                                   static_instance_info));
+				              !gir_manager.is_gtype_subclass (dynamic_instance_info,
+				                                              actual_type_info) ||
+				              !gir_manager.is_gtype_subclass (static_instance_info,
+				                                              actual_type_info) ||
+				              !signal.dynamic_is_static_subclass);
 
 				/* Remark about callbacks which have a instance
 				 * parameter which is not tightly typed. */
@@ -922,8 +930,8 @@ _check_signal_callback_type (const Expr *expr,
 #endif
 					                    )
 					<< arg_name
-					<< gir_manager.get_c_name_for_type (static_instance_info)
-					<< g_base_info_get_name (signal_info)
+					<< signal.static_c_name
+					<< signal.name
 					<< expected_type.getAsString ()
 					<< actual_type.getAsString ()
 					<< decl_range;
@@ -941,8 +949,8 @@ _check_signal_callback_type (const Expr *expr,
 #endif
 					                    )
 					<< arg_name
-					<< gir_manager.get_c_name_for_type (static_instance_info)
-					<< g_base_info_get_name (signal_info)
+					<< signal.static_c_name
+					<< signal.name
 					<< expected_type.getAsString ()
 					<< actual_type.getAsString ()
 					<< decl_range;
@@ -980,18 +988,10 @@ _check_signal_callback_type (const Expr *expr,
 			               actual_type->isPointerType ());
 		} else {
 			/* All other arguments. */
-			GIArgInfo arg_info;
-
-			g_callable_info_load_arg (callable_info, i - 1,
-			                          &arg_info);
-			g_arg_info_load_type (&arg_info, &expected_type_info);
-
-			arg_name = g_base_info_get_name (&arg_info);
+			const ResolvedSignal::Arg &arg = signal.args[i - 1];
 
-			expected_type = _type_info_to_type (&expected_type_info,
-			                                    context,
-			                                    gir_manager,
-			                                    type_manager);
+			arg_name = arg.name;
+			expected_type = arg.type;
 
 			if (expected_type.isNull ()) {
 				/* Error. */
@@ -1010,9 +1010,9 @@ _check_signal_callback_type (const Expr *expr,
 #endif
 				                     )
 				<< arg_name
-				<< gir_manager.get_c_name_for_type (static_instance_info)
-				<< g_base_info_get_name (signal_info)
-				<< g_base_info_get_name (&expected_type_info)
+				<< signal.static_c_name
+				<< signal.name
+				<< arg.type_name
 				<< decl_range;
 
 				continue;
@@ -1046,8 +1046,8 @@ _check_signal_callback_type (const Expr *expr,
 #endif
 			                   )
 			<< arg_name
-			<< gir_manager.get_c_name_for_type (static_instance_info)
-			<< g_base_info_get_name (signal_info)
+			<< signal.static_c_name
+			<< signal.name
 			<< expected_type.getAsString ()
 			<< actual_type.getAsString ()
 			<< decl_range;
@@ -1068,8 +1068,8 @@ _check_signal_callback_type (const Expr *expr,
 #endif
 			                   )
 			<< arg_name
-			<< gir_manager.get_c_name_for_type (static_instance_info)
-			<< g_base_info_get_name (signal_info)
+			<< signal.static_c_name
+			<< signal.name
 			<< expected_type.getAsString ()
 			<< actual_type.getAsString ()
 			<< decl_range;
@@ -1079,10 +1079,8 @@ _check_signal_callback_type (const Expr *expr,
 	}
 
 	/* Return type. */
-	g_callable_info_load_return_type (callable_info, &expected_type_info);
 	actual_type = callback_type->getReturnType ();
-	expected_type = _type_info_to_type (&expected_type_info, context,
-	                                    gir_manager, type_manager);
+	expected_type = signal.return_type;
 	if (expected_type.isNull ()) {
 		/* Error. */
 
@@ -1096,9 +1094,9 @@ _check_signal_callback_type (const Expr *expr,
 		                     expr->getLocStart ()
 #endif
 		                     )
-		<< gir_manager.get_c_name_for_type (static_instance_info)
-		<< g_base_info_get_name (signal_info)
-		<< g_base_info_get_name (&expected_type_info)
+		<< signal.static_c_name
+		<< signal.name
+		<< signal.return_type_name
 		<< decl_range;
 
 		return false;
@@ -1117,8 +1115,8 @@ _check_signal_callback_type (const Expr *expr,
 		                   expr->getLocStart ()
 #endif
 		                   )
-		<< gir_manager.get_c_name_for_type (static_instance_info)
-		<< g_base_info_get_name (signal_info)
+		<< signal.static_c_name
+		<< signal.name
 		<< expected_type.getAsString ()
 		<< actual_type.getAsString ()
 		<< decl_range;
@@ -1252,7 +1250,8 @@ _check_gsignal_callback_type (const CallExpr &call,
                               CompilerInstance &compiler,
                               const ASTContext &context,
                               const GirManager &gir_manager,
-                              TypeManager &type_manager)
+                              TypeManager &type_manager,
+                              ResolvedSignalCache &signal_cache)
 {
 	const Expr *callback_arg, *gobject_arg, *signal_name_arg;
 	const Expr *user_data_arg;
@@ -1304,9 +1303,8 @@ _check_gsignal_callback_type (const CallExpr &call,
 	}
 
 	/* Try and grab the GObject parameter’s type. This is the type of the
-	 * variable passed into g_signal_connect(). The @static_instance_info is
-	 * the type of the GObject subclass which defines the signal. */
-	GIObjectInfo *dynamic_instance_info, *static_instance_info = NULL;
+	 * variable passed into g_signal_connect(). */
+	GIObjectInfo *dynamic_instance_info;
 
 	dynamic_instance_info = _expr_to_gtype (gobject_arg->IgnoreParenImpCasts (),
 	                                        context, gir_manager);
@@ -1341,13 +1339,13 @@ _check_gsignal_callback_type (const CallExpr &call,
 	       g_base_info_get_namespace ((GIBaseInfo *) dynamic_instance_info) <<
 	       "’.");
 
-	/* Find the signal in the GObject. */
-	GISignalInfo *signal_info;
-
-	signal_info = _gtype_look_up_signal (dynamic_instance_info,
-	                                     &static_instance_info,
-	                                     signal_name.c_str ());
-	if (signal_info == NULL) {
+	/* Find the signal in the GObject, along with the GObject subclass which
+	 * defines it. */
+	const ResolvedSignal *signal =
+		_look_up_resolved_signal (dynamic_instance_info, signal_name,
+		                          context, gir_manager, type_manager,
+		                          signal_cache);
+	if (signal->signal_info == NULL) {
 		/* Remark on the fact the signal information cannot be found.
 		 * We can’t really make this a warning, since the user may not
 		 * be able to easily add a GIR file containing the signal
@@ -1365,7 +1363,7 @@ _check_gsignal_callback_type (const CallExpr &call,
 #endif
 		                    )
 		<< signal_name
-		<< gir_manager.get_c_name_for_type (dynamic_instance_info)
+		<< signal->dynamic_c_name
 		<< func_info->func_name
 		<< gobject_arg->getSourceRange ()
 		<< signal_name_arg->getSourceRange ();
@@ -1376,44 +1374,47 @@ _check_gsignal_callback_type (const CallExpr &call,
 	}
 
 	DEBUG ("Using GISignalInfo ‘" <<
-	       g_base_info_get_name ((GIBaseInfo *) signal_info) <<
+	       g_base_info_get_name ((GIBaseInfo *) signal->signal_info) <<
 	       "’ from namespace ‘" <<
-	       g_base_info_get_namespace ((GIBaseInfo *) signal_info) <<
+	       g_base_info_get_namespace ((GIBaseInfo *) signal->signal_info) <<
 	       "’.");
 
 	/* Check the callback’s type. */
 	if (!_check_signal_callback_type (callback_arg->IgnoreParenImpCasts (),
-	                                  dynamic_instance_info,
-	                                  static_instance_info,
+	                                  dynamic_instance_info, *signal,
 	                                  user_data_arg->getType (), is_swapped,
-	                                  signal_info,
-	                                  compiler, context, gir_manager,
-	                                  type_manager)) {
+	                                  compiler, context, gir_manager)) {
 		/* A diagnostic has already been emitted by
 		 * _check_signal_callback_type(). */
-		g_base_info_unref (signal_info);
 		g_base_info_unref (dynamic_instance_info);
-		g_base_info_unref (static_instance_info);
 
 		return false;
 	}
 
-	g_base_info_unref (signal_info);
 	g_base_info_unref (dynamic_instance_info);
-	g_base_info_unref (static_instance_info);
 
 	return true;
 }
 
-void
-GSignalConsumer::HandleTranslationUnit (ASTContext& context)
+GSignalVisitor::GSignalVisitor (CompilerInstance& compiler,
+                                std::shared_ptr<const GirManager> gir_manager,
+                                std::shared_ptr<TypeManager> type_manager) :
+	_compiler (compiler), _context (compiler.getASTContext ()),
+	_gir_manager (gir_manager),
+	_type_manager (type_manager)
 {
-	/* Run away if the plugin is disabled. */
-	if (!this->is_enabled ()) {
-		return;
+	for (guint i = 0; i < G_N_ELEMENTS (gsignal_connect_funcs); i++) {
+		this->_connect_funcs.add (gsignal_connect_funcs[i].func_name,
+		                          i + 1);
 	}
+}
 
-	this->_visitor.TraverseDecl (context.getTranslationUnitDecl ());
+/* Called by ASTDispatchConsumer, which has already checked this checker is
+ * enabled. */
+void
+GSignalConsumer::handle_call_expr (CallExpr& call)
+{
+	this->_visitor.VisitCallExpr (&call);
 }
 
 /* Note: Specifically overriding the Traverse* method here to re-implement
@@ -1430,7 +1431,7 @@ GSignalVisitor::VisitCallExpr (CallExpr* expr)
 		return true;
 
 	/* We’re only interested in functions which connect signals. */
-	func_info = _func_is_gsignal_connect (*func);
+	func_info = _func_is_gsignal_connect (*func, this->_connect_funcs);
 	if (func_info == NULL)
 		return true;
 
@@ -1438,7 +1439,8 @@ GSignalVisitor::VisitCallExpr (CallExpr* expr)
 	const GirManager *gir_manager = this->_gir_manager.get ();
 	_check_gsignal_callback_type (*expr, *func, func_info, this->_compiler,
 	                              func->getASTContext (),
-	                              *gir_manager, this->_type_manager);
+	                              *gir_manager, *this->_type_manager,
+	                              this->_signal_cache);
 
 	return true;
 }
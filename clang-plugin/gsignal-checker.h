@@ -23,13 +23,18 @@
 #ifndef TARTAN_GSIGNAL_CHECKER_H
 #define TARTAN_GSIGNAL_CHECKER_H
 
+#include <map>
+#include <memory>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include <clang/AST/AST.h>
 #include <clang/AST/ASTConsumer.h>
 #include <clang/AST/RecursiveASTVisitor.h>
 #include <clang/Frontend/CompilerInstance.h>
 
+#include "callee-table.h"
 #include "checker.h"
 #include "gir-manager.h"
 #include "type-manager.h"
@@ -38,19 +43,55 @@ namespace tartan {
 
 using namespace clang;
 
+/* A signal looked up on a particular (dynamic) GObject subclass, with the types
+ * its handlers are expected to have resolved to #QualTypes. */
+struct ResolvedSignal {
+	struct Arg {
+		const gchar *name;
+		QualType type;  /* null if it couldn’t be resolved */
+		const gchar *type_name;  /* only set if @type is null */
+	};
+
+	GIBaseInfo *dynamic_instance_info;  /* owned */
+
+	/* The GObject subclass or GInterface which defines the signal, and
+	 * the signal itself. Both are %NULL if the signal wasn’t found. */
+	GIBaseInfo *static_instance_info;  /* owned */
+	GISignalInfo *signal_info;  /* owned */
+
+	const gchar *name;
+	std::string static_c_name;
+	std::string dynamic_c_name;  /* only set if the signal wasn’t found */
+	bool dynamic_is_static_subclass;
+
+	/* Expected type of the instance parameter. */
+	QualType self_type;
+	/* Parameters other than the instance and user data. */
+	std::vector<Arg> args;
+	QualType return_type;  /* null if it couldn’t be resolved */
+	const gchar *return_type_name;  /* only set if @return_type is null */
+
+	ResolvedSignal ();
+	~ResolvedSignal ();
+};
+
+/* Keyed by the dynamic type’s #GIObjectInfo and the normalised signal name. */
+typedef std::map<std::pair<GIBaseInfo*, std::string>,
+                 std::unique_ptr<ResolvedSignal>> ResolvedSignalCache;
+
 class GSignalVisitor : public RecursiveASTVisitor<GSignalVisitor> {
 public:
 	explicit GSignalVisitor (CompilerInstance& compiler,
-	                         std::shared_ptr<const GirManager> gir_manager) :
-		_compiler (compiler), _context (compiler.getASTContext ()),
-		_gir_manager (gir_manager),
-		_type_manager (compiler.getASTContext ()) {}
+	                         std::shared_ptr<const GirManager> gir_manager,
+	                         std::shared_ptr<TypeManager> type_manager);
 
 private:
 	CompilerInstance& _compiler;
 	const ASTContext& _context;
 	std::shared_ptr<const GirManager> _gir_manager;
-	TypeManager _type_manager;
+	std::shared_ptr<TypeManager> _type_manager;
+	ResolvedSignalCache _signal_cache;
+	CalleeTable _connect_funcs;
 
 public:
 	bool VisitCallExpr (CallExpr* call);
@@ -60,15 +101,16 @@ class GSignalConsumer : public tartan::ASTChecker {
 public:
 	GSignalConsumer (CompilerInstance& compiler,
 	                 std::shared_ptr<const GirManager> gir_manager,
-	                 std::shared_ptr<const std::unordered_set<std::string>> disabled_plugins) :
+	                 std::shared_ptr<const std::unordered_set<std::string>> disabled_plugins,
+	                 std::shared_ptr<TypeManager> type_manager) :
 		ASTChecker (compiler, gir_manager, disabled_plugins),
-		_visitor (compiler, gir_manager) {};
+		_visitor (compiler, gir_manager, type_manager) {};
 
 private:
 	GSignalVisitor _visitor;
 
 public:
-	virtual void HandleTranslationUnit (ASTContext& context);
+	virtual void handle_call_expr (CallExpr& call);
 	const std::string get_name () const { return "gsignal"; }
 };
 
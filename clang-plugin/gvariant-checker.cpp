@@ -33,12 +33,13 @@
  * For #GVariant methods with format strings but no varargs, the format string
  * is validated.
  *
- * The format string is parsed and varargs are consumed in parallel. The static
- * type of the varargs is used, so if a weird cast is used (e.g. casting a
- * string literal to an integer and passing it to a ‘u’ format string), no error
- * will be raised. One limitation on the current checker is that the types of
- * #GVariants passed in are not checked. e.g. No error is emitted for the
- * following invalid code:
+ * Each distinct format string is parsed once per translation unit (see
+ * #GVariantTypeTree) into a list of the variadic arguments it expects, which is
+ * then matched against the varargs at each call site. The static type of the
+ * varargs is used, so if a weird cast is used (e.g. casting a string literal to
+ * an integer and passing it to a ‘u’ format string), no error will be raised.
+ * One limitation on the current checker is that the types of #GVariants passed
+ * in are not checked. e.g. No error is emitted for the following invalid code:
  *     g_variant_new ('@s', g_variant_new_boolean (FALSE));
  *
  * The checker is quite flexible, and a lot of its behaviour is controlled by
@@ -66,14 +67,13 @@
  * the most important of the two and highlight that.
  */
 
-#include <cstring>
-
 #include <clang/AST/Attr.h>
 
 #include <glib.h>
 
 #include "debug.h"
 #include "gvariant-checker.h"
+#include "gvariant-type-tree.h"
 
 namespace tartan {
 
@@ -140,22 +140,18 @@ typedef enum {
 } VariantCheckFlags;
 
 
+/* @format_funcs maps the names of the gvariant_format_funcs to their indices
+ * plus one. */
 static const VariantFuncInfo *
-_func_uses_gvariant_format (const FunctionDecl& func)
+_func_uses_gvariant_format (const FunctionDecl& func,
+                            const CalleeTable& format_funcs)
 {
-	const std::string func_name = func.getNameAsString ();
-	guint i;
+	unsigned int i = format_funcs.lookup (func);
 
-	/* Fast path elimination of irrelevant functions. */
-	if (func_name[0] != 'g')
+	if (i == 0)
 		return NULL;
 
-	for (i = 0; i < G_N_ELEMENTS (gvariant_format_funcs); i++) {
-		if (func_name == gvariant_format_funcs[i].func_name)
-			return &gvariant_format_funcs[i];
-	}
-
-	return NULL;
+	return &gvariant_format_funcs[i - 1];
 }
 
 /*
@@ -212,6 +208,19 @@ _compare_types (const QualType actual_type, const QualType expected_type,
 	                       flags, context);
 }
 
+/* Whether @decl declares the typedef type @typedef_type, which may be null. */
+static bool
+_is_typedef_of (const TypedefNameDecl *decl, QualType typedef_type)
+{
+	if (typedef_type.isNull ())
+		return false;
+
+	const TypedefType *tt = typedef_type->getAs<TypedefType> ();
+
+	return (tt != NULL &&
+	        tt->getDecl ()->getCanonicalDecl () == decl->getCanonicalDecl ());
+}
+
 /*
  * Return true if the given @type is known to differ in width on different
  * operating systems or processor architectures. This is important for
@@ -225,14 +234,15 @@ _compare_types (const QualType actual_type, const QualType expected_type,
  * regardless of whether the analyser is run on a 32- or 64-bit host.
  */
 static bool
-_type_is_arch_dependent (const QualType type, ASTContext &context)
+_type_is_arch_dependent (const QualType type, ASTContext &context,
+                         TypeManager &type_manager)
 {
 	/* Strip off any pointers. */
 	const PointerType *pointer_type = dyn_cast<PointerType> (type);
 
 	if (pointer_type != NULL) {
 		return _type_is_arch_dependent (pointer_type->getPointeeType (),
-		                                context);
+		                                context, type_manager);
 	}
 
 	/* If it’s a typedef type, assume it’s not architecture dependent.
@@ -253,10 +263,11 @@ _type_is_arch_dependent (const QualType type, ASTContext &context)
 	const TypedefType *typedef_type = dyn_cast<TypedefType> (type);
 
 	if (typedef_type != NULL) {
-		const std::string typedef_name =
-			typedef_type->getDecl ()->getNameAsString ();
-		return (typedef_name == "glong" ||
-		        typedef_name == "gulong");
+		const WellKnownTypes& types = type_manager.well_known_types ();
+		const TypedefNameDecl *decl = typedef_type->getDecl ();
+
+		return (_is_typedef_of (decl, types.glong) ||
+		        _is_typedef_of (decl, types.gulong));
 	}
 
 	/* Well-known architecture-dependent types.
@@ -269,34 +280,29 @@ _type_is_arch_dependent (const QualType type, ASTContext &context)
 	        context.hasSameType (type, context.LongDoubleTy));
 }
 
-/* Consume a single variadic argument from the varargs array, checking that one
- * exists and has the given @expected_type.
- *
- * Iff %CHECK_FLAG_ALLOW_MAYBE is set, the variadic argument may be NULL.
+/* Add a single variadic argument with the given @expected_type to the list of
+ * arguments expected by @format.
  *
- * This will emit errors where found. */
-static bool
-_consume_variadic_argument (QualType expected_type,
-                            CallExpr::const_arg_iterator *args_begin,
-                            CallExpr::const_arg_iterator *args_end,
-                            unsigned int /* VariantCheckFlags */ flags,
-                            CompilerInstance& compiler,
-                            const StringLiteral *format_arg_str,
-                            ASTContext& context, TypeManager &type_manager)
+ * Iff %CHECK_FLAG_ALLOW_MAYBE is set, the variadic argument may be NULL. */
+static void
+_add_variadic_argument (QualType expected_type,
+                        unsigned int /* VariantCheckFlags */ flags,
+                        GVariantFormat &format,
+                        ASTContext& context, TypeManager &type_manager)
 {
 	/* If the GVariant method doesn’t use varargs, don’t actually consume
 	 * the argument. */
 	if (!(flags & CHECK_FLAG_CONSUME_ARGS)) {
-		return true;
+		return;
 	}
 
 	/* In certain parsing states the expected types have been modified by a
 	 * preceding character in the format string. Force the expected types in
 	 * those cases. */
 	if (flags & CHECK_FLAG_FORCE_GVARIANT) {
-		expected_type = type_manager.find_pointer_type_by_name ("GVariant");
+		expected_type = type_manager.well_known_types ().gvariant_pointer;
 	} else if (flags & CHECK_FLAG_FORCE_VALIST) {
-		expected_type = type_manager.find_pointer_type_by_name ("va_list");
+		expected_type = type_manager.well_known_types ().va_list_pointer;
 	}
 
 	/* Handle const-ness of out arguments. We have to insert the const one
@@ -316,6 +322,30 @@ _consume_variadic_argument (QualType expected_type,
 		expected_type = context.getPointerType (expected_type);
 	}
 
+	DEBUG ("Expecting variadic argument of type ‘" <<
+	       expected_type.getAsString () << "’.");
+
+	GVariantFormatArgument argument;
+	argument.expected_type = expected_type;
+	argument.flags = flags;
+	format.arguments.push_back (argument);
+}
+
+/* Consume a single variadic argument from the varargs array, checking that one
+ * exists and has the type given by @expected.
+ *
+ * This will emit errors where found. */
+static bool
+_consume_variadic_argument (const GVariantFormatArgument &expected,
+                            CallExpr::const_arg_iterator *args_begin,
+                            CallExpr::const_arg_iterator *args_end,
+                            CompilerInstance& compiler,
+                            const StringLiteral *format_arg_str,
+                            ASTContext& context, TypeManager &type_manager)
+{
+	QualType expected_type = expected.expected_type;
+	unsigned int /* VariantCheckFlags */ flags = expected.flags;
+
 	DEBUG ("Consuming variadic argument with expected type ‘" <<
 	       expected_type.getAsString () << "’.");
 
@@ -370,7 +400,8 @@ _consume_variadic_argument (QualType expected_type,
 		bool type_error = !_compare_types (actual_type, expected_type,
 		                                   flags, context);
 		bool arch_error = _type_is_arch_dependent (actual_type,
-		                                           context);
+		                                           context,
+		                                           type_manager);
 
 		if (arch_error) {
 			Debug::emit_error ("Expected a GVariant variadic "
@@ -411,581 +442,273 @@ _consume_variadic_argument (QualType expected_type,
 	return true;
 }
 
-/* Parse a single basic type string from the beginning of the string pointed to
- * by @type_str (i.e. *type_str). Consume any variadic parameters from
- * @args_begin as appropriate. This will emit errors where found.
- *
- * @type_str and @args_begin are updated as the type string and arguments are
- * consumed. */
-static bool
-_check_basic_type_string (const gchar **type_str,
-                          CallExpr::const_arg_iterator *args_begin,
-                          CallExpr::const_arg_iterator *args_end,
-                          unsigned int /* VariantCheckFlags */ flags,
-                          CompilerInstance& compiler,
-                          const StringLiteral *format_arg_str,
-                          ASTContext& context, TypeManager &type_manager)
+/* Get the flags to use for the children of @parent, which was itself parsed
+ * with @flags. */
+static unsigned int
+_child_flags (const GVariantTypeNode &parent,
+              unsigned int /* VariantCheckFlags */ flags)
 {
-	DEBUG ("Checking basic type string ‘" << *type_str << "’.");
-
-	QualType expected_type;
-
-	/* Reference: GVariant Type Strings. */
-	switch (**type_str) {
-	/* Numeric Types */
-	case 'b': /* gboolean ≡ gint ≡ int */
-		expected_type = context.IntTy;
-		break;
-	case 'y': /* guchar ≡ unsigned char */
-		expected_type = context.UnsignedCharTy;
-		break;
-	case 'n': /* gint16 */
-		expected_type = type_manager.find_type_by_name ("gint16");
-		break;
-	case 'q': /* guint16 */
-		expected_type = type_manager.find_type_by_name ("guint16");
-		break;
-	case 'i':
-	case 'h': /* gint32 */
-		expected_type = type_manager.find_type_by_name ("gint32");
-		break;
-	case 'u': /* guint32 */
-		expected_type = type_manager.find_type_by_name ("guint32");
-		break;
-	case 'x': /* gint64 */
-		expected_type = type_manager.find_type_by_name ("gint64");
-		break;
-	case 't': /* guint64 */
-		expected_type = type_manager.find_type_by_name ("guint64");
-		break;
-	case 'd': /* gdouble ≡ double */
-		expected_type = context.DoubleTy;
-		break;
-	/* Strings */
-	case 's':
-	case 'o':
-	case 'g': /* gchar* ≡ char* */
-		/* FIXME: Could also validate o and g as D-Bus object paths and
-		 * type signatures. */
-		expected_type = context.getPointerType (context.CharTy);
-		break;
-	/* Basic types */
-	case '?': /* GVariant* of any type */
-		expected_type = type_manager.find_pointer_type_by_name ("GVariant");
-		break;
+	switch (parent.kind) {
+	case GVariantTypeNode::KIND_ARRAY:
+		/* The element type doesn’t correspond to any arguments; the
+		 * array is passed as a single GVariantBuilder or GVariantIter.
+		 *
+		 * FIXME: ALLOW_MAYBE only for definite types */
+		return (flags | CHECK_FLAG_ALLOW_MAYBE) & ~CHECK_FLAG_CONSUME_ARGS;
+	case GVariantTypeNode::KIND_MAYBE:
+		return flags | CHECK_FLAG_ALLOW_MAYBE;
+	case GVariantTypeNode::KIND_AS_GVARIANT:
+		return flags | CHECK_FLAG_FORCE_GVARIANT;
+	case GVariantTypeNode::KIND_NO_COPY:
+		/* Ignore it for inbound arguments; require that outbound
+		 * arguments are const. */
+		return flags | CHECK_FLAG_REQUIRE_CONST;
+	case GVariantTypeNode::KIND_BASIC:
+	case GVariantTypeNode::KIND_VARIANT:
+	case GVariantTypeNode::KIND_TUPLE:
+	case GVariantTypeNode::KIND_DICT_ENTRY:
+	case GVariantTypeNode::KIND_CONVENIENCE:
 	default:
-		Debug::emit_error ("Expected a GVariant basic type string but "
-		                   "saw ‘%0’.", compiler,
-#ifdef HAVE_LLVM_8_0
-		                   format_arg_str->getBeginLoc ()
-#else
-		                   format_arg_str->getLocStart ()
-#endif
-		                   )
-		<< std::string (1, **type_str);
-
-		return false;
+		return flags;
 	}
-
-	assert (!expected_type.isNull ());
-
-	/* Handle type promotion. Integer types which are smaller than 32 bits
-	 * (for all architectures we care about) are automatically promoted to
-	 * 32 bits when passed as varargs.
-	 *
-	 * A subtlety of the standard (ISO/IEC 9899, §6.3.1.1¶2) means that all
-	 * types are promoted to *signed* 32-bit integers. This is because int
-	 * can represent all values representable by 16-bit (and smaller)
-	 * unsigned integers.
-	 *
-	 * References:
-	 *  • GVariant Format Strings, §Numeric Types
-	 *  • ISO/IEC 9899, §6.5.2.2¶6
-	 */
-	if (!(flags & CHECK_FLAG_DIRECTION_OUT) &&
-	    (**type_str == 'y' || **type_str == 'n' || **type_str == 'q')) {
-		assert (expected_type->isPromotableIntegerType ());
-		expected_type = context.getPromotedIntegerType (expected_type);
-	}
-
-	/* Consume the type string. */
-	*type_str = *type_str + 1;
-
-	return _consume_variadic_argument (expected_type,
-	                                   args_begin, args_end,
-	                                   flags, compiler,
-	                                   format_arg_str, context,
-	                                   type_manager);
 }
 
-/* Parse a single type string from the beginning of the string pointed to
- * by @type_str (i.e. *type_str). Consume any variadic parameters from
- * @args_begin as appropriate. This will emit errors where found.
- *
- * @type_str and @args_begin are updated as the type string and arguments are
- * consumed. */
-static bool
-_check_type_string (const gchar **type_str,
-                    CallExpr::const_arg_iterator *args_begin,
-                    CallExpr::const_arg_iterator *args_end,
-                    unsigned int /* VariantCheckFlags */ flags,
-                    CompilerInstance& compiler,
-                    const StringLiteral *format_arg_str,
-                    ASTContext& context, TypeManager &type_manager)
+/* Get the type of the variadic argument corresponding to @node, parsed with
+ * @flags, or a null type if the node doesn’t correspond to an argument of its
+ * own (because it’s a container or modifier for its children). */
+static QualType
+_node_expected_type (const GVariantTypeTree &tree,
+                     const GVariantTypeNode &node,
+                     unsigned int /* VariantCheckFlags */ flags,
+                     ASTContext& context, TypeManager &type_manager)
 {
-	DEBUG ("Checking type string ‘" << *type_str << "’.");
-
+	const WellKnownTypes& types = type_manager.well_known_types ();
 	QualType expected_type;
 
-	/* Reference: GVariant Type Strings. */
-	switch (**type_str) {
-	/* Variants */
-	case 'v': /* GVariant* */
-		expected_type = type_manager.find_pointer_type_by_name ("GVariant");
-		break;
-	/* Arrays */
-	case 'a':
-		/* Consume the ‘a’. */
-		*type_str = *type_str + 1;
-
-		/* Update flags for the array element type.
-		 *
-		 * FIXME: ALLOW_MAYBE only for definite types */
-		flags |= CHECK_FLAG_ALLOW_MAYBE;
-
-		if (flags & CHECK_FLAG_DIRECTION_OUT) {
-			expected_type = type_manager.find_pointer_type_by_name ("GVariantIter");
-		} else {
-			expected_type = type_manager.find_pointer_type_by_name ("GVariantBuilder");
-		}
-
-		/* Check and consume the type string for the array element
-		 * type. */
-		if (!_check_type_string (type_str, args_begin, args_end,
-		                         flags & ~CHECK_FLAG_CONSUME_ARGS,
-		                         compiler, format_arg_str, context,
-		                         type_manager)) {
-			return false;
-		}
-
-		/* Consume the single GVariantBuilder for the array. */
-		return _consume_variadic_argument (expected_type,
-		                                   args_begin, args_end,
-		                                   flags, compiler,
-		                                   format_arg_str, context,
-		                                   type_manager);
-	/* Maybe Types */
-	case 'm':
-		*type_str = *type_str + 1;  /* consume the ‘m’ */
-		return _check_type_string (type_str, args_begin, args_end,
-		                           flags | CHECK_FLAG_ALLOW_MAYBE,
-		                           compiler, format_arg_str, context,
-		                           type_manager);
-	/* Tuples */
-	case '(':
-		*type_str = *type_str + 1;  /* consume the opening bracket */
-
-		while (**type_str != ')' && **type_str != '\0') {
-			if (!_check_type_string (type_str, args_begin,
-			                         args_end,
-			                         flags, compiler,
-			                         format_arg_str, context,
-			                         type_manager)) {
-				return false;
-			}
-		}
-
-		if (**type_str != ')') {
-			Debug::emit_error ("Invalid GVariant type string: "
-			                   "tuple did not end with ‘)’.",
-			                   compiler,
-#ifdef HAVE_LLVM_8_0
-			                   format_arg_str->getBeginLoc ()
-#else
-			                   format_arg_str->getLocStart ()
-#endif
-			                   );
-			return false;
-		}
-
-		*type_str = *type_str + 1;  /* consume the closing bracket */
-
-		return true;
-	case 'r': /* GVariant* of tuple type */
-		/* FIXME: Validate that the GVariant* has a tuple type. */
-		expected_type = type_manager.find_pointer_type_by_name ("GVariant");
-		break;
-	/* Dictionaries */
-	case '{':
-		*type_str = *type_str + 1;  /* consume the opening brace */
-
-		if (**type_str == '}') {
-			Debug::emit_error (
-				"Invalid GVariant type string: dict did not "
-				"contain exactly two elements.",
-				compiler,
-#ifdef HAVE_LLVM_8_0
-				format_arg_str->getBeginLoc ()
-#else
-				format_arg_str->getLocStart ()
-#endif
-				);
-			return false;
-		} else if (!_check_basic_type_string (type_str, args_begin,
-		                                      args_end,
-		                                      flags, compiler,
-		                                      format_arg_str, context,
-		                                      type_manager)) {
-			return false;
+	switch (node.kind) {
+	case GVariantTypeNode::KIND_BASIC:
+		/* Reference: GVariant Type Strings. */
+		switch (node.type_char) {
+		/* Numeric Types */
+		case 'b': /* gboolean ≡ gint ≡ int */
+			expected_type = context.IntTy;
+			break;
+		case 'y': /* guchar ≡ unsigned char */
+			expected_type = context.UnsignedCharTy;
+			break;
+		case 'n': /* gint16 */
+			expected_type = types.gint16;
+			break;
+		case 'q': /* guint16 */
+			expected_type = types.guint16;
+			break;
+		case 'i':
+		case 'h': /* gint32 */
+			expected_type = types.gint32;
+			break;
+		case 'u': /* guint32 */
+			expected_type = types.guint32;
+			break;
+		case 'x': /* gint64 */
+			expected_type = types.gint64;
+			break;
+		case 't': /* guint64 */
+			expected_type = types.guint64;
+			break;
+		case 'd': /* gdouble ≡ double */
+			expected_type = context.DoubleTy;
+			break;
+		/* Strings */
+		case 's':
+		case 'o':
+		case 'g': /* gchar* ≡ char* */
+			/* FIXME: Could also validate o and g as D-Bus object
+			 * paths and type signatures. */
+			expected_type = context.getPointerType (context.CharTy);
+			break;
+		default:
+			assert (false);
 		}
 
-		if (**type_str == '}') {
-			Debug::emit_error (
-				"Invalid GVariant type string: dict did not "
-				"contain exactly two elements.",
-				compiler,
-#ifdef HAVE_LLVM_8_0
-				format_arg_str->getBeginLoc ()
-#else
-				format_arg_str->getLocStart ()
-#endif
-				);
-			return false;
-		} else if (!_check_type_string (type_str, args_begin, args_end,
-		                                flags, compiler,
-		                                format_arg_str, context,
-		                                type_manager)) {
-			return false;
+		/* Handle type promotion. Integer types which are smaller than
+		 * 32 bits (for all architectures we care about) are
+		 * automatically promoted to 32 bits when passed as varargs.
+		 *
+		 * A subtlety of the standard (ISO/IEC 9899, §6.3.1.1¶2) means
+		 * that all types are promoted to *signed* 32-bit integers. This
+		 * is because int can represent all values representable by
+		 * 16-bit (and smaller) unsigned integers.
+		 *
+		 * References:
+		 *  • GVariant Format Strings, §Numeric Types
+		 *  • ISO/IEC 9899, §6.5.2.2¶6
+		 */
+		if (!(flags & CHECK_FLAG_DIRECTION_OUT) &&
+		    (node.type_char == 'y' || node.type_char == 'n' ||
+		     node.type_char == 'q')) {
+			assert (expected_type->isPromotableIntegerType ());
+			expected_type = context.getPromotedIntegerType (expected_type);
 		}
 
-		if (**type_str == '\0') {
-			Debug::emit_error (
-				"Invalid GVariant type string: dict "
-				"did not end with ‘}’.",
-				compiler,
-#ifdef HAVE_LLVM_8_0
-				format_arg_str->getBeginLoc ()
-#else
-				format_arg_str->getLocStart ()
-#endif
-				);
-			return false;
-		} else if (**type_str != '}') {
-			Debug::emit_error (
-				"Invalid GVariant type string: dict "
-				"contains more than two elements.",
-				compiler,
-#ifdef HAVE_LLVM_8_0
-				format_arg_str->getBeginLoc ()
-#else
-				format_arg_str->getLocStart ()
-#endif
-				);
-			return false;
+		return expected_type;
+	case GVariantTypeNode::KIND_VARIANT:
+		/* FIXME: Validate that the GVariant* for ‘r’ has a tuple
+		 * type. */
+		return types.gvariant_pointer;
+	case GVariantTypeNode::KIND_ARRAY:
+		/* If the element type was invalid, the array can’t be
+		 * checked. */
+		if (!node.is_complete ())
+			return QualType ();
+
+		if (flags & CHECK_FLAG_DIRECTION_OUT)
+			return types.gvariant_iter_pointer;
+		else
+			return types.gvariant_builder_pointer;
+	case GVariantTypeNode::KIND_CONVENIENCE: {
+		/* Effectively hard-code the table from
+		 * §Convenience Conversions. */
+		QualType char_array = context.getPointerType (context.CharTy);
+		QualType const_char_array = context.getPointerType (context.getConstType (context.CharTy));
+		StringRef text = tree.get_text (node);
+
+		if (text == "^as" || text == "^ao" || text == "^aay") {
+			return context.getPointerType (char_array);
+		} else if (text == "^a&s" || text == "^a&o" ||
+		           text == "^a&ay") {
+			return context.getPointerType (const_char_array);
+		} else if (text == "^ay") {
+			return char_array;
+		} else if (text == "^&ay") {
+			return const_char_array;
 		}
 
-		*type_str = *type_str + 1;  /* consume the closing brace */
-
-		return true;
-	/* GVariant* */
-	case '*': /* GVariant* of any type */
-		expected_type = type_manager.find_pointer_type_by_name ("GVariant");
-		break;
+		assert (false);
+		return QualType ();
+	}
+	case GVariantTypeNode::KIND_MAYBE:
+	case GVariantTypeNode::KIND_TUPLE:
+	case GVariantTypeNode::KIND_DICT_ENTRY:
+	case GVariantTypeNode::KIND_AS_GVARIANT:
+	case GVariantTypeNode::KIND_NO_COPY:
 	default:
-		/* Fall back to checking basic types. */
-		return _check_basic_type_string (type_str, args_begin, args_end,
-		                                 flags, compiler,
-		                                 format_arg_str, context,
-		                                 type_manager);
+		return QualType ();
 	}
-
-	/* Consume the type string. */
-	*type_str = *type_str + 1;
-
-	return _consume_variadic_argument (expected_type,
-	                                   args_begin, args_end,
-	                                   flags, compiler,
-	                                   format_arg_str, context,
-	                                   type_manager);
 }
 
-/* Parse a single basic format string from the beginning of the string pointed
- * to by @format_str (i.e. *format_str). Consume any variadic parameters from
- * @args_begin as appropriate. This will emit errors where found.
- *
- * @format_str and @args_begin are updated as the format string and arguments
- * are consumed. */
+/* Whether @node corresponds to a variadic argument, and hence whether
+ * _node_expected_type() must return a type for it. An array whose element type
+ * is invalid can’t be checked, so doesn’t count. */
 static bool
-_check_basic_format_string (const gchar **format_str,
-                            CallExpr::const_arg_iterator *args_begin,
-                            CallExpr::const_arg_iterator *args_end,
-                            unsigned int /* VariantCheckFlags */ flags,
-                            CompilerInstance& compiler,
-                            const StringLiteral *format_arg_str,
-                            ASTContext& context, TypeManager &type_manager)
+_node_takes_argument (const GVariantTypeNode &node)
 {
-	DEBUG ("Checking format string ‘" << *format_str << "’.");
-
-	/* Reference: GVariant Format Strings documentation, §Syntax. */
-	switch (**format_str) {
-	case '@':
-		*format_str = *format_str + 1;  /* consume the ‘@’ */
-		return _check_basic_type_string (format_str, args_begin,
-		                                 args_end,
-		                                 flags |
-		                                 CHECK_FLAG_FORCE_GVARIANT,
-		                                 compiler, format_arg_str,
-		                                 context, type_manager);
-	case '?':
-		/* Direct GVariant. */
-		*format_str = *format_str + 1;  /* consume the argument */
-		return _consume_variadic_argument (type_manager.find_pointer_type_by_name ("GVariant"),
-		                                   args_begin, args_end,
-		                                   flags,
-		                                   compiler, format_arg_str,
-		                                   context, type_manager);
-	case '&':
-		/* Ignore it for inbound arguments; require that outbound
-		 * arguments are const. */
-		*format_str = *format_str + 1;
-		return _check_basic_type_string (format_str, args_begin,
-		                                 args_end,
-		                                 flags |
-		                                 CHECK_FLAG_REQUIRE_CONST,
-		                                 compiler, format_arg_str,
-		                                 context, type_manager);
-	case '^': {
-		/* Various different hard-coded types. */
-		*format_str = *format_str + 1;
-
-		QualType expected_type;
-		QualType char_array = context.getPointerType (context.CharTy);
-		QualType const_char_array = context.getPointerType (context.getConstType (context.CharTy));
-		guint skip;
-
-		/* Effectively hard-code the table from
-		 * §Convenience Conversions. */
-#define CONVENIENCE_FORMAT(STR_PTR, F) (strncmp (STR_PTR, F, strlen (F)) == 0)
-		if (CONVENIENCE_FORMAT (*format_str, "as") ||
-		    CONVENIENCE_FORMAT (*format_str, "ao")) {
-			expected_type = context.getPointerType (char_array);
-			skip = 2;
-		} else if (CONVENIENCE_FORMAT (*format_str, "a&s") ||
-		           CONVENIENCE_FORMAT (*format_str, "a&o")) {
-			expected_type = context.getPointerType (const_char_array);
-			skip = 3;
-		} else if (CONVENIENCE_FORMAT (*format_str, "aay")) {
-			expected_type = context.getPointerType (char_array);
-			skip = 3;
-		} else if (CONVENIENCE_FORMAT (*format_str, "ay")) {
-			expected_type = char_array;
-			skip = 2;
-		} else if (CONVENIENCE_FORMAT (*format_str, "&ay")) {
-			expected_type = const_char_array;
-			skip = 3;
-		} else if (CONVENIENCE_FORMAT (*format_str, "a&ay")) {
-			expected_type = context.getPointerType (const_char_array);
-			skip = 4;
-		} else {
-			Debug::emit_error (
-				"Invalid GVariant basic format string: "
-				"convenience operator ‘^’ was not followed by "
-				"a recognized convenience conversion.",
-				compiler,
-#ifdef HAVE_LLVM_8_0
-				format_arg_str->getBeginLoc ()
-#else
-				format_arg_str->getLocStart ()
-#endif
-				);
-			return false;
-		}
-#undef CONVENIENCE_FORMAT
-
-		*format_str = *format_str + skip;
-
-		return _consume_variadic_argument (expected_type, args_begin,
-		                                   args_end,
-		                                   flags, compiler,
-		                                   format_arg_str, context,
-		                                   type_manager);
-	}
+	switch (node.kind) {
+	case GVariantTypeNode::KIND_BASIC:
+	case GVariantTypeNode::KIND_VARIANT:
+	case GVariantTypeNode::KIND_CONVENIENCE:
+		return true;
+	case GVariantTypeNode::KIND_ARRAY:
+		return node.is_complete ();
+	case GVariantTypeNode::KIND_MAYBE:
+	case GVariantTypeNode::KIND_TUPLE:
+	case GVariantTypeNode::KIND_DICT_ENTRY:
+	case GVariantTypeNode::KIND_AS_GVARIANT:
+	case GVariantTypeNode::KIND_NO_COPY:
 	default:
-		/* Assume it’s a type string. */
-		return _check_basic_type_string (format_str, args_begin,
-		                                 args_end,
-		                                 flags, compiler,
-		                                 format_arg_str, context,
-		                                 type_manager);
+		return false;
 	}
 }
 
-/* Parse a single format string from the beginning of the string pointed
- * to by @format_str (i.e. *format_str). Consume any variadic parameters from
- * @args_begin as appropriate. This will emit errors where found.
+/* Parse the whole of the GVariant format string @format_str into @format, with
+ * the initial @flags.
  *
- * @format_str and @args_begin are updated as the format string and arguments
- * are consumed. */
-static bool
-_check_format_string (const gchar **format_str,
-                      CallExpr::const_arg_iterator *args_begin,
-                      CallExpr::const_arg_iterator *args_end,
-                      unsigned int /* VariantCheckFlags */ flags,
-                      CompilerInstance& compiler,
-                      const StringLiteral *format_arg_str,
-                      ASTContext& context, TypeManager &type_manager)
+ * The nodes of the parsed tree are in pre-order, so the flags for each node
+ * can be worked out from its parent’s in a single pass, and the variadic
+ * arguments come out in the order they’re passed in. An array’s elements
+ * don’t correspond to any arguments, so it doesn’t matter that the array’s
+ * own argument comes before them. */
+static void
+_parse_gvariant_format (const gchar *format_str,
+                        unsigned int /* VariantCheckFlags */ flags,
+                        GVariantFormat &format,
+                        ASTContext& context, TypeManager &type_manager)
 {
-	DEBUG ("Checking format string ‘" << *format_str << "’.");
-
-	/* Reference: GVariant Format Strings documentation, §Syntax. */
-	switch (**format_str) {
-	case '@':
-		*format_str = *format_str + 1;  /* consume the ‘@’ */
-		return _check_type_string (format_str, args_begin, args_end,
-		                           flags | CHECK_FLAG_FORCE_GVARIANT,
-		                           compiler, format_arg_str, context,
-		                           type_manager);
-	case 'm':
-		*format_str = *format_str + 1;  /* consume the ‘m’ */
-		return _check_format_string (format_str, args_begin, args_end,
-		                             flags | CHECK_FLAG_ALLOW_MAYBE,
-		                             compiler, format_arg_str, context,
-		                             type_manager);
-	case '*':
-	case '?':
-	case 'r':
-		/* Direct GVariants. */
-		*format_str = *format_str + 1;  /* consume the argument */
-		return _consume_variadic_argument (type_manager.find_pointer_type_by_name ("GVariant"),
-		                                   args_begin, args_end,
-		                                   flags,
-		                                   compiler, format_arg_str,
-		                                   context, type_manager);
-	case '(':
-		*format_str = *format_str + 1;  /* consume the opening bracket */
-
-		while (**format_str != ')' && **format_str != '\0') {
-			if (!_check_format_string (format_str, args_begin,
-			                           args_end,
-			                           flags, compiler,
-			                           format_arg_str, context,
-			                           type_manager)) {
-				return false;
-			}
-		}
+	GVariantTypeTree tree;
 
-		if (**format_str != ')') {
-			Debug::emit_error (
-				"Invalid GVariant format string: tuple "
-				"did not end with ‘)’.",
-				compiler,
-#ifdef HAVE_LLVM_8_0
-				format_arg_str->getBeginLoc ()
-#else
-				format_arg_str->getLocStart ()
-#endif
-				);
-			return false;
-		}
+	DEBUG ("Parsing GVariant format string ‘" << format_str << "’.");
 
-		*format_str = *format_str + 1;  /* consume the closing bracket */
+	tree.parse (format_str, GVariantTypeTree::CONTEXT_FORMAT);
 
-		return true;
-	case '{':
-		*format_str = *format_str + 1;  /* consume the opening brace */
-
-		if (**format_str == '}') {
-			Debug::emit_error (
-				"Invalid GVariant format string: dict did not "
-				"contain exactly two elements.",
-				compiler,
-#ifdef HAVE_LLVM_8_0
-				format_arg_str->getBeginLoc ()
-#else
-				format_arg_str->getLocStart ()
-#endif
-				);
-			return false;
-		} else if (!_check_basic_format_string (format_str, args_begin,
-		                                        args_end,
-		                                        flags, compiler,
-		                                        format_arg_str,
-		                                        context,
-		                                        type_manager)) {
-			return false;
-		}
+	const std::vector<GVariantTypeNode>& nodes = tree.get_nodes ();
+	std::vector<unsigned int> node_flags (nodes.size ());
 
-		if (**format_str == '}') {
-			Debug::emit_error (
-				"Invalid GVariant format string: dict did not "
-				"contain exactly two elements.",
-				compiler,
-#ifdef HAVE_LLVM_8_0
-				format_arg_str->getBeginLoc ()
-#else
-				format_arg_str->getLocStart ()
-#endif
-				);
-			return false;
-		} else if (!_check_format_string (format_str, args_begin,
-		                                  args_end,
-		                                  flags, compiler,
-		                                  format_arg_str, context,
-		                                  type_manager)) {
-			return false;
+	for (unsigned int i = 0; i < nodes.size (); i++) {
+		const GVariantTypeNode &node = nodes[i];
+
+		if (node.parent == GVariantTypeNode::NO_PARENT) {
+			node_flags[i] = flags;
+		} else {
+			node_flags[i] = _child_flags (nodes[node.parent],
+			                              node_flags[node.parent]);
 		}
 
-		if (**format_str == '\0') {
-			Debug::emit_error (
-				"Invalid GVariant format string: dict "
-				"did not end with ‘}’.",
-				compiler,
-#ifdef HAVE_LLVM_8_0
-				format_arg_str->getBeginLoc ()
-#else
-				format_arg_str->getLocStart ()
-#endif
-				);
-			return false;
-		} else if (**format_str != '}') {
-			Debug::emit_error (
-				"Invalid GVariant format string: dict "
-				"contains more than two elements.",
-				compiler,
-#ifdef HAVE_LLVM_8_0
-				format_arg_str->getBeginLoc ()
-#else
-				format_arg_str->getLocStart ()
-#endif
-				);
-			return false;
+		unsigned int arg_flags = node_flags[i];
+		if (node.kind == GVariantTypeNode::KIND_ARRAY)
+			arg_flags |= CHECK_FLAG_ALLOW_MAYBE;
+
+		if (!_node_takes_argument (node))
+			continue;
+
+		QualType expected_type = _node_expected_type (tree, node,
+		                                              arg_flags,
+		                                              context,
+		                                              type_manager);
+
+		/* A GLib typedef (such as gint16 or GVariant) which the
+		 * translation unit doesn’t declare. Skipping the argument
+		 * would misalign all the following ones, so stop here. */
+		if (expected_type.isNull ()) {
+			format.error = "Couldn’t find the C type for ‘%0’ in "
+			               "GVariant format string ‘%1’, so the "
+			               "format string can’t be checked. Is "
+			               "<glib.h> included?";
+			format.error_args.push_back (tree.get_text (node).str ());
+			format.error_args.push_back (format_str);
+			return;
 		}
 
-		*format_str = *format_str + 1;  /* consume the closing brace */
+		_add_variadic_argument (expected_type, arg_flags,
+		                        format, context, type_manager);
+	}
 
-		return true;
-	case '&':
-		/* Ignore it for inbound arguments; require that outbound
-		 * arguments are const. */
-		*format_str = *format_str + 1;
-		return _check_type_string (format_str, args_begin, args_end,
-		                           flags | CHECK_FLAG_REQUIRE_CONST,
-		                           compiler, format_arg_str, context,
-		                           type_manager);
-	case '^':
-		/* Handled by the basic format string parser. */
-		return _check_basic_format_string (format_str, args_begin,
-		                                   args_end,
-		                                   flags, compiler,
-		                                   format_arg_str, context,
-		                                   type_manager);
-	default:
-		/* Assume it’s a type string. */
-		return _check_type_string (format_str, args_begin, args_end,
-		                           flags, compiler,
-		                           format_arg_str, context,
-		                           type_manager);
+	format.error = tree.get_error ();
+	format.error_args.append (tree.get_error_args ().begin (),
+	                          tree.get_error_args ().end ());
+}
+
+/* Look up the parsed form of the GVariant format string @format_str, with the
+ * initial @flags, in @formats. Parse it and add it to @formats if this is the
+ * first time it’s been seen in this translation unit. */
+static const GVariantFormat&
+_get_gvariant_format (StringRef format_str,
+                      unsigned int /* VariantCheckFlags */ flags,
+                      GVariantFormatCache &formats,
+                      ASTContext& context, TypeManager &type_manager)
+{
+	llvm::StringMap<GVariantFormat> &flag_formats = formats[flags];
+	std::pair<llvm::StringMap<GVariantFormat>::iterator, bool> entry =
+		flag_formats.try_emplace (format_str);
+	GVariantFormat &format = entry.first->getValue ();
+
+	/* Parse from the map’s copy of the key, since it’s nul-terminated (and
+	 * the string literal’s data is not guaranteed to be). Like a C string,
+	 * it ends at the first nul. */
+	if (entry.second) {
+		_parse_gvariant_format (entry.first->getKeyData (), flags,
+		                        format, context, type_manager);
 	}
+
+	return format;
 }
 
 /* Build a GVariant format string to represent the given type, or return NULL if
@@ -1000,7 +723,7 @@ _gvariant_format_string_for_type (QualType type,
 
 	/* Boolean. */
 	if ((bt != NULL && bt->getKind () == BuiltinType::Bool) ||
-	    type == type_manager.find_pointer_type_by_name ("gboolean")) {
+	    type == type_manager.well_known_types ().gboolean_pointer) {
 		return g_strdup ("b");
 	    } else if (bt != NULL && bt->getKind () == BuiltinType::UChar) {
 		return g_strdup ("y");
@@ -1033,7 +756,7 @@ _gvariant_format_string_for_type (QualType type,
 			return g_strdup ("&s");  /* or 'o' or 'g' */
 		} else if (pointee_type->isCharType ()) {
 			return g_strdup ("s");
-		} else if (pointee_type == type_manager.find_pointer_type_by_name ("GVariant")) {
+		} else if (pointee_type == type_manager.well_known_types ().gvariant_pointer) {
 			return g_strdup ("v");
 		} else if (pointee_type->isPointerType ()) {
 			const QualType pointee2_type = pointee_type->getPointeeType ();
@@ -1055,7 +778,7 @@ _gvariant_format_string_for_type (QualType type,
 
 /* Check a GVariant function call which passes a format parameter. Validate the
  * format parameter string, and if the function takes varargs, validate their
- * types against that parameter.
+ * types against that parameter. Parsed format strings are cached in @formats.
  *
  * If the format string is not a string literal, we can’t check anything. */
 static bool
@@ -1063,7 +786,8 @@ _check_gvariant_format_param (const CallExpr& call,
                               const FunctionDecl &func,
                               const VariantFuncInfo *func_info,
                               CompilerInstance& compiler,
-                              ASTContext& context, TypeManager &type_manager)
+                              ASTContext& context, TypeManager &type_manager,
+                              GVariantFormatCache &formats)
 {
 	/* Grab the format parameter string. */
 	const Expr *format_arg = call.getArg (func_info->format_param_index)->IgnoreParenImpCasts ();
@@ -1087,16 +811,13 @@ _check_gvariant_format_param (const CallExpr& call,
 		return false;
 	}
 
-	/* Check the string. Parse it hand-in-hand with iterating through the
-	 * varargs list. Take a copy of the format_str because StringRef.str()
-	 * only uses a temporary internal buffer. */
+	/* Check the string. It’s parsed once per translation unit (for each
+	 * set of initial flags) into a list of expected variadic arguments,
+	 * which are then matched against the arguments at this call site. */
 	DEBUG ("Checking GVariant format string ‘" <<
 	       format_arg_str->getString () << "’ with " <<
 	       call.getNumArgs () << " variadic arguments.");
 
-	gchar *whole_format_str;
-	whole_format_str = g_strdup (format_arg_str->getString ().str ().c_str ());
-	const gchar *format_str = whole_format_str;
 	CallExpr::const_arg_iterator args_begin = call.arg_begin ();
 	CallExpr::const_arg_iterator args_end = call.arg_end ();
 
@@ -1116,39 +837,41 @@ _check_gvariant_format_param (const CallExpr& call,
 	if (!func_info->args_in)
 		flags |= (CHECK_FLAG_DIRECTION_OUT | CHECK_FLAG_ALLOW_MAYBE);
 
-	if (!_check_format_string (&format_str, &args_begin, &args_end,
-	                           flags, compiler, format_arg_str, context,
-	                           type_manager)) {
-		g_free (whole_format_str);
-		return false;
+	const GVariantFormat &format =
+		_get_gvariant_format (format_arg_str->getString (), flags,
+		                      formats, context, type_manager);
+
+	for (llvm::SmallVectorImpl<GVariantFormatArgument>::const_iterator it =
+	     format.arguments.begin (), ie = format.arguments.end ();
+	     it != ie; ++it) {
+		if (!_consume_variadic_argument (*it, &args_begin, &args_end,
+		                                 compiler, format_arg_str,
+		                                 context, type_manager)) {
+			return false;
+		}
 	}
 
-	/* Sanity check that we’ve consumed all format strings. If not, the
-	 * user has probably forgotten to add tuple brackets around their format
-	 * string. Don’t emit any error messages about unpaired variadic
-	 * arguments because that would just confuse things. */
-	if (*format_str != '\0') {
-		Debug::emit_error ("Unexpected GVariant format strings ‘%0’ "
-		                   "with unpaired arguments. If using multiple "
-		                   "format strings, they should be enclosed in "
-		                   "brackets to create a tuple (e.g. ‘(%1)’).",
-		                   compiler,
+	/* Emit any error in the format string, now that the arguments which
+	 * precede it have been checked. */
+	if (format.error != NULL) {
+		DiagnosticBuilder builder =
+			Debug::emit_error (format.error, compiler,
 #ifdef HAVE_LLVM_8_0
-		                   format_arg_str->getBeginLoc ()
+			                   format_arg_str->getBeginLoc ()
 #else
-		                   format_arg_str->getLocStart ()
+			                   format_arg_str->getLocStart ()
 #endif
-		                   )
-		<< format_str
-		<< whole_format_str;
+			                   );
 
-		g_free (whole_format_str);
+		for (llvm::SmallVectorImpl<std::string>::const_iterator it =
+		     format.error_args.begin (), ie = format.error_args.end ();
+		     it != ie; ++it) {
+			builder << *it;
+		}
 
 		return false;
 	}
 
-	g_free (whole_format_str);
-
 	/* Sanity check that we’ve consumed all arguments. */
 	bool retval = true;
 
@@ -1204,15 +927,23 @@ _check_gvariant_format_param (const CallExpr& call,
 	return retval;
 }
 
-void
-GVariantConsumer::HandleTranslationUnit (ASTContext& context)
+GVariantVisitor::GVariantVisitor (CompilerInstance& compiler,
+                                  std::shared_ptr<TypeManager> type_manager) :
+	_compiler (compiler), _context (compiler.getASTContext ()),
+	_type_manager (type_manager)
 {
-	/* Run away if the plugin is disabled. */
-	if (!this->is_enabled ()) {
-		return;
+	for (guint i = 0; i < G_N_ELEMENTS (gvariant_format_funcs); i++) {
+		this->_format_funcs.add (gvariant_format_funcs[i].func_name,
+		                         i + 1);
 	}
+}
 
-	this->_visitor.TraverseDecl (context.getTranslationUnitDecl ());
+/* Called by ASTDispatchConsumer, which has already checked this checker is
+ * enabled. */
+void
+GVariantConsumer::handle_call_expr (CallExpr& call)
+{
+	this->_visitor.VisitCallExpr (&call);
 }
 
 /* Note: Specifically overriding the Traverse* method here to re-implement
@@ -1229,14 +960,14 @@ GVariantVisitor::VisitCallExpr (CallExpr* expr)
 		return true;
 
 	/* We’re only interested in functions which handle GVariants. */
-	func_info = _func_uses_gvariant_format (*func);
+	func_info = _func_uses_gvariant_format (*func, this->_format_funcs);
 	if (func_info == NULL)
 		return true;
 
 	/* Check the format parameter. */
 	_check_gvariant_format_param (*expr, *func, func_info, this->_compiler,
 	                              func->getASTContext (),
-	                              this->_type_manager);
+	                              *this->_type_manager, this->_formats);
 
 	return true;
 }
@@ -23,13 +23,19 @@
 #ifndef TARTAN_GVARIANT_CHECKER_H
 #define TARTAN_GVARIANT_CHECKER_H
 
+#include <memory>
+#include <string>
+#include <unordered_map>
 #include <unordered_set>
 
 #include <clang/AST/AST.h>
 #include <clang/AST/ASTConsumer.h>
 #include <clang/AST/RecursiveASTVisitor.h>
 #include <clang/Frontend/CompilerInstance.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringMap.h>
 
+#include "callee-table.h"
 #include "checker.h"
 #include "type-manager.h"
 
@@ -37,17 +43,43 @@ namespace tartan {
 
 using namespace clang;
 
+/* A variadic argument expected by a GVariant format string: the type it must
+ * have (with any const-ness and out-argument pointers already applied), and
+ * the VariantCheckFlags in force when it was parsed. */
+struct GVariantFormatArgument {
+	QualType expected_type;
+	unsigned int flags;
+};
+
+/* A GVariant format string parsed with a given set of initial flags: the
+ * variadic arguments it expects, in order, and the first error in it (if
+ * any). The error is a diagnostic format string, with its arguments in
+ * @error_args; the arguments listed before it are those which precede the
+ * error in the format string. */
+struct GVariantFormat {
+	llvm::SmallVector<GVariantFormatArgument, 4> arguments;
+	const char *error;
+	llvm::SmallVector<std::string, 2> error_args;
+
+	GVariantFormat () : error (NULL) {}
+};
+
+/* Parsed format strings for a translation unit, keyed by initial flags and
+ * then by format string. */
+typedef std::unordered_map<unsigned int, llvm::StringMap<GVariantFormat>> GVariantFormatCache;
+
 class GVariantVisitor : public RecursiveASTVisitor<GVariantVisitor> {
 public:
-	explicit GVariantVisitor (CompilerInstance& compiler) :
-		_compiler (compiler), _context (compiler.getASTContext ()),
-		_type_manager (compiler.getASTContext ()) {}
+	explicit GVariantVisitor (CompilerInstance& compiler,
+	                          std::shared_ptr<TypeManager> type_manager);
 
 private:
 	QualType _gvariant_pointer_type;
 	CompilerInstance& _compiler;
 	const ASTContext& _context;
-	TypeManager _type_manager;
+	std::shared_ptr<TypeManager> _type_manager;
+	CalleeTable _format_funcs;
+	GVariantFormatCache _formats;
 
 public:
 	bool VisitCallExpr (CallExpr* call);
@@ -57,15 +89,16 @@ class GVariantConsumer : public tartan::ASTChecker {
 public:
 	GVariantConsumer (CompilerInstance& compiler,
 	                  std::shared_ptr<const GirManager> gir_manager,
-	                  std::shared_ptr<const std::unordered_set<std::string>> disabled_plugins) :
+	                  std::shared_ptr<const std::unordered_set<std::string>> disabled_plugins,
+	                  std::shared_ptr<TypeManager> type_manager) :
 		ASTChecker (compiler, gir_manager, disabled_plugins),
-		_visitor (compiler) {}
+		_visitor (compiler, type_manager) {}
 
 private:
 	GVariantVisitor _visitor;
 
 public:
-	virtual void HandleTranslationUnit (ASTContext& context);
+	virtual void handle_call_expr (CallExpr& call);
 	const std::string get_name () const { return "gvariant"; }
 };
 
@@ -0,0 +1,401 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2026 Philip Withnall
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip@tecnocode.co.uk>
+ */
+
+#include <cassert>
+#include <cstring>
+
+#include "gvariant-type-tree.h"
+
+namespace tartan {
+
+/* What to do on seeing a given character in a given context. */
+typedef enum {
+	/* Add a node of the rule’s kind. If the kind has children, parse them
+	 * in the rule’s child context. */
+	ACTION_NODE,
+	/* Interpret the character again in the rule’s child context. */
+	ACTION_DELEGATE,
+	/* The character is not valid here. */
+	ACTION_ERROR,
+} RuleAction;
+
+typedef struct {
+	/* The character the rule applies to, or '\0' for the default rule
+	 * which ends each table. */
+	char type_char;
+	RuleAction action;
+	GVariantTypeNode::Kind kind;
+	GVariantTypeTree::Context child_context;
+} Rule;
+
+/* Reference: GVariant Format Strings documentation, §Syntax. */
+static const Rule format_rules[] = {
+	{ '@', ACTION_NODE, GVariantTypeNode::KIND_AS_GVARIANT,
+	  GVariantTypeTree::CONTEXT_TYPE },
+	{ 'm', ACTION_NODE, GVariantTypeNode::KIND_MAYBE,
+	  GVariantTypeTree::CONTEXT_FORMAT },
+	{ '*', ACTION_NODE, GVariantTypeNode::KIND_VARIANT,
+	  GVariantTypeTree::CONTEXT_FORMAT },
+	{ '?', ACTION_NODE, GVariantTypeNode::KIND_VARIANT,
+	  GVariantTypeTree::CONTEXT_FORMAT },
+	{ 'r', ACTION_NODE, GVariantTypeNode::KIND_VARIANT,
+	  GVariantTypeTree::CONTEXT_FORMAT },
+	{ '(', ACTION_NODE, GVariantTypeNode::KIND_TUPLE,
+	  GVariantTypeTree::CONTEXT_FORMAT },
+	{ '{', ACTION_NODE, GVariantTypeNode::KIND_DICT_ENTRY,
+	  GVariantTypeTree::CONTEXT_FORMAT },
+	{ '&', ACTION_NODE, GVariantTypeNode::KIND_NO_COPY,
+	  GVariantTypeTree::CONTEXT_TYPE },
+	{ '^', ACTION_DELEGATE, GVariantTypeNode::KIND_CONVENIENCE,
+	  GVariantTypeTree::CONTEXT_BASIC_FORMAT },
+	/* Assume it’s a type string. */
+	{ '\0', ACTION_DELEGATE, GVariantTypeNode::KIND_BASIC,
+	  GVariantTypeTree::CONTEXT_TYPE },
+};
+
+static const Rule basic_format_rules[] = {
+	{ '@', ACTION_NODE, GVariantTypeNode::KIND_AS_GVARIANT,
+	  GVariantTypeTree::CONTEXT_BASIC_TYPE },
+	{ '?', ACTION_NODE, GVariantTypeNode::KIND_VARIANT,
+	  GVariantTypeTree::CONTEXT_BASIC_FORMAT },
+	{ '&', ACTION_NODE, GVariantTypeNode::KIND_NO_COPY,
+	  GVariantTypeTree::CONTEXT_BASIC_TYPE },
+	{ '^', ACTION_NODE, GVariantTypeNode::KIND_CONVENIENCE,
+	  GVariantTypeTree::CONTEXT_BASIC_FORMAT },
+	{ '\0', ACTION_DELEGATE, GVariantTypeNode::KIND_BASIC,
+	  GVariantTypeTree::CONTEXT_BASIC_TYPE },
+};
+
+/* Reference: GVariant Type Strings. */
+static const Rule type_rules[] = {
+	{ 'v', ACTION_NODE, GVariantTypeNode::KIND_VARIANT,
+	  GVariantTypeTree::CONTEXT_TYPE },
+	{ 'a', ACTION_NODE, GVariantTypeNode::KIND_ARRAY,
+	  GVariantTypeTree::CONTEXT_TYPE },
+	{ 'm', ACTION_NODE, GVariantTypeNode::KIND_MAYBE,
+	  GVariantTypeTree::CONTEXT_TYPE },
+	{ '(', ACTION_NODE, GVariantTypeNode::KIND_TUPLE,
+	  GVariantTypeTree::CONTEXT_TYPE },
+	/* FIXME: Validate that the GVariant* for ‘r’ has a tuple type. */
+	{ 'r', ACTION_NODE, GVariantTypeNode::KIND_VARIANT,
+	  GVariantTypeTree::CONTEXT_TYPE },
+	{ '{', ACTION_NODE, GVariantTypeNode::KIND_DICT_ENTRY,
+	  GVariantTypeTree::CONTEXT_TYPE },
+	{ '*', ACTION_NODE, GVariantTypeNode::KIND_VARIANT,
+	  GVariantTypeTree::CONTEXT_TYPE },
+	/* Fall back to basic types. */
+	{ '\0', ACTION_DELEGATE, GVariantTypeNode::KIND_BASIC,
+	  GVariantTypeTree::CONTEXT_BASIC_TYPE },
+};
+
+static const Rule basic_type_rules[] = {
+	{ 'b', ACTION_NODE, GVariantTypeNode::KIND_BASIC,
+	  GVariantTypeTree::CONTEXT_BASIC_TYPE },
+	{ 'y', ACTION_NODE, GVariantTypeNode::KIND_BASIC,
+	  GVariantTypeTree::CONTEXT_BASIC_TYPE },
+	{ 'n', ACTION_NODE, GVariantTypeNode::KIND_BASIC,
+	  GVariantTypeTree::CONTEXT_BASIC_TYPE },
+	{ 'q', ACTION_NODE, GVariantTypeNode::KIND_BASIC,
+	  GVariantTypeTree::CONTEXT_BASIC_TYPE },
+	{ 'i', ACTION_NODE, GVariantTypeNode::KIND_BASIC,
+	  GVariantTypeTree::CONTEXT_BASIC_TYPE },
+	{ 'h', ACTION_NODE, GVariantTypeNode::KIND_BASIC,
+	  GVariantTypeTree::CONTEXT_BASIC_TYPE },
+	{ 'u', ACTION_NODE, GVariantTypeNode::KIND_BASIC,
+	  GVariantTypeTree::CONTEXT_BASIC_TYPE },
+	{ 'x', ACTION_NODE, GVariantTypeNode::KIND_BASIC,
+	  GVariantTypeTree::CONTEXT_BASIC_TYPE },
+	{ 't', ACTION_NODE, GVariantTypeNode::KIND_BASIC,
+	  GVariantTypeTree::CONTEXT_BASIC_TYPE },
+	{ 'd', ACTION_NODE, GVariantTypeNode::KIND_BASIC,
+	  GVariantTypeTree::CONTEXT_BASIC_TYPE },
+	{ 's', ACTION_NODE, GVariantTypeNode::KIND_BASIC,
+	  GVariantTypeTree::CONTEXT_BASIC_TYPE },
+	{ 'o', ACTION_NODE, GVariantTypeNode::KIND_BASIC,
+	  GVariantTypeTree::CONTEXT_BASIC_TYPE },
+	{ 'g', ACTION_NODE, GVariantTypeNode::KIND_BASIC,
+	  GVariantTypeTree::CONTEXT_BASIC_TYPE },
+	{ '?', ACTION_NODE, GVariantTypeNode::KIND_VARIANT,
+	  GVariantTypeTree::CONTEXT_BASIC_TYPE },
+	{ '\0', ACTION_ERROR, GVariantTypeNode::KIND_BASIC,
+	  GVariantTypeTree::CONTEXT_BASIC_TYPE },
+};
+
+/* Indexed by GVariantTypeTree::Context. */
+static const Rule *context_rules[] = {
+	format_rules,
+	basic_format_rules,
+	type_rules,
+	basic_type_rules,
+};
+
+/* The convenience conversions which may follow a ‘^’, from
+ * §Convenience Conversions. These are matched as prefixes, in order. */
+static const char *convenience_conversions[] = {
+	"as",
+	"ao",
+	"a&s",
+	"a&o",
+	"aay",
+	"ay",
+	"&ay",
+	"a&ay",
+};
+
+/* State of a node whose children are being parsed. */
+typedef struct {
+	/* Index of the node, or GVariantTypeNode::NO_PARENT for the root of
+	 * the string, which has a single child. */
+	unsigned int node;
+	/* Context to parse the node’s children in. */
+	GVariantTypeTree::Context context;
+	unsigned int n_children;
+} Frame;
+
+static const Rule *
+_find_rule (GVariantTypeTree::Context context, char c)
+{
+	const Rule *rule;
+
+	for (rule = context_rules[context];
+	     rule->type_char != '\0' && rule->type_char != c; rule++);
+
+	return rule;
+}
+
+/* Length of the convenience conversion at @str (just after the ‘^’), or 0 if
+ * there isn’t a recognised one. */
+static unsigned int
+_convenience_conversion_length (const char *str)
+{
+	for (unsigned int i = 0;
+	     i < sizeof (convenience_conversions) /
+	         sizeof (*convenience_conversions); i++) {
+		size_t len = strlen (convenience_conversions[i]);
+
+		if (strncmp (str, convenience_conversions[i], len) == 0)
+			return len;
+	}
+
+	return 0;
+}
+
+bool
+GVariantTypeTree::_set_error (const char *error)
+{
+	this->_error = error;
+	return false;
+}
+
+/* Parse @str, which is a nul-terminated string in the given @context, replacing
+ * the tree’s current contents. @str must remain valid for as long as the
+ * tree’s node texts are used. Returns false on error. */
+bool
+GVariantTypeTree::parse (const char *str, Context context)
+{
+	bool is_format = (context == CONTEXT_FORMAT ||
+	                  context == CONTEXT_BASIC_FORMAT);
+	const char *p = str;
+	std::vector<Frame> stack;
+
+	this->_str = llvm::StringRef (str);
+	this->_nodes.clear ();
+	this->_error = NULL;
+	this->_error_args.clear ();
+
+	Frame root = { GVariantTypeNode::NO_PARENT, context, 0 };
+	stack.push_back (root);
+
+	while (true) {
+		Frame &frame = stack.back ();
+		Context child_context = frame.context;
+		bool frame_is_format = (frame.context == CONTEXT_FORMAT);
+
+		/* Work out whether the frame’s node is finished, or which
+		 * context its next child should be parsed in. */
+		if (frame.node == GVariantTypeNode::NO_PARENT) {
+			if (frame.n_children == 1)
+				break;
+		} else {
+			GVariantTypeNode::Kind kind = this->_nodes[frame.node].kind;
+			bool finished = false;
+
+			switch (kind) {
+			case GVariantTypeNode::KIND_TUPLE:
+				if (*p == ')') {
+					finished = true;
+				} else if (*p == '\0') {
+					return this->_set_error (frame_is_format ?
+						"Invalid GVariant format string: "
+						"tuple did not end with ‘)’." :
+						"Invalid GVariant type string: "
+						"tuple did not end with ‘)’.");
+				}
+
+				break;
+			case GVariantTypeNode::KIND_DICT_ENTRY:
+				if (frame.n_children < 2 && *p == '}') {
+					return this->_set_error (frame_is_format ?
+						"Invalid GVariant format string: "
+						"dict did not contain exactly two "
+						"elements." :
+						"Invalid GVariant type string: "
+						"dict did not contain exactly two "
+						"elements.");
+				} else if (frame.n_children == 0) {
+					/* The key must be a basic type. */
+					child_context = frame_is_format ?
+						CONTEXT_BASIC_FORMAT :
+						CONTEXT_BASIC_TYPE;
+				} else if (frame.n_children == 2 &&
+				           *p == '\0') {
+					return this->_set_error (frame_is_format ?
+						"Invalid GVariant format string: "
+						"dict did not end with ‘}’." :
+						"Invalid GVariant type string: "
+						"dict did not end with ‘}’.");
+				} else if (frame.n_children == 2 &&
+				           *p != '}') {
+					return this->_set_error (frame_is_format ?
+						"Invalid GVariant format string: "
+						"dict contains more than two "
+						"elements." :
+						"Invalid GVariant type string: "
+						"dict contains more than two "
+						"elements.");
+				} else if (frame.n_children == 2) {
+					finished = true;
+				}
+
+				break;
+			case GVariantTypeNode::KIND_ARRAY:
+			case GVariantTypeNode::KIND_MAYBE:
+			case GVariantTypeNode::KIND_AS_GVARIANT:
+			case GVariantTypeNode::KIND_NO_COPY:
+				finished = (frame.n_children == 1);
+				break;
+			case GVariantTypeNode::KIND_BASIC:
+			case GVariantTypeNode::KIND_VARIANT:
+			case GVariantTypeNode::KIND_CONVENIENCE:
+			default:
+				/* Leaves never have frames. */
+				assert (false);
+			}
+
+			if (finished) {
+				GVariantTypeNode &node = this->_nodes[frame.node];
+
+				/* Consume any closing bracket. */
+				if (kind == GVariantTypeNode::KIND_TUPLE ||
+				    kind == GVariantTypeNode::KIND_DICT_ENTRY)
+					p++;
+
+				node.end = this->_nodes.size ();
+				node.length = (p - str) - node.offset;
+				stack.pop_back ();
+
+				continue;
+			}
+		}
+
+		/* Parse the next child of the frame’s node. */
+		const Rule *rule = _find_rule (child_context, *p);
+
+		while (rule->action == ACTION_DELEGATE) {
+			child_context = rule->child_context;
+			rule = _find_rule (child_context, *p);
+		}
+
+		if (rule->action == ACTION_ERROR) {
+			this->_error_args.push_back (std::string (1, *p));
+			return this->_set_error ("Expected a GVariant basic type "
+			                         "string but saw ‘%0’.");
+		}
+
+		GVariantTypeNode node;
+		node.kind = rule->kind;
+		node.type_char = *p;
+		node.parent = frame.node;
+		node.end = 0;
+		node.offset = p - str;
+		node.length = 1;
+
+		if (node.kind == GVariantTypeNode::KIND_CONVENIENCE) {
+			unsigned int len = _convenience_conversion_length (p + 1);
+
+			if (len == 0) {
+				return this->_set_error (
+					"Invalid GVariant basic format string: "
+					"convenience operator ‘^’ was not "
+					"followed by a recognized convenience "
+					"conversion.");
+			}
+
+			node.length += len;
+		}
+
+		frame.n_children++;
+		p += node.length;
+		this->_nodes.push_back (node);
+
+		switch (node.kind) {
+		case GVariantTypeNode::KIND_BASIC:
+		case GVariantTypeNode::KIND_VARIANT:
+		case GVariantTypeNode::KIND_CONVENIENCE:
+			this->_nodes.back ().end = this->_nodes.size ();
+			break;
+		case GVariantTypeNode::KIND_ARRAY:
+		case GVariantTypeNode::KIND_MAYBE:
+		case GVariantTypeNode::KIND_TUPLE:
+		case GVariantTypeNode::KIND_DICT_ENTRY:
+		case GVariantTypeNode::KIND_AS_GVARIANT:
+		case GVariantTypeNode::KIND_NO_COPY:
+		default: {
+			/* Note: This invalidates @frame. */
+			Frame child = { (unsigned int) (this->_nodes.size () - 1),
+			                rule->child_context, 0 };
+			stack.push_back (child);
+			break;
+		}
+		}
+	}
+
+	/* Sanity check that the whole string has been consumed. If not, the
+	 * user has probably forgotten to add tuple brackets around their format
+	 * string. */
+	if (*p != '\0') {
+		this->_error_args.push_back (p);
+		this->_error_args.push_back (str);
+
+		return this->_set_error (is_format ?
+			"Unexpected GVariant format strings ‘%0’ with "
+			"unpaired arguments. If using multiple format "
+			"strings, they should be enclosed in brackets to "
+			"create a tuple (e.g. ‘(%1)’)." :
+			"Invalid GVariant type string: unexpected "
+			"characters ‘%0’ after a complete type.");
+	}
+
+	return true;
+}
+
+} /* namespace tartan */
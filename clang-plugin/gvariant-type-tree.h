@@ -0,0 +1,133 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2026 Philip Withnall
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip@tecnocode.co.uk>
+ */
+
+#ifndef TARTAN_GVARIANT_TYPE_TREE_H
+#define TARTAN_GVARIANT_TYPE_TREE_H
+
+#include <string>
+#include <vector>
+
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringRef.h>
+
+namespace tartan {
+
+/* A single element of a parsed GVariant type or format string. */
+struct GVariantTypeNode {
+	enum Kind {
+		/* A basic type other than ‘?’: one of ‘bynqihuxtdsog’. */
+		KIND_BASIC,
+		/* A value passed as a GVariant*: ‘v’, ‘?’, ‘*’ or ‘r’. */
+		KIND_VARIANT,
+		/* ‘a’, followed by one child: the element type. */
+		KIND_ARRAY,
+		/* ‘m’, followed by one child. */
+		KIND_MAYBE,
+		/* ‘(’ and ‘)’, around any number of children. */
+		KIND_TUPLE,
+		/* ‘{’ and ‘}’, around exactly two children. */
+		KIND_DICT_ENTRY,
+		/* ‘@’ in a format string, followed by one child. */
+		KIND_AS_GVARIANT,
+		/* ‘&’ in a format string, followed by one child. */
+		KIND_NO_COPY,
+		/* A ‘^’ convenience conversion in a format string, such as ‘^as’.
+		 * It has no children; the whole conversion is its text. */
+		KIND_CONVENIENCE,
+	};
+
+	static const unsigned int NO_PARENT = ~0U;
+
+	Kind kind;
+	/* First character of the node’s text. */
+	char type_char;
+	/* Index of the parent node, or %NO_PARENT. */
+	unsigned int parent;
+	/* Index one past the node’s last descendant, or 0 if parsing stopped
+	 * at an error before the node was complete. */
+	unsigned int end;
+	/* Position and length of the node’s text in the parsed string. */
+	unsigned int offset;
+	unsigned int length;
+
+	bool is_complete () const { return this->end != 0; }
+};
+
+/* A GVariant type string or format string, parsed into a flat tree: its nodes
+ * are stored in pre-order, so each node is followed by its descendants, and
+ * parents always come before their children.
+ *
+ * The parser is table-driven and keeps its own stack rather than recursing,
+ * so it runs in time linear in the length of the string however deeply the
+ * types in it are nested.
+ *
+ * Parsing stops at the first error. The nodes before it are kept (with those
+ * still open at the error marked as incomplete), and the error is available
+ * as a Clang diagnostic format string, with its arguments. */
+class GVariantTypeTree {
+public:
+	enum Context {
+		/* A GVariant format string, as passed to g_variant_new(). */
+		CONTEXT_FORMAT,
+		/* A basic format string, such as a dictionary key. */
+		CONTEXT_BASIC_FORMAT,
+		/* A GVariant type string. */
+		CONTEXT_TYPE,
+		/* A basic type string. */
+		CONTEXT_BASIC_TYPE,
+	};
+
+	GVariantTypeTree () : _error (NULL) {}
+
+private:
+	llvm::StringRef _str;
+	std::vector<GVariantTypeNode> _nodes;
+	const char *_error;
+	llvm::SmallVector<std::string, 2> _error_args;
+
+	bool _set_error (const char *error);
+
+public:
+	bool parse (const char *str, Context context);
+
+	const std::vector<GVariantTypeNode>& get_nodes () const
+	{
+		return this->_nodes;
+	}
+
+	llvm::StringRef get_text (const GVariantTypeNode& node) const
+	{
+		return this->_str.substr (node.offset, node.length);
+	}
+
+	/* NULL if the string was parsed successfully. */
+	const char *get_error () const { return this->_error; }
+
+	const llvm::SmallVectorImpl<std::string>& get_error_args () const
+	{
+		return this->_error_args;
+	}
+};
+
+} /* namespace tartan */
+
+#endif /* !TARTAN_GVARIANT_TYPE_TREE_H */
@@ -0,0 +1,129 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2026 Philip Withnall
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip@tecnocode.co.uk>
+ */
+
+#include <algorithm>
+#include <iterator>
+
+#include <clang/AST/Attr.h>
+
+#include "debug.h"
+#include "nonnull-accumulator.h"
+
+namespace tartan {
+
+/* Record that the parameter at (zero-based) @param_index of @func should be
+ * non-NULL. Duplicates are fine. */
+void
+NonNullAccumulator::add (const FunctionDecl& func, unsigned int param_index)
+{
+	this->_pending[&func].push_back (param_index);
+}
+
+/* Give @func an implicit NonNullAttr covering the parameters added for it
+ * which aren’t already covered by its existing NonNullAttrs. The existing
+ * attributes (such as those written in the source) are left alone, so they
+ * still appear in diagnostics and AST dumps as the user wrote them. */
+void
+NonNullAccumulator::finalise (FunctionDecl& func)
+{
+	PendingMap::iterator pending = this->_pending.find (&func);
+	if (pending == this->_pending.end ())
+		return;
+
+	llvm::SmallVector<unsigned int, 4> added;
+	added.swap (pending->second);
+	this->_pending.erase (pending);
+
+	llvm::SmallVector<unsigned int, 4> existing;
+
+	for (specific_attr_iterator<NonNullAttr> it =
+	     func.specific_attr_begin<NonNullAttr> (),
+	     ie = func.specific_attr_end<NonNullAttr> (); it != ie; ++it) {
+		const NonNullAttr *attr = *it;
+
+		/* An attribute with no arguments applies to all pointer
+		 * parameters, so there’s nothing to add. */
+		if (attr->args_size () == 0)
+			return;
+
+		for (NonNullAttr::args_iterator ai = attr->args_begin (),
+		     ae = attr->args_end (); ai != ae; ++ai) {
+			/* ParamIdx is 1-based. */
+			existing.push_back (ai->getSourceIndex () - 1);
+		}
+	}
+
+	std::sort (existing.begin (), existing.end ());
+	std::sort (added.begin (), added.end ());
+	added.erase (std::unique (added.begin (), added.end ()), added.end ());
+
+	llvm::SmallVector<unsigned int, 4> missing;
+	std::set_difference (added.begin (), added.end (),
+	                     existing.begin (), existing.end (),
+	                     std::back_inserter (missing));
+
+	if (missing.empty ()) {
+		DEBUG ("Existing nonnull attributes already cover " <<
+		       func.getNameAsString () << "().");
+		return;
+	}
+
+	std::vector<ParamIdx> non_null_args;
+
+	for (llvm::SmallVectorImpl<unsigned int>::const_iterator it =
+	     missing.begin (), ie = missing.end (); it != ie; ++it) {
+		/* ParamIdx is 1-based. */
+		non_null_args.push_back (ParamIdx (*it + 1, &func));
+	}
+
+	DEBUG ("Adding implicit nonnull attribute with " <<
+	       non_null_args.size () << " args to " <<
+	       func.getNameAsString () << "().");
+
+	NonNullAttr *nonnull_attr =
+		NonNullAttr::CreateImplicit (func.getASTContext (),
+		                             non_null_args.data (),
+		                             non_null_args.size ());
+	nonnull_attr->setRange (func.getSourceRange ());
+	func.addAttr (nonnull_attr);
+}
+
+bool
+NonNullAttributesConsumer::HandleTopLevelDecl (DeclGroupRef decl_group)
+{
+	DeclGroupRef::iterator i, e;
+
+	for (i = decl_group.begin (), e = decl_group.end (); i != e; i++) {
+		Decl *decl = *i;
+		FunctionDecl *func = dyn_cast<FunctionDecl> (decl);
+
+		/* We’re only interested in function declarations. */
+		if (func == NULL)
+			continue;
+
+		this->_accumulator->finalise (*func);
+	}
+
+	return true;
+}
+
+} /* namespace tartan */
@@ -0,0 +1,77 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2026 Philip Withnall
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip@tecnocode.co.uk>
+ */
+
+#ifndef TARTAN_NONNULL_ACCUMULATOR_H
+#define TARTAN_NONNULL_ACCUMULATOR_H
+
+#include <memory>
+#include <unordered_map>
+
+#include <clang/AST/AST.h>
+#include <clang/AST/ASTConsumer.h>
+#include <llvm/ADT/SmallVector.h>
+
+namespace tartan {
+
+using namespace clang;
+
+/* Collects the parameters which the annotaters have found to be non-NULL, so
+ * that each function is given at most one implicit NonNullAttr covering those
+ * which its own attributes don’t, rather than one more for each annotater (or
+ * assertion) which finds some.
+ *
+ * Parameters are added while the annotaters handle a top-level declaration,
+ * and the attribute is built when the declaration is finalised, after all of
+ * them have. */
+class NonNullAccumulator {
+public:
+	void add (const FunctionDecl& func, unsigned int param_index);
+	void finalise (FunctionDecl& func);
+
+private:
+	/* Zero-based indices of the parameters which haven’t been added to an
+	 * attribute yet, by declaration. */
+	typedef std::unordered_map<const FunctionDecl*,
+	                           llvm::SmallVector<unsigned int, 4>>
+		PendingMap;
+	PendingMap _pending;
+};
+
+/* Finalises the NonNullAccumulator for each top-level function declaration.
+ * This must come after all the annotaters which use the accumulator in the
+ * list of consumers. */
+class NonNullAttributesConsumer : public clang::ASTConsumer {
+public:
+	explicit NonNullAttributesConsumer (
+		std::shared_ptr<NonNullAccumulator> accumulator) :
+		_accumulator (accumulator) {}
+
+private:
+	std::shared_ptr<NonNullAccumulator> _accumulator;
+
+public:
+	virtual bool HandleTopLevelDecl (DeclGroupRef decl_group);
+};
+
+} /* namespace tartan */
+
+#endif /* !TARTAN_NONNULL_ACCUMULATOR_H */
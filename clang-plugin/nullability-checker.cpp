@@ -65,21 +65,33 @@
 
 #include <clang/AST/Attr.h>
 
-#include "assertion-extracter.h"
 #include "debug.h"
 #include "nullability-checker.h"
 
 namespace tartan {
 
-void
-NullabilityConsumer::HandleTranslationUnit (ASTContext& context)
+/* Whether any of @func’s NonNullAttrs cover the parameter at (zero-based)
+ * @idx. A function can have several: those written in the source, and one
+ * added by the annotaters for the parameters they don’t cover. */
+static bool
+_is_nonnull_param (const FunctionDecl& func, unsigned int idx)
 {
-	/* Run away if the plugin is disabled. */
-	if (!this->is_enabled ()) {
-		return;
+	for (specific_attr_iterator<NonNullAttr> it =
+	     func.specific_attr_begin<NonNullAttr> (),
+	     ie = func.specific_attr_end<NonNullAttr> (); it != ie; ++it) {
+		if ((*it)->isNonNull (idx))
+			return true;
 	}
 
-	this->_visitor.TraverseDecl (context.getTranslationUnitDecl ());
+	return false;
+}
+
+/* Called by ASTDispatchConsumer, which has already checked this checker is
+ * enabled. */
+void
+NullabilityConsumer::handle_function_decl (FunctionDecl& func)
+{
+	this->_visitor.TraverseFunctionDecl (&func);
 }
 
 /* Note: Specifically overriding the Traverse* method here to re-implement
@@ -112,90 +124,73 @@ NullabilityVisitor::TraverseFunctionDecl (FunctionDecl* func)
 
 	/* For each parameter, check whether it has a (nullable) annotation,
 	 * a nonnull attribute, and a non-NULL assertion. */
-	NonNullAttr* nonnull_attr = func->getAttr<NonNullAttr> ();
+	bool has_nonnull_attr = func->hasAttr<NonNullAttr> ();
 
-	if (nonnull_attr != NULL) {
+	for (specific_attr_iterator<NonNullAttr> it =
+	     func->specific_attr_begin<NonNullAttr> (),
+	     ie = func->specific_attr_end<NonNullAttr> (); it != ie; ++it) {
 		DEBUG ("nonnull attribute indices:");
-		for (NonNullAttr::args_iterator it = nonnull_attr->args_begin (),
-		     ie = nonnull_attr->args_end (); it != ie; ++it) {
-			DEBUG ("\t" << it->getSourceIndex ());
+		for (NonNullAttr::args_iterator ai = (*it)->args_begin (),
+		     ae = (*it)->args_end (); ai != ae; ++ai) {
+			DEBUG ("\t" << ai->getSourceIndex ());
 		}
-	} else {
-		DEBUG ("No nonnull attribute.");
 	}
 
-	/* Try to find typelib information about the function. */
-	std::string func_name = func->getNameAsString ();  /* TODO: expensive? */
-	GIBaseInfo* info =
-		this->_gir_manager.get ()->find_function_info (func_name);
-
-	if (info == NULL)
-		return true;
+	if (!has_nonnull_attr)
+		DEBUG ("No nonnull attribute.");
 
-	if (g_base_info_get_type (info) != GI_INFO_TYPE_FUNCTION) {
-		WARN ("Error: Unhandled GI type " <<
-		      g_base_info_get_type (info) << " in introspection info "
-		      "for function ‘" << func_name << "’.");
+	/* Try to find typelib information about the function. Functions
+	 * without a plain identifier as their name (such as C++ operators)
+	 * can’t have any. */
+	const IdentifierInfo *func_ident = func->getIdentifier ();
+	if (func_ident == NULL)
 		return true;
-	}
-
-	/* Parse the function’s body for assertions. */
-	std::unordered_set<const ValueDecl*> asserted_parms;
-	ASTContext& context = func->getASTContext ();
 
-	/* Iterate through the function body until the first non-assertion and
-	 * non-declaration statement is reached. Specifically stop before the
-	 * first assignment, as that could affect the outcome of any subsequent
-	 * assertions. */
-	for (CompoundStmt::const_body_iterator it = body_stmt->body_begin (),
-	     ie = body_stmt->body_end (); it != ie; ++it) {
-		Stmt* st = *it;
+	llvm::StringRef func_name = func_ident->getName ();
+	const FunctionSummary *summary =
+		this->_gir_manager.get ()->find_function_summary (func_name);
 
-		Expr* assertion_expr =
-			AssertionExtracter::is_assertion_stmt (*st, context);
-
-		if (assertion_expr == NULL) {
-			/* Potential program state mutation reached, so run
-			 * away. */
-			break;
-		}
-
-		/* If the assertion is a non-NULL check, record the parameters
-		 * it checks. */
-		AssertionExtracter::assertion_is_nonnull_check (*assertion_expr,
-		                                                context,
-		                                                asserted_parms);
-	}
+	if (summary == NULL || summary->n_c_params () != func->getNumParams ())
+		return true;
 
-	DEBUG ("");
+	/* The summary’s arguments don’t include the instance parameter of a
+	 * method, or the trailing #GError parameter of a throwing function;
+	 * neither can be (nullable). */
+	unsigned int obj_params =
+		summary->has_flag (FunctionSummary::IS_METHOD) ? 1 : 0;
 
-	GICallableInfo *callable_info = (GICallableInfo *) info;
+	/* Find the function’s precondition assertions. */
+	const std::unordered_set<const ValueDecl*>& asserted_parms =
+		this->_precondition_store->get_preconditions (*func).nonnull_decls;
 
 	/* Handle the parameters. */
 	for (FunctionDecl::param_const_iterator it = func->param_begin (),
 	     ie = func->param_end (); it != ie; ++it) {
 		ParmVarDecl* parm_decl = *it;
 		unsigned int idx = parm_decl->getFunctionScopeIndex ();
-		GIArgInfo arg;
-		GITypeInfo type_info;
 
 		/* Skip non-pointer arguments. */
 		if (!parm_decl->getType ()->isPointerType ())
 			continue;
 
-		g_callable_info_load_arg (callable_info, idx, &arg);
-		g_arg_info_load_type (&arg, &type_info);
-
 		enum {
 			EXPLICIT_NULLABLE,  /* 0 */
 			MAYBE,  /* ? */
 			EXPLICIT_NONNULL,  /* 1 */
 		} has_nonnull =
-			(nonnull_attr == NULL) ? MAYBE :
-			(nonnull_attr->isNonNull (idx)) ?
+			!has_nonnull_attr ? MAYBE :
+			_is_nonnull_param (*func, idx) ?
 				EXPLICIT_NONNULL: EXPLICIT_NULLABLE;
-		bool has_nullable = (g_arg_info_may_be_null (&arg) ||
-		                     g_arg_info_is_optional (&arg));
+		unsigned int arg_flags = 0;
+
+		if (idx >= obj_params && idx - obj_params < summary->n_args) {
+			arg_flags =
+				this->_gir_manager.get ()->get_arg_flags (
+					func_name, *summary, idx - obj_params);
+		}
+
+		bool has_nullable =
+			((arg_flags & FunctionSummary::ARG_NULLABLE) != 0);
 		bool has_assertion = (asserted_parms.count (parm_decl) > 0);
 
 		/* Analysis:
@@ -348,8 +343,6 @@ NullabilityVisitor::TraverseFunctionDecl (FunctionDecl* func)
 		}
 	}
 
-	g_base_info_unref (info);
-
 	return true;
 }
 
@@ -32,6 +32,7 @@
 
 #include "checker.h"
 #include "gir-manager.h"
+#include "precondition-store.h"
 
 namespace tartan {
 
@@ -40,14 +41,17 @@ using namespace clang;
 class NullabilityVisitor : public RecursiveASTVisitor<NullabilityVisitor> {
 public:
 	explicit NullabilityVisitor (CompilerInstance& compiler,
-	                             std::shared_ptr<const GirManager> gir_manager) :
+	                             std::shared_ptr<const GirManager> gir_manager,
+	                             std::shared_ptr<PreconditionStore> precondition_store) :
 		_compiler (compiler), _context (compiler.getASTContext ()),
-		_gir_manager (gir_manager) {}
+		_gir_manager (gir_manager),
+		_precondition_store (precondition_store) {}
 
 private:
 	CompilerInstance& _compiler;
 	const ASTContext& _context;
 	std::shared_ptr<const GirManager> _gir_manager;
+	std::shared_ptr<PreconditionStore> _precondition_store;
 
 public:
 	bool TraverseFunctionDecl (FunctionDecl* func);
@@ -57,15 +61,16 @@ class NullabilityConsumer : public tartan::ASTChecker {
 public:
 	NullabilityConsumer (CompilerInstance& compiler,
 	                     std::shared_ptr<const GirManager> gir_manager,
-	                     std::shared_ptr<const std::unordered_set<std::string>> disabled_plugins) :
+	                     std::shared_ptr<const std::unordered_set<std::string>> disabled_plugins,
+	                     std::shared_ptr<PreconditionStore> precondition_store) :
 		ASTChecker (compiler, gir_manager, disabled_plugins),
-		_visitor (compiler, gir_manager) {}
+		_visitor (compiler, gir_manager, precondition_store) {}
 
 private:
 	NullabilityVisitor _visitor;
 
 public:
-	virtual void HandleTranslationUnit (ASTContext& context);
+	virtual void handle_function_decl (FunctionDecl& func);
 	const std::string get_name () const { return "nullability"; }
 };
 
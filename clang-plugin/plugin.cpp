@@ -32,24 +32,48 @@
 #include <clang/AST/ASTConsumer.h>
 #include <clang/Frontend/CompilerInstance.h>
 #include <clang/Frontend/MultiplexConsumer.h>
+#include <clang/Lex/Preprocessor.h>
 #include <llvm/Support/raw_ostream.h>
 
+#include <mutex>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "ast-dispatcher.h"
 #include "debug.h"
 #include "gir-attributes.h"
 #include "gassert-attributes.h"
 #include "gerror-checker.h"
 #include "gsignal-checker.h"
 #include "gvariant-checker.h"
+#include "nonnull-accumulator.h"
 #include "nullability-checker.h"
+#include "stats.h"
+#include "typelib-dir-cache.h"
+#include "typelib-includes.h"
 
 using namespace clang;
 
 namespace tartan {
 
-/* Global GIR manager shared between AST and path-sensitive checkers. */
+/* Global GIR manager shared between AST and path-sensitive checkers, and
+ * between all the translation units compiled by this process. */
 std::shared_ptr<GirManager> global_gir_manager =
 	std::make_shared<GirManager> ();
 
+/* Typelibs waiting for one of their headers to be included, with
+ * --typelib-loading includes. */
+static std::shared_ptr<TypelibIncludeMap> global_typelib_includes =
+	std::make_shared<TypelibIncludeMap> ();
+
+/* Hosts which compile several translation units in one process call ParseArgs()
+ * for each of them. Each typelib directory only needs loading once per loading
+ * mode, so this records the ones which have been, keyed by mode and path. It
+ * also serialises changes to the typelib search path. */
+static std::mutex typelib_dirs_mutex;
+static std::unordered_set<std::string> loaded_typelib_dirs;
+
 /**
  * Plugin core.
  */
@@ -68,6 +92,22 @@ private:
 		VERBOSITY_VERBOSE,
 	}_verbosity = VERBOSITY_NORMAL;
 
+	/* How to load the typelibs found on the search path: either load them
+	 * all up front, or only register them and load each one the first time
+	 * a symbol with its C prefix is looked up. With
+	 * %TYPELIB_LOADING_INCLUDES, typelibs are only registered once the
+	 * translation unit includes one of their headers. */
+	enum {
+		TYPELIB_LOADING_ALL,
+		TYPELIB_LOADING_LAZY,
+		TYPELIB_LOADING_INCLUDES,
+	} _typelib_loading = TYPELIB_LOADING_ALL;
+
+	/* Which declarations the AST checkers look at. Shared with the
+	 * consumers, as ParseArgs may be called after they are created. */
+	std::shared_ptr<TraversalScope> _traversal_scope =
+		std::make_shared<TraversalScope> ();
+
 protected:
 	/* Note: This is called before ParseArgs, and must transfer ownership
 	 * of the ASTConsumer. The TartanAction object is destroyed immediately
@@ -75,7 +115,7 @@ protected:
 	 * state which is needed by the consumers. */
 	std::unique_ptr<ASTConsumer>
 	CreateASTConsumer (CompilerInstance &compiler,
-					   llvm::StringRef /* in_file */)
+					   llvm::StringRef in_file)
 	{
 		/* Try and prevent Tartan’s changes to the AST from actually
 		 * affecting compilation. See bug: 844/04c. */
@@ -94,60 +134,138 @@ protected:
 			return llvm::make_unique<ASTConsumer> ();
 		}
 
-		std::vector<std::unique_ptr<ASTConsumer>> consumers;
+		/* This is a no-op unless --typelib-loading is ‘includes’. */
+		compiler.getPreprocessor ().addPPCallbacks (
+			std::unique_ptr<PPCallbacks> (
+				new TypelibIncludeCallbacks (compiler,
+				                             global_typelib_includes,
+				                             global_gir_manager)));
 
-		/* Annotaters. */
-		consumers.push_back (std::unique_ptr<ASTConsumer> (
-			new GirAttributesConsumer (global_gir_manager)));
-		consumers.push_back (std::unique_ptr<ASTConsumer> (
-			new GAssertAttributesConsumer ()));
+		std::vector<std::unique_ptr<ASTConsumer>> consumers;
 
-		/* Checkers. */
-		consumers.push_back (std::unique_ptr<ASTConsumer> (
+		/* Shared so that each function’s preconditions are only
+		 * extracted once per translation unit. */
+		std::shared_ptr<PreconditionStore> precondition_store =
+			std::make_shared<PreconditionStore> (
+				compiler.getPreprocessor ());
+
+		/* Shared so that each function is given a single nonnull
+		 * attribute covering what all the annotaters find. */
+		std::shared_ptr<NonNullAccumulator> nonnull_accumulator =
+			std::make_shared<NonNullAccumulator> ();
+
+		/* Annotaters. The nonnull attributes must come after the
+		 * others. */
+		consumers.push_back (_timed ("gir-attributes-annotater",
+			new GirAttributesConsumer (global_gir_manager,
+			                           nonnull_accumulator)));
+		consumers.push_back (_timed ("gassert-attributes-annotater",
+			new GAssertAttributesConsumer (precondition_store,
+			                               nonnull_accumulator)));
+		consumers.push_back (_timed ("nonnull-attributes-annotater",
+			new NonNullAttributesConsumer (nonnull_accumulator)));
+
+		/* Checkers. Those which look at individual functions and calls
+		 * share a single traversal of the AST. */
+		ASTDispatchConsumer *dispatcher =
+			new ASTDispatchConsumer (this->_traversal_scope);
+		/* Shared so that the typedef index and well-known types are
+		 * only built once per translation unit. */
+		std::shared_ptr<TypeManager> type_manager =
+			std::make_shared<TypeManager> (compiler.getASTContext ());
+
+		dispatcher->add_checker (std::unique_ptr<ASTChecker> (
 			new NullabilityConsumer (compiler,
 			                         global_gir_manager,
-			                         this->_disabled_checkers)));
-		consumers.push_back (std::unique_ptr<ASTConsumer> (
+			                         this->_disabled_checkers,
+			                         precondition_store)));
+		dispatcher->add_checker (std::unique_ptr<ASTChecker> (
 			new GVariantConsumer (compiler,
 			                      global_gir_manager,
-			                      this->_disabled_checkers)));
-		consumers.push_back (std::unique_ptr<ASTConsumer> (
+			                      this->_disabled_checkers,
+			                      type_manager)));
+		dispatcher->add_checker (std::unique_ptr<ASTChecker> (
 			new GSignalConsumer (compiler,
 			                     global_gir_manager,
-			                     this->_disabled_checkers)));
-		consumers.push_back (std::unique_ptr<ASTConsumer> (
+			                     this->_disabled_checkers,
+			                     type_manager)));
+
+		/* Times its traversal and each checker separately. */
+		consumers.push_back (std::unique_ptr<ASTConsumer> (dispatcher));
+		consumers.push_back (_timed ("gir-attributes",
 			new GirAttributesChecker (compiler,
 			                          global_gir_manager,
 			                          this->_disabled_checkers)));
 
+		/* Reports --stats, so must come last. */
+		consumers.push_back (std::unique_ptr<ASTConsumer> (
+			new StatsConsumer (in_file.str ())));
+
 		return llvm::make_unique<MultiplexConsumer> (std::move (consumers));
 	}
 
 private:
+	/* Wrap @consumer so the time spent in it is reported by --stats. */
+	static std::unique_ptr<ASTConsumer>
+	_timed (const std::string& name, ASTConsumer *consumer)
+	{
+		return std::unique_ptr<ASTConsumer> (
+			new TimedConsumer (name,
+			                   std::unique_ptr<ASTConsumer> (consumer)));
+	}
+
+	/* Namespaces to load once all the typelibs on the search path have
+	 * been registered, as (namespace, version) pairs. */
+	typedef std::vector<std::pair<std::string, std::string>> PendingNspaces;
+
 	bool
 	_load_typelib (const CompilerInstance &CI,
-	               const std::string& gi_namespace_and_version)
+	               const TypelibDirCache::Entry& typelib,
+	               PendingNspaces& nspaces_to_load)
 	{
-		std::string::size_type p = gi_namespace_and_version.find ("-");
-
-		if (p == std::string::npos) {
-			/* Ignore it — probably a non-typelib file. */
-			return false;
+		const std::string& gi_namespace = typelib.nspace;
+		const std::string& gi_version = typelib.version;
+		const std::string& typelib_filename = typelib.path;
+
+		/* Defer registering typelibs until their headers are included,
+		 * if we know what their headers are. */
+		if (this->_typelib_loading == TYPELIB_LOADING_INCLUDES &&
+		    global_typelib_includes.get ()->add_typelib (gi_namespace,
+		                                                 gi_version,
+		                                                 typelib_filename)) {
+			return true;
 		}
 
-		std::string gi_namespace =
-			gi_namespace_and_version.substr (0, p);
-		std::string gi_version =
-			gi_namespace_and_version.substr (p + 1);
-
 		DEBUG ("Loading typelib " + gi_namespace + " " + gi_version);
 
-		/* Load the repository. */
+		/* Register the repository. It is loaded later, so that all the
+		 * typelibs can be preloaded at once. */
 		GError *error = NULL;
 
-		global_gir_manager.get ()->load_namespace (gi_namespace,
-		                                           gi_version,
-		                                           &error);
+		global_gir_manager.get ()->register_namespace (gi_namespace,
+		                                               gi_version,
+		                                               typelib_filename,
+		                                               &error);
+
+		if (error == NULL &&
+		    this->_typelib_loading == TYPELIB_LOADING_ALL) {
+			nspaces_to_load.push_back (std::make_pair (gi_namespace,
+			                                           gi_version));
+		}
+
+		return _report_load_error (CI, gi_namespace, gi_version, error);
+	}
+
+	/* Report a failure to register or load a GI repository as a warning,
+	 * and free @error. Version conflicts are expected when several
+	 * versions of a namespace are installed, so are not reported. Returns
+	 * %false if an error was reported. */
+	static bool
+	_report_load_error (const CompilerInstance &CI,
+	                    const std::string& gi_namespace,
+	                    const std::string& gi_version,
+	                    GError *error)
+	{
 		if (error != NULL &&
 		    !g_error_matches (error, G_IREPOSITORY_ERROR,
 		                      G_IREPOSITORY_ERROR_NAMESPACE_VERSION_CONFLICT)) {
@@ -171,25 +289,35 @@ private:
 	}
 
 	/* Load all the GI typelibs we can find. This shouldn’t take long, and
-	 * saves the user having to specify which typelibs to use (or us having
-	 * to try and work out which ones the user’s code uses by looking at
-	 * #included files). */
+	 * saves the user having to specify which typelibs to use. With
+	 * --typelib-loading includes, we instead work out which ones the user’s
+	 * code uses by looking at #included files. */
 	bool
 	_load_gi_repositories (const CompilerInstance &CI)
 	{
+		std::lock_guard<std::mutex> lock (typelib_dirs_mutex);
 		GSList/*<unowned string>*/ *typelib_paths, *l;
+		PendingNspaces nspaces_to_load;
+		std::string cache_dir =
+			global_gir_manager.get ()->get_cache_dir ();
 
 		typelib_paths = g_irepository_get_search_path ();
 
 		for (l = typelib_paths; l != NULL; l = l->next) {
-			GDir *dir;
-			const gchar *typelib_path, *typelib_filename;
+			const gchar *typelib_path;
+			std::vector<TypelibDirCache::Entry> typelibs;
 			GError *error = NULL;
 
 			typelib_path = (const gchar *) l->data;
-			dir = g_dir_open (typelib_path, 0, &error);
 
-			if (error != NULL) {
+			if (!loaded_typelib_dirs.insert (
+				std::to_string (this->_typelib_loading) + ":" +
+				typelib_path).second) {
+				continue;
+			}
+
+			if (!TypelibDirCache::list (cache_dir, typelib_path,
+			                            typelibs, &error)) {
 				/* Warn about the bogus include path and
 				 * continue. */
 				DiagnosticsEngine &d = CI.getDiagnostics ();
@@ -201,30 +329,54 @@ private:
 					<< typelib_path
 					<< error->message;
 
+				g_error_free (error);
+
 				continue;
 			}
 
-			while ((typelib_filename = g_dir_read_name (dir)) != NULL) {
-				if (!g_str_has_suffix (typelib_filename, ".typelib")) {
-					/* No ‘.typelib’ suffix — ignore. */
-					continue;
-				}
-
+			for (std::vector<TypelibDirCache::Entry>::const_iterator
+			     it = typelibs.begin (), ie = typelibs.end ();
+			     it != ie; ++it) {
 				/* Load the typelib. Ignore failure. */
-				std::string _typelib_filename (typelib_filename);
-				std::string::size_type last_dot = _typelib_filename.find_last_of (".");
-				g_assert (last_dot != std::string::npos);
-
-				std::string gi_namespace_and_version = _typelib_filename.substr (0, last_dot);
-				this->_load_typelib (CI, gi_namespace_and_version);
+				this->_load_typelib (CI, *it, nspaces_to_load);
 			}
+		}
+
+		/* Index the typelibs concurrently, after which loading each of
+		 * them is quick. Loading them here reports any errors. */
+		if (!nspaces_to_load.empty ())
+			global_gir_manager.get ()->preload_namespaces ();
+
+		for (PendingNspaces::const_iterator it = nspaces_to_load.begin (),
+		     ie = nspaces_to_load.end (); it != ie; ++it) {
+			GError *error = NULL;
 
-			g_dir_close (dir);
+			global_gir_manager.get ()->load_namespace (it->first,
+			                                           it->second,
+			                                           &error);
+			_report_load_error (CI, it->first, it->second, error);
 		}
 
 		return true;
 	}
 
+	/* Add @typelib_path to the start of the typelib search path, unless
+	 * it’s already on it. */
+	static void
+	_add_typelib_path (const std::string& typelib_path)
+	{
+		std::lock_guard<std::mutex> lock (typelib_dirs_mutex);
+
+		for (GSList *l = g_irepository_get_search_path ();
+		     l != NULL; l = l->next) {
+			if (typelib_path == (const gchar *) l->data) {
+				return;
+			}
+		}
+
+		g_irepository_prepend_search_path (typelib_path.c_str ());
+	}
+
 protected:
 	/* Parse command line arguments for the plugin. Note: This is called
 	 * after CreateASTConsumer. */
@@ -232,6 +384,9 @@ protected:
 	ParseArgs (const CompilerInstance &CI,
 	           const std::vector<std::string>& args)
 	{
+		/* Statistics are per translation unit. */
+		Stats::current ().reset ();
+
 		/* Enable the default set of checkers. */
 		for (std::vector<std::string>::const_iterator it = args.begin();
 		     it != args.end (); ++it) {
@@ -243,6 +398,8 @@ protected:
 				this->_verbosity = VERBOSITY_QUIET;
 			} else if (arg == "--verbose") {
 				this->_verbosity = VERBOSITY_VERBOSE;
+			} else if (arg == "--stats") {
+				Stats::current ().enabled = true;
 			} else if (arg == "--enable-checker") {
 				const std::string checker = *(++it);
 				if (checker == "all") {
@@ -254,12 +411,56 @@ protected:
 				const std::string checker = *(++it);
 				this->_disabled_checkers.get ()->insert (std::string (checker));
 			} else if (arg == "--typelib-path") {
-				g_irepository_prepend_search_path ((++it)->c_str ());
+				_add_typelib_path (*(++it));
+			} else if (arg == "--gir-cache-dir") {
+				global_gir_manager.get ()->set_cache_dir (*(++it));
+			} else if (arg == "--check-scope") {
+				const std::string scope = *(++it);
+				if (scope == "all") {
+					this->_traversal_scope->mode =
+						TraversalScope::SCOPE_ALL;
+				} else if (scope == "non-system") {
+					this->_traversal_scope->mode =
+						TraversalScope::SCOPE_NON_SYSTEM;
+				} else if (scope == "main-file") {
+					this->_traversal_scope->mode =
+						TraversalScope::SCOPE_MAIN_FILE;
+				} else {
+					DiagnosticsEngine &d = CI.getDiagnostics ();
+					unsigned int id = d.getCustomDiagID (
+						DiagnosticsEngine::Warning,
+						"Unknown check scope ‘%0’; expected "
+						"‘all’, ‘non-system’ or "
+						"‘main-file’.");
+					d.Report (id) << scope;
+				}
+			} else if (arg == "--check-directory") {
+				this->_traversal_scope->add_directory (*(++it));
+			} else if (arg == "--typelib-loading") {
+				const std::string mode = *(++it);
+				if (mode == "all") {
+					this->_typelib_loading = TYPELIB_LOADING_ALL;
+				} else if (mode == "lazy") {
+					this->_typelib_loading = TYPELIB_LOADING_LAZY;
+				} else if (mode == "includes") {
+					this->_typelib_loading = TYPELIB_LOADING_INCLUDES;
+				} else {
+					DiagnosticsEngine &d = CI.getDiagnostics ();
+					unsigned int id = d.getCustomDiagID (
+						DiagnosticsEngine::Warning,
+						"Unknown typelib loading mode ‘%0’; "
+						"expected ‘all’, ‘lazy’ or "
+						"‘includes’.");
+					d.Report (id) << mode;
+				}
 			}
 		}
 
 		/* Load all typelibs. */
-		this->_load_gi_repositories (CI);
+		{
+			StatsTimer timer (Stats::current ().typelib_scan);
+			this->_load_gi_repositories (CI);
+		}
 
 		/* Listen to the V environment variable (as standard in automake) too. */
 		const char *v_value = getenv ("V");
@@ -314,12 +515,46 @@ protected:
 		       "        enabled by default.\n"
 		       "    --typelib-path [path]\n"
 		       "        Add the given path to the search path for typelibs.\n"
+		       "    --gir-cache-dir [path]\n"
+		       "        Cache the GIR annotations from each typelib in "
+		               "the given directory,\n"
+		       "        so later compiler invocations don’t need to "
+		               "load the typelibs. The\n"
+		       "        listing of each typelib directory is cached "
+		               "there too.\n"
+		       "    --typelib-loading [mode]\n"
+		       "        How to load the typelibs on the search path: ‘all’ "
+		               "loads them all\n"
+		       "        before parsing (the default), ‘lazy’ loads each one "
+		               "the first time a\n"
+		       "        symbol or type from it is looked up, and "
+		               "‘includes’ additionally\n"
+		       "        ignores typelibs whose headers (as listed in "
+		               "their GIR files) are\n"
+		       "        not included by the code being checked.\n"
+		       "    --check-scope [scope]\n"
+		       "        Which declarations the nullability, gvariant and "
+		               "gsignal checkers\n"
+		       "        look at: ‘all’ (the default), ‘non-system’ to skip "
+		               "those in system\n"
+		       "        headers, or ‘main-file’ to skip those outside the "
+		               "main source file\n"
+		       "        and the --check-directory directories.\n"
+		       "    --check-directory [path]\n"
+		       "        With --check-scope main-file, also look at "
+		               "declarations in files\n"
+		       "        beneath the given directory. May be given "
+		               "multiple times.\n"
 		       "    --quiet\n"
 		       "        Disable all plugin output except code "
 		               "diagnostics (remarks,\n"
 		       "        warnings and errors).\n"
 		       "    --verbose\n"
 		       "        Output additional versioning information.\n"
+		       "    --stats\n"
+		       "        Print timing and lookup statistics to stderr "
+		               "as a line of JSON at\n"
+		       "        the end of each translation unit.\n"
 		       "\n"
 		       "Usage:\n"
 		       "    clang -cc1 -load /path/to/libtartan.so "
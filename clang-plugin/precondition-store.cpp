@@ -0,0 +1,101 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2026 Philip Withnall
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip@tecnocode.co.uk>
+ */
+
+#include "debug.h"
+#include "precondition-store.h"
+
+namespace tartan {
+
+/* Returns the preconditions of @func, which are empty if it has no body. The
+ * returned reference remains valid for the lifetime of the store. */
+const FunctionPreconditions&
+PreconditionStore::get_preconditions (const FunctionDecl& func)
+{
+	const FunctionDecl *definition = NULL;
+	Stmt *func_body = func.getBody (definition);
+
+	if (func_body == NULL)
+		return this->_no_preconditions;
+
+	std::unordered_map<const FunctionDecl*,
+	                   FunctionPreconditions>::iterator it =
+		this->_preconditions.find (definition);
+	if (it != this->_preconditions.end ())
+		return it->second;
+
+	FunctionPreconditions& preconditions =
+		this->_preconditions[definition];
+
+	this->_extract_preconditions (*func_body, definition->getASTContext (),
+	                              preconditions);
+
+	return preconditions;
+}
+
+void
+PreconditionStore::_extract_preconditions (Stmt& func_body,
+                                           const ASTContext& context,
+                                           FunctionPreconditions& preconditions)
+{
+	/* The body should be a compound statement, e.g.
+	 * { stmt; stmt; } */
+	CompoundStmt* stmt = dyn_cast<CompoundStmt> (&func_body);
+	if (stmt == NULL) {
+		DEBUG ("Ignoring function due to having a non-compound "
+		       "statement body.");
+		return;
+	}
+
+	/* The assertions’ conditions are only needed while examining this
+	 * function, and are freed with the arena at the end of it. */
+	AssertionExtracter::FormulaArena arena;
+
+	/* Iterate through the function body until the first non-assertion and
+	 * non-declaration statement is reached. Specifically stop before the
+	 * first assignment, as that could affect the outcome of any subsequent
+	 * assertions. */
+	for (CompoundStmt::const_body_iterator it = stmt->body_begin (),
+	     ie = stmt->body_end (); it != ie; ++it) {
+		Stmt* body_stmt = *it;
+
+		const AssertionExtracter::Formula* assertion =
+			AssertionExtracter::is_assertion_stmt (
+				*body_stmt, context, this->_assertion_cache,
+				arena);
+
+		if (assertion == NULL) {
+			/* Potential program state mutation reached, so run
+			 * away. */
+			break;
+		}
+
+		DEBUG_EXPR ("Extracted precondition: ", *assertion);
+
+		/* If the assertion is a non-NULL check, record the variables
+		 * it checks. */
+		AssertionExtracter::assertion_is_nonnull_check (
+			*assertion, context, arena,
+			preconditions.nonnull_decls);
+	}
+}
+
+} /* namespace tartan */
@@ -0,0 +1,75 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2026 Philip Withnall
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip@tecnocode.co.uk>
+ */
+
+#ifndef TARTAN_PRECONDITION_STORE_H
+#define TARTAN_PRECONDITION_STORE_H
+
+#include <unordered_map>
+#include <unordered_set>
+
+#include <clang/AST/AST.h>
+
+#include "assertion-extracter.h"
+
+namespace tartan {
+
+using namespace clang;
+
+/* The facts established by the precondition assertions at the start of a
+ * function’s body. */
+struct FunctionPreconditions {
+	/* Variables (normally the function’s parameters) which are asserted
+	 * to be non-NULL. */
+	std::unordered_set<const ValueDecl*> nonnull_decls;
+};
+
+/* Per-translation-unit store of the preconditions of each function with a
+ * body, extracted the first time they’re asked for. One of these should be
+ * shared by everything which looks at preconditions, so that each function’s
+ * preamble is only analysed once. */
+class PreconditionStore {
+public:
+	PreconditionStore (Preprocessor& preprocessor) :
+		_assertion_cache (preprocessor)
+	{
+	}
+
+	const FunctionPreconditions& get_preconditions (
+		const FunctionDecl& func);
+
+private:
+	void _extract_preconditions (Stmt& func_body,
+	                             const ASTContext& context,
+	                             FunctionPreconditions& preconditions);
+
+	AssertionExtracter::AssertionCache _assertion_cache;
+
+	/* Indexed by the declaration which has the body. */
+	std::unordered_map<const FunctionDecl*,
+	                   FunctionPreconditions> _preconditions;
+	/* Returned for functions without a body. */
+	FunctionPreconditions _no_preconditions;
+};
+
+} /* namespace tartan */
+
+#endif /* !TARTAN_PRECONDITION_STORE_H */
@@ -0,0 +1,366 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2026 Philip Withnall
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip@tecnocode.co.uk>
+ */
+
+/**
+ * Stats:
+ *
+ * The statistics are printed to stderr at the end of each translation unit as
+ * a single line of JSON, so that they can be picked out of the build log and
+ * tracked over time. Times are in nanoseconds. For lookups, a hit means that
+ * the function or type was found in the GIR metadata.
+ */
+
+#include "config.h"
+
+#include <chrono>
+
+#include <llvm/Support/Format.h>
+
+#include "stats.h"
+
+namespace tartan {
+
+Stats&
+Stats::current ()
+{
+	static thread_local Stats stats;
+	return stats;
+}
+
+guint64
+Stats::now ()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds> (
+		std::chrono::steady_clock::now ().time_since_epoch ()).count ();
+}
+
+void
+Stats::reset ()
+{
+	const Timer zero_timer = { 0, 0 };
+	const Lookup zero_lookup = { 0, 0, 0 };
+
+	this->enabled = false;
+
+	this->typelib_scan = zero_timer;
+	this->typelib_load = zero_timer;
+	this->gir_cache_maps = 0;
+	this->gir_cache_writes = 0;
+	this->typelib_dir_cache_hits = 0;
+
+	this->find_function_info = zero_lookup;
+	this->find_function_summary = zero_lookup;
+	this->find_object_info = zero_lookup;
+	this->object_info_cache_hits = 0;
+
+	this->type_scans = 0;
+	this->type_scan_types = 0;
+	this->type_scan_misses = 0;
+
+	this->consumers.clear ();
+}
+
+static void
+_add_timer (Stats::Timer& timer, const Stats::Timer& other)
+{
+	timer.count += other.count;
+	timer.total_ns += other.total_ns;
+}
+
+static void
+_add_lookup (Stats::Lookup& lookup, const Stats::Lookup& other)
+{
+	lookup.count += other.count;
+	lookup.hits += other.hits;
+	lookup.total_ns += other.total_ns;
+}
+
+/* Add the statistics recorded in @other, such as by a worker thread, to these
+ * ones. */
+void
+Stats::add (const Stats& other)
+{
+	_add_timer (this->typelib_scan, other.typelib_scan);
+	_add_timer (this->typelib_load, other.typelib_load);
+	this->gir_cache_maps += other.gir_cache_maps;
+	this->gir_cache_writes += other.gir_cache_writes;
+	this->typelib_dir_cache_hits += other.typelib_dir_cache_hits;
+
+	_add_lookup (this->find_function_info, other.find_function_info);
+	_add_lookup (this->find_function_summary, other.find_function_summary);
+	_add_lookup (this->find_object_info, other.find_object_info);
+	this->object_info_cache_hits += other.object_info_cache_hits;
+
+	this->type_scans += other.type_scans;
+	this->type_scan_types += other.type_scan_types;
+	this->type_scan_misses += other.type_scan_misses;
+
+	for (std::vector<std::pair<std::string, Timer>>::const_iterator it =
+	     other.consumers.begin (); it != other.consumers.end (); ++it)
+		_add_timer (this->consumer_timer (it->first), it->second);
+}
+
+/* Get the timer for the AST consumer called @name, adding it if needed. */
+Stats::Timer&
+Stats::consumer_timer (const std::string& name)
+{
+	for (std::vector<std::pair<std::string, Timer>>::iterator it =
+	     this->consumers.begin (); it != this->consumers.end (); ++it) {
+		if (it->first == name)
+			return it->second;
+	}
+
+	const Timer zero_timer = { 0, 0 };
+	this->consumers.push_back (std::make_pair (name, zero_timer));
+
+	return this->consumers.back ().second;
+}
+
+static void
+_print_json_string (llvm::raw_ostream& out, const std::string& str)
+{
+	out << '"';
+
+	for (std::string::const_iterator it = str.begin ();
+	     it != str.end (); ++it) {
+		unsigned char c = *it;
+
+		if (c == '"' || c == '\\')
+			out << '\\' << (char) c;
+		else if (c < 0x20)
+			out << llvm::format ("\\u%04x", c);
+		else
+			out << (char) c;
+	}
+
+	out << '"';
+}
+
+static void
+_print_timer (llvm::raw_ostream& out, const Stats::Timer& timer)
+{
+	out << "{\"count\": " << timer.count <<
+	       ", \"total_ns\": " << timer.total_ns << "}";
+}
+
+static void
+_print_lookup (llvm::raw_ostream& out, const Stats::Lookup& lookup)
+{
+	out << "{\"count\": " << lookup.count <<
+	       ", \"hits\": " << lookup.hits <<
+	       ", \"misses\": " << lookup.count - lookup.hits <<
+	       ", \"total_ns\": " << lookup.total_ns <<
+	       ", \"mean_ns\": " <<
+	       ((lookup.count > 0) ? lookup.total_ns / lookup.count : 0) <<
+	       "}";
+}
+
+void
+Stats::print (llvm::raw_ostream& out, const std::string& file) const
+{
+	out << "{\"tartan_stats\": 1, \"file\": ";
+	_print_json_string (out, file);
+
+	out << ", \"typelib_scan\": ";
+	_print_timer (out, this->typelib_scan);
+	out << ", \"typelib_load\": ";
+	_print_timer (out, this->typelib_load);
+	out << ", \"gir_cache_maps\": " << this->gir_cache_maps;
+	out << ", \"gir_cache_writes\": " << this->gir_cache_writes;
+	out << ", \"typelib_dir_cache_hits\": " <<
+	       this->typelib_dir_cache_hits;
+
+	out << ", \"find_function_info\": ";
+	_print_lookup (out, this->find_function_info);
+	out << ", \"find_function_summary\": ";
+	_print_lookup (out, this->find_function_summary);
+	out << ", \"find_object_info\": ";
+	_print_lookup (out, this->find_object_info);
+	out << ", \"object_info_cache_hits\": " <<
+	       this->object_info_cache_hits;
+
+	out << ", \"type_scans\": {\"count\": " << this->type_scans <<
+	       ", \"types_visited\": " << this->type_scan_types <<
+	       ", \"misses\": " << this->type_scan_misses << "}";
+
+	out << ", \"consumers\": {";
+
+	for (std::vector<std::pair<std::string, Timer>>::const_iterator it =
+	     this->consumers.begin (); it != this->consumers.end (); ++it) {
+		if (it != this->consumers.begin ())
+			out << ", ";
+
+		_print_json_string (out, it->first);
+		out << ": ";
+		_print_timer (out, it->second);
+	}
+
+	out << "}}\n";
+}
+
+void
+TimedConsumer::Initialize (ASTContext& context)
+{
+	this->_consumer->Initialize (context);
+}
+
+bool
+TimedConsumer::HandleTopLevelDecl (DeclGroupRef decl_group)
+{
+	StatsTimer timer (this->_name);
+	return this->_consumer->HandleTopLevelDecl (decl_group);
+}
+
+void
+TimedConsumer::HandleInlineFunctionDefinition (FunctionDecl *func)
+{
+	StatsTimer timer (this->_name);
+	this->_consumer->HandleInlineFunctionDefinition (func);
+}
+
+void
+TimedConsumer::HandleInterestingDecl (DeclGroupRef decl_group)
+{
+	StatsTimer timer (this->_name);
+	this->_consumer->HandleInterestingDecl (decl_group);
+}
+
+void
+TimedConsumer::HandleTranslationUnit (ASTContext& context)
+{
+	StatsTimer timer (this->_name);
+	this->_consumer->HandleTranslationUnit (context);
+}
+
+void
+TimedConsumer::HandleTagDeclDefinition (TagDecl *decl)
+{
+	StatsTimer timer (this->_name);
+	this->_consumer->HandleTagDeclDefinition (decl);
+}
+
+void
+TimedConsumer::HandleTagDeclRequiredDefinition (const TagDecl *decl)
+{
+	StatsTimer timer (this->_name);
+	this->_consumer->HandleTagDeclRequiredDefinition (decl);
+}
+
+void
+TimedConsumer::HandleCXXImplicitFunctionInstantiation (FunctionDecl *func)
+{
+	StatsTimer timer (this->_name);
+	this->_consumer->HandleCXXImplicitFunctionInstantiation (func);
+}
+
+void
+TimedConsumer::HandleTopLevelDeclInObjCContainer (DeclGroupRef decl_group)
+{
+	StatsTimer timer (this->_name);
+	this->_consumer->HandleTopLevelDeclInObjCContainer (decl_group);
+}
+
+void
+TimedConsumer::HandleImplicitImportDecl (ImportDecl *decl)
+{
+	StatsTimer timer (this->_name);
+	this->_consumer->HandleImplicitImportDecl (decl);
+}
+
+void
+TimedConsumer::CompleteTentativeDefinition (VarDecl *decl)
+{
+	StatsTimer timer (this->_name);
+	this->_consumer->CompleteTentativeDefinition (decl);
+}
+
+#if defined(HAVE_LLVM_19_0)
+void
+TimedConsumer::CompleteExternalDeclaration (DeclaratorDecl *decl)
+{
+	StatsTimer timer (this->_name);
+	this->_consumer->CompleteExternalDeclaration (decl);
+}
+#elif defined(HAVE_LLVM_10_0)
+void
+TimedConsumer::CompleteExternalDeclaration (VarDecl *decl)
+{
+	StatsTimer timer (this->_name);
+	this->_consumer->CompleteExternalDeclaration (decl);
+}
+#endif
+
+void
+TimedConsumer::AssignInheritanceModel (CXXRecordDecl *decl)
+{
+	StatsTimer timer (this->_name);
+	this->_consumer->AssignInheritanceModel (decl);
+}
+
+void
+TimedConsumer::HandleCXXStaticMemberVarInstantiation (VarDecl *decl)
+{
+	StatsTimer timer (this->_name);
+	this->_consumer->HandleCXXStaticMemberVarInstantiation (decl);
+}
+
+void
+TimedConsumer::HandleVTable (CXXRecordDecl *decl)
+{
+	StatsTimer timer (this->_name);
+	this->_consumer->HandleVTable (decl);
+}
+
+ASTMutationListener *
+TimedConsumer::GetASTMutationListener ()
+{
+	return this->_consumer->GetASTMutationListener ();
+}
+
+ASTDeserializationListener *
+TimedConsumer::GetASTDeserializationListener ()
+{
+	return this->_consumer->GetASTDeserializationListener ();
+}
+
+void
+TimedConsumer::PrintStats ()
+{
+	this->_consumer->PrintStats ();
+}
+
+bool
+TimedConsumer::shouldSkipFunctionBody (Decl *decl)
+{
+	return this->_consumer->shouldSkipFunctionBody (decl);
+}
+
+void
+StatsConsumer::HandleTranslationUnit (ASTContext& /* context */)
+{
+	const Stats& stats = Stats::current ();
+
+	if (stats.enabled)
+		stats.print (llvm::errs (), this->_file);
+}
+
+} /* namespace tartan */
@@ -0,0 +1,207 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2026 Philip Withnall
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip@tecnocode.co.uk>
+ */
+
+#ifndef TARTAN_STATS_H
+#define TARTAN_STATS_H
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "config.h"
+
+#include <clang/AST/AST.h>
+#include <clang/AST/ASTConsumer.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <glib.h>
+
+namespace tartan {
+
+using namespace clang;
+
+/* Counters and timers reported by the --stats argument. Each translation unit
+ * is compiled on a single thread, so the statistics are kept per thread: they
+ * are reset by ParseArgs() and reported at the end of the translation unit.
+ * Nothing is recorded unless @enabled is set. */
+class Stats {
+public:
+	struct Timer {
+		guint64 count;
+		guint64 total_ns;
+
+		void add (guint64 ns) { this->count++; this->total_ns += ns; }
+	};
+
+	struct Lookup {
+		guint64 count;
+		guint64 hits;
+		guint64 total_ns;
+
+		void
+		add (guint64 ns, bool hit)
+		{
+			this->count++;
+			this->hits += hit ? 1 : 0;
+			this->total_ns += ns;
+		}
+	};
+
+	bool enabled;
+
+	/* Listing and registering or loading the typelibs on the search
+	 * path, in ParseArgs(). */
+	Timer typelib_scan;
+	/* Loading and indexing individual typelibs, whether up front or
+	 * lazily. */
+	Timer typelib_load;
+	/* Namespaces activated from their GIR cache instead. */
+	guint64 gir_cache_maps;
+	/* GIR caches written, because a namespace had none or it was out of
+	 * date. */
+	guint64 gir_cache_writes;
+	/* Typelib directories listed from their cached listing, rather than
+	 * by reading the directory. */
+	guint64 typelib_dir_cache_hits;
+
+	Lookup find_function_info;
+	Lookup find_function_summary;
+	Lookup find_object_info;
+	guint64 object_info_cache_hits;
+
+	/* Incremental scans of new AST types into TypeManager’s typedef
+	 * index, the types examined by them, and names not found. */
+	guint64 type_scans;
+	guint64 type_scan_types;
+	guint64 type_scan_misses;
+
+	/* Time spent in each AST consumer, in the order they were first
+	 * run. */
+	std::vector<std::pair<std::string, Timer>> consumers;
+
+	Stats () { this->reset (); }
+
+	/* Add @n to @counter, which must be one of the counters above, if
+	 * statistics are enabled. */
+	void
+	count (guint64& counter, guint64 n = 1)
+	{
+		if (this->enabled)
+			counter += n;
+	}
+
+	static Stats& current ();
+	static guint64 now ();
+
+	void reset ();
+	void add (const Stats& other);
+	Timer& consumer_timer (const std::string& name);
+	void print (llvm::raw_ostream& out, const std::string& file) const;
+};
+
+/* Adds the time from its construction to its destruction to @timer, if
+ * statistics are enabled. */
+class StatsTimer {
+public:
+	explicit StatsTimer (Stats::Timer& timer) :
+		StatsTimer (Stats::current (), timer) {}
+
+	/* Adds to @timer, which must be one of the timers in @stats, if
+	 * statistics are enabled in @stats rather than Stats::current(). */
+	StatsTimer (Stats& stats, Stats::Timer& timer) :
+		_timer (stats.enabled ? &timer : NULL),
+		_start ((_timer != NULL) ? Stats::now () : 0) {}
+
+	/* Times the AST consumer called @consumer_name. */
+	explicit StatsTimer (const std::string& consumer_name) :
+		_timer (Stats::current ().enabled ?
+		        &Stats::current ().consumer_timer (consumer_name) :
+		        NULL),
+		_start ((_timer != NULL) ? Stats::now () : 0) {}
+
+	~StatsTimer ()
+	{
+		if (this->_timer != NULL)
+			this->_timer->add (Stats::now () - this->_start);
+	}
+
+private:
+	Stats::Timer *_timer;
+	guint64 _start;
+};
+
+/* Proxy which times the callbacks of the wrapped consumer. Every callback is
+ * forwarded, so that wrapping a consumer doesn’t change its behaviour; the
+ * ones which only return listeners or flags aren’t timed. */
+class TimedConsumer : public ASTConsumer {
+public:
+	explicit TimedConsumer (const std::string& name,
+	                        std::unique_ptr<ASTConsumer> consumer) :
+		_name (name), _consumer (std::move (consumer)) {}
+
+private:
+	std::string _name;
+	std::unique_ptr<ASTConsumer> _consumer;
+
+public:
+	virtual void Initialize (ASTContext& context);
+	virtual bool HandleTopLevelDecl (DeclGroupRef decl_group);
+	virtual void HandleInlineFunctionDefinition (FunctionDecl *func);
+	virtual void HandleInterestingDecl (DeclGroupRef decl_group);
+	virtual void HandleTranslationUnit (ASTContext& context);
+	virtual void HandleTagDeclDefinition (TagDecl *decl);
+	virtual void HandleTagDeclRequiredDefinition (const TagDecl *decl);
+	virtual void HandleCXXImplicitFunctionInstantiation (FunctionDecl *f);
+	virtual void HandleTopLevelDeclInObjCContainer (DeclGroupRef group);
+	virtual void HandleImplicitImportDecl (ImportDecl *decl);
+	virtual void CompleteTentativeDefinition (VarDecl *decl);
+#if defined(HAVE_LLVM_19_0)
+	virtual void CompleteExternalDeclaration (DeclaratorDecl *decl);
+#elif defined(HAVE_LLVM_10_0)
+	virtual void CompleteExternalDeclaration (VarDecl *decl);
+#endif
+	virtual void AssignInheritanceModel (CXXRecordDecl *decl);
+	virtual void HandleCXXStaticMemberVarInstantiation (VarDecl *decl);
+	virtual void HandleVTable (CXXRecordDecl *decl);
+	virtual ASTMutationListener *GetASTMutationListener ();
+	virtual ASTDeserializationListener *GetASTDeserializationListener ();
+	virtual void PrintStats ();
+	virtual bool shouldSkipFunctionBody (Decl *decl);
+};
+
+/* Prints the statistics at the end of the translation unit. This must be the
+ * last consumer, so that all the others have finished. */
+class StatsConsumer : public ASTConsumer {
+public:
+	explicit StatsConsumer (const std::string& file) : _file (file) {}
+
+private:
+	std::string _file;
+
+public:
+	virtual void HandleTranslationUnit (ASTContext& context);
+};
+
+} /* namespace tartan */
+
+#endif /* !TARTAN_STATS_H */
@@ -29,51 +29,69 @@
 
 #include "type-manager.h"
 #include "debug.h"
+#include "stats.h"
 
 namespace tartan {
 
-/* Find a #QualType for the typedeffed type with the given @name. This is a very
- * slow call (it requires iterating through all defined types in the given
- * @context), so its results are cached where possible.
- *
- * If type lookup fails, a null type is returned. */
-const QualType
-TypeManager::find_type_by_name (const std::string name)
+/* Add the types created in the context since the last call to the typedef
+ * index. The first type found for each name is kept, as a linear search
+ * would. */
+void
+TypeManager::_index_new_types ()
 {
-	/* Look up the type in the cache first. */
-	std::unordered_map<std::string, QualType>::const_iterator cached =
-		this->_type_cache.find (name);
-	if (cached != this->_type_cache.end ()) {
-		return (*cached).second;
-	}
+	const SmallVectorImpl<Type *>& types = this->_context.getTypes ();
+
+	if (this->_n_indexed_types == types.size ())
+		return;
 
-	for (SmallVectorImpl<Type *>::const_iterator it = this->_context.getTypes ().begin (),
-	     ie = this->_context.getTypes ().end (); it != ie; ++it) {
-		const Type *t = *it;
-		const TypedefType *tt = t->getAs<TypedefType> ();
+	Stats& stats = Stats::current ();
+	stats.count (stats.type_scans);
+	stats.count (stats.type_scan_types,
+	             types.size () - this->_n_indexed_types);
+
+	for (size_t i = this->_n_indexed_types; i < types.size (); i++) {
+		const TypedefType *tt = types[i]->getAs<TypedefType> ();
 
 		if (tt != NULL) {
-			const TypedefNameDecl *decl = tt->getDecl ();
+			this->_typedefs.emplace (tt->getDecl ()->getName ().str (),
+			                         QualType (tt, 0));
+		}
+	}
+
+	this->_n_indexed_types = types.size ();
+}
 
-			if (decl->getName () == name) {
-				DEBUG ("Found type ‘" << name << "’ with "
-				       "desugared type ‘" <<
-				       tt->desugar ().getAsString () << "’.");
+/* Find a #QualType for the typedeffed type with the given @name. Typedefs are
+ * indexed by name the first time this is called, and the index is extended
+ * with any types created since on later calls, so each type is only examined
+ * once. Unknown names are therefore cheap to look up again, unless more types
+ * have been created in the meantime.
+ *
+ * If type lookup fails, a null type is returned. */
+const QualType
+TypeManager::find_type_by_name (const std::string name)
+{
+	std::unordered_map<std::string, QualType>::const_iterator it =
+		this->_typedefs.find (name);
 
-				QualType qt (tt, 0);
+	if (it == this->_typedefs.end ()) {
+		this->_index_new_types ();
+		it = this->_typedefs.find (name);
+	}
 
-				/* Insert it into the cache. */
-				std::string _name (name);
-				this->_type_cache.emplace (_name, qt);
+	if (it == this->_typedefs.end ()) {
+		DEBUG ("Failed to find type ‘" << name << "’.");
+		Stats& stats = Stats::current ();
+		stats.count (stats.type_scan_misses);
 
-				return qt;
-			}
-		}
+		return QualType ();
 	}
 
-	DEBUG ("Failed to find type ‘" << name << "’.");
+	DEBUG ("Found type ‘" << name << "’ with desugared type ‘" <<
+	       it->second->getAs<TypedefType> ()->desugar ().getAsString () <<
+	       "’.");
 
-	return QualType ();
+	return it->second;
 }
 
 /* Version of _find_type_by_name() which makes it a pointer type. */
@@ -88,4 +106,45 @@ TypeManager::find_pointer_type_by_name (const std::string name)
 	return QualType ();
 }
 
+/* Get the well-known GLib types, resolving them the first time this is called.
+ * This must not be called until the translation unit has been parsed, or some
+ * of the types may not be defined yet. */
+const WellKnownTypes&
+TypeManager::well_known_types ()
+{
+	if (this->_resolved_well_known_types)
+		return this->_well_known_types;
+
+	WellKnownTypes& types = this->_well_known_types;
+
+	types.gboolean = this->find_type_by_name ("gboolean");
+	types.gboolean_pointer = this->find_pointer_type_by_name ("gboolean");
+	types.gint16 = this->find_type_by_name ("gint16");
+	types.guint16 = this->find_type_by_name ("guint16");
+	types.gint32 = this->find_type_by_name ("gint32");
+	types.guint32 = this->find_type_by_name ("guint32");
+	types.gint64 = this->find_type_by_name ("gint64");
+	types.guint64 = this->find_type_by_name ("guint64");
+	types.glong = this->find_type_by_name ("glong");
+	types.gulong = this->find_type_by_name ("gulong");
+	types.va_list_pointer = this->find_pointer_type_by_name ("va_list");
+
+	types.garray_pointer = this->find_pointer_type_by_name ("GArray");
+	types.gbytearray_pointer = this->find_pointer_type_by_name ("GByteArray");
+	types.gerror_pointer = this->find_pointer_type_by_name ("GError");
+	types.ghashtable_pointer = this->find_pointer_type_by_name ("GHashTable");
+	types.glist_pointer = this->find_pointer_type_by_name ("GList");
+	types.gptrarray_pointer = this->find_pointer_type_by_name ("GPtrArray");
+	types.gslist_pointer = this->find_pointer_type_by_name ("GSList");
+	types.gvariant_pointer = this->find_pointer_type_by_name ("GVariant");
+	types.gvariant_builder_pointer =
+		this->find_pointer_type_by_name ("GVariantBuilder");
+	types.gvariant_iter_pointer =
+		this->find_pointer_type_by_name ("GVariantIter");
+
+	this->_resolved_well_known_types = true;
+
+	return types;
+}
+
 } /* namespace tartan */
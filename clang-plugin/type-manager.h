@@ -31,18 +31,58 @@ namespace tartan {
 
 using namespace clang;
 
+/* GLib types which the checkers compare against, resolved once per translation
+ * unit. Each is the typedef type with the given name, or a pointer to it for
+ * the *_pointer members. Any may be null if the translation unit doesn’t
+ * define the type. */
+struct WellKnownTypes {
+	QualType gboolean;
+	QualType gboolean_pointer;
+	QualType gint16;
+	QualType guint16;
+	QualType gint32;
+	QualType guint32;
+	QualType gint64;
+	QualType guint64;
+	QualType glong;
+	QualType gulong;
+	QualType va_list_pointer;
+
+	QualType garray_pointer;
+	QualType gbytearray_pointer;
+	QualType gerror_pointer;
+	QualType ghashtable_pointer;
+	QualType glist_pointer;
+	QualType gptrarray_pointer;
+	QualType gslist_pointer;
+	QualType gvariant_pointer;
+	QualType gvariant_builder_pointer;
+	QualType gvariant_iter_pointer;
+};
+
 class TypeManager {
 public:
 	explicit TypeManager (const ASTContext &context) :
-		_context (context) {};
+		_context (context), _n_indexed_types (0),
+		_resolved_well_known_types (false) {};
 
 	const QualType find_type_by_name (const std::string name);
 	const QualType find_pointer_type_by_name (const std::string name);
+	const WellKnownTypes& well_known_types ();
 
 private:
 	const ASTContext &_context;
 
-	std::unordered_map<std::string, QualType> _type_cache;
+	/* Index of typedef names to their types, covering the first
+	 * @_n_indexed_types elements of ASTContext::getTypes(). Types are only
+	 * ever appended to that, so the index is extended as needed. */
+	std::unordered_map<std::string, QualType> _typedefs;
+	size_t _n_indexed_types;
+
+	WellKnownTypes _well_known_types;
+	bool _resolved_well_known_types;
+
+	void _index_new_types ();
 };
 
 } /* namespace tartan */
@@ -0,0 +1,311 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2026 Philip Withnall
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip@tecnocode.co.uk>
+ */
+
+/**
+ * TypelibDirCache:
+ *
+ * Each listing is stored as a #GKeyFile named after a hash of the directory
+ * path. Its main group holds the path itself (in case of hash collisions), the
+ * directory’s modification time when it was listed, and the name of a group
+ * for each typelib in it. Each of those holds the typelib’s namespace, version,
+ * path and modification time.
+ */
+
+#include <cstring>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "debug.h"
+#include "stats.h"
+#include "typelib-dir-cache.h"
+
+#define STATE_GROUP "Typelib Directory"
+#define STATE_TYPELIB_GROUP_PREFIX "Typelib "
+#define STATE_FORMAT_VERSION 2
+#define TYPELIB_SUFFIX ".typelib"
+
+/* List the typelibs in @dir_path. If @cache_dir is non-empty, the listing is
+ * cached there, and reused for as long as the directory’s modification time is
+ * unchanged. Returns %false and sets @error if the directory can’t be read. */
+bool
+TypelibDirCache::list (const std::string& cache_dir,
+                       const std::string& dir_path,
+                       std::vector<Entry>& typelibs,
+                       GError** error)
+{
+	GStatBuf buf;
+	std::string state_path;
+	bool cacheable;
+
+	/* Stat the directory before reading it, so that if it changes while
+	 * it’s being read, the listing is stored with the old modification
+	 * time and is ignored next time. */
+	cacheable = (!cache_dir.empty () &&
+	             g_stat (dir_path.c_str (), &buf) == 0);
+
+	if (cacheable) {
+		state_path = _state_path (cache_dir, dir_path);
+
+		if (_read (state_path, dir_path, buf.st_mtime, typelibs)) {
+			tartan::Stats& stats = tartan::Stats::current ();
+			stats.count (stats.typelib_dir_cache_hits);
+			return true;
+		}
+	}
+
+	if (!_read_dir (dir_path, typelibs, error))
+		return false;
+
+	/* Modification times only have a granularity of a second, so another
+	 * change in the same second as the last one wouldn’t be noticed. Don’t
+	 * cache the listing until that second has passed. */
+	if (cacheable &&
+	    (gint64) buf.st_mtime < g_get_real_time () / G_USEC_PER_SEC) {
+		_write (cache_dir, state_path, dir_path, buf.st_mtime,
+		        typelibs);
+	}
+
+	return true;
+}
+
+/* List the typelibs in @dir_path by reading the directory. Files without a
+ * ‘.typelib’ suffix, or whose names aren’t of the form
+ * ‘Namespace-Version.typelib’, are ignored. */
+bool
+TypelibDirCache::_read_dir (const std::string& dir_path,
+                            std::vector<Entry>& typelibs,
+                            GError** error)
+{
+	GDir *dir = g_dir_open (dir_path.c_str (), 0, error);
+	const gchar *file_name;
+
+	if (dir == NULL)
+		return false;
+
+	typelibs.clear ();
+
+	while ((file_name = g_dir_read_name (dir)) != NULL) {
+		if (!g_str_has_suffix (file_name, TYPELIB_SUFFIX)) {
+			/* No ‘.typelib’ suffix — ignore. */
+			continue;
+		}
+
+		std::string name (file_name,
+		                  strlen (file_name) - strlen (TYPELIB_SUFFIX));
+		std::string::size_type p = name.find ("-");
+
+		if (p == std::string::npos) {
+			/* No version — probably not a typelib. */
+			continue;
+		}
+
+		Entry entry;
+		entry.nspace = name.substr (0, p);
+		entry.version = name.substr (p + 1);
+
+		gchar *path = g_build_filename (dir_path.c_str (), file_name,
+		                                NULL);
+		entry.path = path;
+		g_free (path);
+
+		GStatBuf buf;
+
+		if (g_stat (entry.path.c_str (), &buf) != 0) {
+			DEBUG ("Ignoring typelib " << entry.path <<
+			       " which can’t be stat()ed.");
+			continue;
+		}
+
+		entry.mtime = buf.st_mtime;
+
+		typelibs.push_back (entry);
+	}
+
+	g_dir_close (dir);
+
+	return true;
+}
+
+/* Path of the cached listing for @dir_path. */
+std::string
+TypelibDirCache::_state_path (const std::string& cache_dir,
+                              const std::string& dir_path)
+{
+	gchar *file_name = g_strdup_printf ("typelib-dir-%08x.list",
+	                                    g_str_hash (dir_path.c_str ()));
+	gchar *path = g_build_filename (cache_dir.c_str (), file_name, NULL);
+	std::string retval (path);
+
+	g_free (path);
+	g_free (file_name);
+
+	return retval;
+}
+
+/* Read the typelib from @group of the cached listing in @key_file into @entry.
+ * Returns %false if any of its fields are missing. */
+static bool
+_read_entry (GKeyFile *key_file, const gchar *group,
+             TypelibDirCache::Entry& entry)
+{
+	gchar *nspace, *version, *path;
+	GError *error = NULL;
+	bool valid;
+
+	nspace = g_key_file_get_string (key_file, group, "Namespace", NULL);
+	version = g_key_file_get_string (key_file, group, "Version", NULL);
+	path = g_key_file_get_string (key_file, group, "Path", NULL);
+	entry.mtime = g_key_file_get_int64 (key_file, group, "MTime", &error);
+
+	valid = (nspace != NULL && version != NULL && path != NULL &&
+	         error == NULL);
+
+	if (valid) {
+		entry.nspace = nspace;
+		entry.version = version;
+		entry.path = path;
+	}
+
+	g_clear_error (&error);
+	g_free (path);
+	g_free (version);
+	g_free (nspace);
+
+	return valid;
+}
+
+/* Read the cached listing at @state_path, and check it’s for @dir_path as of
+ * @dir_mtime. Returns %false if it doesn’t exist, is invalid or is out of
+ * date. */
+bool
+TypelibDirCache::_read (const std::string& state_path,
+                        const std::string& dir_path,
+                        guint64 dir_mtime,
+                        std::vector<Entry>& typelibs)
+{
+	GKeyFile *key_file = g_key_file_new ();
+	gchar *path = NULL;
+	gchar **groups = NULL;
+	bool valid;
+
+	if (g_key_file_load_from_file (key_file, state_path.c_str (),
+	                               G_KEY_FILE_NONE, NULL) &&
+	    g_key_file_get_integer (key_file, STATE_GROUP, "Format",
+	                            NULL) == STATE_FORMAT_VERSION &&
+	    (guint64) g_key_file_get_int64 (key_file, STATE_GROUP, "MTime",
+	                                    NULL) == dir_mtime) {
+		path = g_key_file_get_string (key_file, STATE_GROUP, "Path",
+		                              NULL);
+		groups = g_key_file_get_string_list (key_file, STATE_GROUP,
+		                                     "Typelibs", NULL, NULL);
+	}
+
+	valid = (path != NULL && dir_path == path && groups != NULL);
+
+	if (valid) {
+		typelibs.clear ();
+
+		for (gchar **group = groups; *group != NULL && valid; group++) {
+			Entry entry;
+
+			valid = _read_entry (key_file, *group, entry);
+			typelibs.push_back (entry);
+		}
+	}
+
+	if (!valid) {
+		DEBUG ("Ignoring missing or out of date typelib listing " <<
+		       state_path << " for " << dir_path);
+		typelibs.clear ();
+	}
+
+	g_strfreev (groups);
+	g_free (path);
+	g_key_file_free (key_file);
+
+	return valid;
+}
+
+/* Write the cached listing for @dir_path. The file is written atomically, so
+ * concurrent readers and writers will see either the old or new version.
+ * Failure is not fatal, as the directory can always be read instead. */
+void
+TypelibDirCache::_write (const std::string& cache_dir,
+                         const std::string& state_path,
+                         const std::string& dir_path,
+                         guint64 dir_mtime,
+                         const std::vector<Entry>& typelibs)
+{
+	GKeyFile *key_file = g_key_file_new ();
+	std::vector<std::string> groups;
+	std::vector<const gchar*> group_names;
+	GError *error = NULL;
+
+	g_key_file_set_integer (key_file, STATE_GROUP, "Format",
+	                        STATE_FORMAT_VERSION);
+	g_key_file_set_string (key_file, STATE_GROUP, "Path",
+	                       dir_path.c_str ());
+	g_key_file_set_int64 (key_file, STATE_GROUP, "MTime", dir_mtime);
+
+	groups.reserve (typelibs.size ());
+	group_names.reserve (typelibs.size ());
+
+	for (std::vector<Entry>::const_iterator it = typelibs.begin (),
+	     ie = typelibs.end (); it != ie; ++it) {
+		const Entry& entry = *it;
+
+		groups.push_back (STATE_TYPELIB_GROUP_PREFIX + entry.nspace +
+		                  "-" + entry.version);
+
+		const gchar *group = groups.back ().c_str ();
+
+		g_key_file_set_string (key_file, group, "Namespace",
+		                       entry.nspace.c_str ());
+		g_key_file_set_string (key_file, group, "Version",
+		                       entry.version.c_str ());
+		g_key_file_set_string (key_file, group, "Path",
+		                       entry.path.c_str ());
+		g_key_file_set_int64 (key_file, group, "MTime", entry.mtime);
+	}
+
+	for (std::vector<std::string>::const_iterator it = groups.begin (),
+	     ie = groups.end (); it != ie; ++it)
+		group_names.push_back (it->c_str ());
+
+	g_key_file_set_string_list (key_file, STATE_GROUP, "Typelibs",
+	                            group_names.data (), group_names.size ());
+
+	gsize length;
+	gchar *data = g_key_file_to_data (key_file, &length, NULL);
+
+	if (g_mkdir_with_parents (cache_dir.c_str (), 0755) != 0 ||
+	    !g_file_set_contents (state_path.c_str (), data, length, &error)) {
+		DEBUG ("Failed to write typelib listing " << state_path <<
+		       ((error != NULL) ? ": " : "") <<
+		       ((error != NULL) ? error->message : ""));
+	}
+
+	g_clear_error (&error);
+	g_free (data);
+	g_key_file_free (key_file);
+}
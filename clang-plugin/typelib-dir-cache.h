@@ -0,0 +1,69 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2026 Philip Withnall
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip@tecnocode.co.uk>
+ */
+
+#ifndef TARTAN_TYPELIB_DIR_CACHE_H
+#define TARTAN_TYPELIB_DIR_CACHE_H
+
+#include <string>
+#include <vector>
+
+#include <glib.h>
+
+/* Listings of the typelibs in the directories on the typelib search path,
+ * cached in the GIR cache directory. A cached listing is used for as long as
+ * its directory’s modification time is unchanged. */
+class TypelibDirCache {
+public:
+	/* A typelib in a listed directory. */
+	struct Entry {
+		std::string nspace;
+		std::string version;
+		/* Full path of the typelib file. */
+		std::string path;
+		/* Modification time of the typelib when the directory was
+		 * listed. */
+		guint64 mtime;
+	};
+
+	static bool list (const std::string& cache_dir,
+	                  const std::string& dir_path,
+	                  std::vector<Entry>& typelibs,
+	                  GError** error);
+
+private:
+	static bool _read_dir (const std::string& dir_path,
+	                       std::vector<Entry>& typelibs,
+	                       GError** error);
+	static std::string _state_path (const std::string& cache_dir,
+	                                const std::string& dir_path);
+	static bool _read (const std::string& state_path,
+	                   const std::string& dir_path,
+	                   guint64 dir_mtime,
+	                   std::vector<Entry>& typelibs);
+	static void _write (const std::string& cache_dir,
+	                    const std::string& state_path,
+	                    const std::string& dir_path,
+	                    guint64 dir_mtime,
+	                    const std::vector<Entry>& typelibs);
+};
+
+#endif /* !TARTAN_TYPELIB_DIR_CACHE_H */
@@ -0,0 +1,341 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2026 Philip Withnall
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip@tecnocode.co.uk>
+ */
+
+/**
+ * TypelibIncludeMap:
+ *
+ * GIR files list the C headers for their namespace in <c:include> elements,
+ * which all precede the <namespace> element. Only that head of each GIR file is
+ * parsed, so building the map doesn’t cost much more than listing the typelibs.
+ *
+ * Typelibs for which no GIR file can be found (for example, because the
+ * development files for that library aren’t installed) aren’t added to the
+ * map, and are registered up front as before.
+ */
+
+#include "config.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include <girepository.h>
+#include <glib.h>
+
+#include "debug.h"
+#include "typelib-includes.h"
+
+namespace tartan {
+
+struct GirHead {
+	std::vector<std::string> includes;
+	bool done;
+};
+
+static void
+_gir_start_element (GMarkupParseContext * /* context */,
+                    const gchar *element_name,
+                    const gchar **attribute_names,
+                    const gchar **attribute_values,
+                    gpointer user_data,
+                    GError ** /* error */)
+{
+	GirHead *head = static_cast<GirHead *> (user_data);
+
+	if (strcmp (element_name, "c:include") == 0) {
+		for (guint i = 0; attribute_names[i] != NULL; i++) {
+			if (strcmp (attribute_names[i], "name") == 0) {
+				head->includes.push_back (attribute_values[i]);
+			}
+		}
+	} else if (strcmp (element_name, "namespace") == 0) {
+		head->done = true;
+	}
+}
+
+/* Read the c:include names from the head of the given GIR file. */
+static std::vector<std::string>
+_read_gir_includes (const std::string& gir_path)
+{
+	GirHead head;
+	head.done = false;
+
+	FILE *file = fopen (gir_path.c_str (), "rb");
+	if (file == NULL) {
+		return head.includes;
+	}
+
+	GMarkupParser parser = { _gir_start_element, NULL, NULL, NULL, NULL };
+	GMarkupParseContext *context =
+		g_markup_parse_context_new (&parser, (GMarkupParseFlags) 0,
+		                            &head, NULL);
+
+	gchar buf[4096];
+	size_t len;
+
+	while (!head.done &&
+	       (len = fread (buf, 1, sizeof (buf), file)) > 0) {
+		GError *error = NULL;
+
+		if (!g_markup_parse_context_parse (context, buf, len, &error)) {
+			DEBUG ("Error parsing GIR file " << gir_path << ": " <<
+			       error->message);
+			g_error_free (error);
+			break;
+		}
+	}
+
+	g_markup_parse_context_free (context);
+	fclose (file);
+
+	return head.includes;
+}
+
+static void
+_add_gir_dir (std::vector<std::string>& dirs, const gchar *data_dir)
+{
+	gchar *gir_dir = g_build_filename (data_dir, "gir-1.0", NULL);
+	dirs.push_back (gir_dir);
+	g_free (gir_dir);
+}
+
+std::string
+TypelibIncludeMap::_find_gir (const std::string& nspace,
+                              const std::string& version,
+                              const std::string& typelib_path)
+{
+	if (!this->_gir_dirs_set) {
+		const gchar *gir_path = g_getenv ("GI_GIR_PATH");
+
+		if (gir_path != NULL) {
+			gchar **paths = g_strsplit (gir_path,
+			                            G_SEARCHPATH_SEPARATOR_S, -1);
+
+			for (guint i = 0; paths[i] != NULL; i++) {
+				if (*paths[i] != '\0') {
+					this->_gir_dirs.push_back (paths[i]);
+				}
+			}
+
+			g_strfreev (paths);
+		}
+
+		_add_gir_dir (this->_gir_dirs, g_get_user_data_dir ());
+
+		const gchar * const *data_dirs = g_get_system_data_dirs ();
+		for (guint i = 0; data_dirs[i] != NULL; i++) {
+			_add_gir_dir (this->_gir_dirs, data_dirs[i]);
+		}
+
+		this->_gir_dirs_set = true;
+	}
+
+	std::string gir_filename = nspace + "-" + version + ".gir";
+
+	/* Uninstalled libraries tend to have their GIR file next to the
+	 * typelib, so try there first. */
+	std::vector<std::string> dirs;
+	gchar *typelib_dir = g_path_get_dirname (typelib_path.c_str ());
+	dirs.push_back (typelib_dir);
+	g_free (typelib_dir);
+	dirs.insert (dirs.end (), this->_gir_dirs.begin (),
+	             this->_gir_dirs.end ());
+
+	for (std::vector<std::string>::const_iterator it = dirs.begin ();
+	     it != dirs.end (); ++it) {
+		gchar *path = g_build_filename (it->c_str (),
+		                                gir_filename.c_str (), NULL);
+		std::string retval (path);
+		bool exists = g_file_test (path, G_FILE_TEST_IS_REGULAR);
+		g_free (path);
+
+		if (exists) {
+			return retval;
+		}
+	}
+
+	return "";
+}
+
+/* Add the given typelib to the map if the headers for it can be found. Returns
+ * false otherwise, in which case the caller should register the typelib
+ * itself. */
+bool
+TypelibIncludeMap::add_typelib (const std::string& nspace,
+                                const std::string& version,
+                                const std::string& typelib_path)
+{
+	std::lock_guard<std::mutex> lock (this->_mutex);
+
+	/* Earlier entries on the typelib search path take precedence. */
+	for (std::vector<std::unique_ptr<Typelib>>::const_iterator it =
+	     this->_typelibs.begin (); it != this->_typelibs.end (); ++it) {
+		if ((*it)->nspace == nspace && (*it)->version == version) {
+			return true;
+		}
+	}
+
+	std::string gir_path = this->_find_gir (nspace, version, typelib_path);
+	if (gir_path.empty ()) {
+		DEBUG ("No GIR file found for " << nspace << " " << version);
+		return false;
+	}
+
+	std::vector<std::string> includes = _read_gir_includes (gir_path);
+	if (includes.empty ()) {
+		DEBUG ("No C headers listed in " << gir_path);
+		return false;
+	}
+
+	Typelib *typelib = new Typelib ();
+	typelib->nspace = nspace;
+	typelib->version = version;
+	typelib->typelib_path = typelib_path;
+	this->_typelibs.push_back (std::unique_ptr<Typelib> (typelib));
+
+	for (std::vector<std::string>::const_iterator it = includes.begin ();
+	     it != includes.end (); ++it) {
+		this->_headers[*it].push_back (typelib);
+
+		std::string::size_type p = it->rfind ('/');
+		if (p != std::string::npos) {
+			this->_header_dirs[it->substr (0, p + 1)].push_back (typelib);
+		}
+	}
+
+	return true;
+}
+
+/* Find the typelibs providing the header @file_name, which was found in the
+ * include directory @search_path. */
+std::vector<const TypelibIncludeMap::Typelib*>
+TypelibIncludeMap::find_typelibs (const std::string& file_name,
+                                   const std::string& search_path)
+{
+	std::lock_guard<std::mutex> lock (this->_mutex);
+	std::vector<const Typelib*> candidates;
+
+	std::unordered_map<std::string, std::vector<const Typelib*>>::const_iterator it =
+		this->_headers.find (file_name);
+
+	if (it != this->_headers.end ()) {
+		candidates = it->second;
+	} else {
+		std::string::size_type p = file_name.rfind ('/');
+
+		if (p != std::string::npos) {
+			it = this->_header_dirs.find (file_name.substr (0, p + 1));
+			if (it != this->_header_dirs.end ()) {
+				candidates = it->second;
+			}
+		}
+	}
+
+	/* Several versions of a library may provide the same header (for
+	 * example, Gtk-3.0 and Gtk-4.0 both provide gtk/gtk.h). Parallel
+	 * installable libraries put their headers in a versioned directory
+	 * (such as /usr/include/gtk-3.0), so prefer the candidates whose
+	 * version appears in the directory the header was found in. */
+	if (candidates.size () <= 1) {
+		return candidates;
+	}
+
+	std::vector<const Typelib*> versioned;
+
+	for (std::vector<const Typelib*>::const_iterator c =
+	     candidates.begin (); c != candidates.end (); ++c) {
+		if (search_path.find ("-" + (*c)->version) != std::string::npos) {
+			versioned.push_back (*c);
+		}
+	}
+
+	return versioned.empty () ? candidates : versioned;
+}
+
+void
+TypelibIncludeCallbacks::InclusionDirective (SourceLocation hash_loc,
+                                             const Token& /* include_tok */,
+                                             StringRef file_name,
+                                             bool /* is_angled */,
+                                             CharSourceRange /* filename_range */,
+#if defined(HAVE_LLVM_16_0)
+                                             OptionalFileEntryRef file,
+#elif defined(HAVE_LLVM_15_0)
+                                             Optional<FileEntryRef> file,
+#else
+                                             const FileEntry *file,
+#endif
+                                             StringRef search_path,
+                                             StringRef /* relative_path */,
+#ifdef HAVE_LLVM_19_0
+                                             const Module * /* suggested_module */,
+                                             bool /* module_imported */,
+#else
+                                             const Module * /* imported */,
+#endif
+                                             SrcMgr::CharacteristicKind /* file_type */)
+{
+	/* The compiler will already have complained about missing headers. */
+	if (!file) {
+		return;
+	}
+
+	std::vector<const TypelibIncludeMap::Typelib*> typelibs =
+		this->_include_map->find_typelibs (file_name.str (),
+		                                   search_path.str ());
+
+	for (std::vector<const TypelibIncludeMap::Typelib*>::const_iterator it =
+	     typelibs.begin (); it != typelibs.end (); ++it) {
+		const TypelibIncludeMap::Typelib *typelib = *it;
+
+		/* Register each typelib once per translation unit. If another
+		 * translation unit already registered it, register_namespace()
+		 * returns straight away. */
+		if (!this->_registered.insert (typelib).second) {
+			continue;
+		}
+
+		DEBUG ("Registering typelib " << typelib->nspace << " " <<
+		       typelib->version << " for " << file_name);
+
+		GError *error = NULL;
+
+		this->_gir_manager->register_namespace (typelib->nspace,
+		                                        typelib->version,
+		                                        typelib->typelib_path,
+		                                        &error);
+
+		if (error != NULL &&
+		    !g_error_matches (error, G_IREPOSITORY_ERROR,
+		                      G_IREPOSITORY_ERROR_NAMESPACE_VERSION_CONFLICT)) {
+			Debug::emit_warning ("Fail to load GI repository ‘%0’ "
+			                     "(version %1): %2",
+			                     this->_compiler, hash_loc)
+				<< typelib->nspace
+				<< typelib->version
+				<< error->message;
+		}
+
+		g_clear_error (&error);
+	}
+}
+
+} /* namespace tartan */
@@ -0,0 +1,128 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2026 Philip Withnall
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip@tecnocode.co.uk>
+ */
+
+#ifndef TARTAN_TYPELIB_INCLUDES_H
+#define TARTAN_TYPELIB_INCLUDES_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "config.h"
+
+#include <clang/Frontend/CompilerInstance.h>
+#include <clang/Lex/PPCallbacks.h>
+
+#include "gir-manager.h"
+
+namespace tartan {
+
+using namespace clang;
+
+/* Map from C header names to the GI namespaces which provide them, built from
+ * the <c:include> elements of the GIR files installed alongside the typelibs
+ * (typelibs themselves don’t record their headers). Typelibs added to the map
+ * are only registered with the #GirManager once one of their headers is
+ * included by a translation unit. Like the #GirManager, the map is shared by
+ * all translation units in the process, and is safe to use from several
+ * threads. */
+class TypelibIncludeMap {
+public:
+	struct Typelib {
+		std::string nspace;
+		std::string version;
+		std::string typelib_path;
+	};
+
+	bool add_typelib (const std::string& nspace,
+	                  const std::string& version,
+	                  const std::string& typelib_path);
+	std::vector<const Typelib*> find_typelibs (const std::string& file_name,
+	                                           const std::string& search_path);
+
+private:
+	std::mutex _mutex;
+
+	std::vector<std::string> _gir_dirs;
+	bool _gir_dirs_set = false;
+
+	std::vector<std::unique_ptr<Typelib>> _typelibs;
+
+	/* Keyed by the c:include name (e.g. ‘gtk/gtk.h’), and by its directory
+	 * (e.g. ‘gtk/’) so that including an individual header from a
+	 * library also selects it. */
+	std::unordered_map<std::string, std::vector<const Typelib*>> _headers;
+	std::unordered_map<std::string, std::vector<const Typelib*>> _header_dirs;
+
+	std::string _find_gir (const std::string& nspace,
+	                       const std::string& version,
+	                       const std::string& typelib_path);
+};
+
+/* Preprocessor callbacks which register the typelibs for each header the
+ * translation unit includes, as listed in a #TypelibIncludeMap. */
+class TypelibIncludeCallbacks : public PPCallbacks {
+public:
+	explicit TypelibIncludeCallbacks (CompilerInstance& compiler,
+	                                  std::shared_ptr<TypelibIncludeMap> include_map,
+	                                  std::shared_ptr<GirManager> gir_manager) :
+		_compiler (compiler), _include_map (include_map),
+		_gir_manager (gir_manager) {}
+
+	/* The signature changed in LLVM 15, 16 and 19. */
+	void InclusionDirective (SourceLocation hash_loc,
+	                         const Token& include_tok,
+	                         StringRef file_name,
+	                         bool is_angled,
+	                         CharSourceRange filename_range,
+#if defined(HAVE_LLVM_16_0)
+	                         OptionalFileEntryRef file,
+#elif defined(HAVE_LLVM_15_0)
+	                         Optional<FileEntryRef> file,
+#else
+	                         const FileEntry *file,
+#endif
+	                         StringRef search_path,
+	                         StringRef relative_path,
+#ifdef HAVE_LLVM_19_0
+	                         const Module *suggested_module,
+	                         bool module_imported,
+#else
+	                         const Module *imported,
+#endif
+	                         SrcMgr::CharacteristicKind file_type) override;
+
+private:
+	CompilerInstance& _compiler;
+	std::shared_ptr<TypelibIncludeMap> _include_map;
+	std::shared_ptr<GirManager> _gir_manager;
+
+	/* Typelibs registered for this translation unit. */
+	std::unordered_set<const TypelibIncludeMap::Typelib*> _registered;
+};
+
+} /* namespace tartan */
+
+#endif /* !TARTAN_TYPELIB_INCLUDES_H */
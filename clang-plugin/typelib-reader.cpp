@@ -0,0 +1,613 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2026 Philip Withnall
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip@tecnocode.co.uk>
+ */
+
+#include <cstring>
+#include <memory>
+
+#include <glib.h>
+
+#include "typelib-reader.h"
+
+/* Typelib layout; see gitypelib-internal.h in gobject-introspection. Offsets
+ * of header fields are relative to the start of the file, and offsets of blob
+ * fields are relative to the start of the blob. Blob sizes are read from the
+ * header where it records them, so that blobs which gain fields in later minor
+ * versions are still stepped over correctly; the minimum sizes are those of
+ * the fields read here. */
+#define TYPELIB_MAGIC "GOBJ\nMETADATA\r\n\032"
+#define TYPELIB_MAJOR_VERSION 4
+#define TYPELIB_HEADER_SIZE 112
+
+#define TYPELIB_HEADER_MAJOR_VERSION_OFFSET 16
+#define TYPELIB_HEADER_N_LOCAL_ENTRIES_OFFSET 22
+#define TYPELIB_HEADER_DIRECTORY_OFFSET 24
+#define TYPELIB_HEADER_NAMESPACE_OFFSET 44
+#define TYPELIB_HEADER_NSVERSION_OFFSET 48
+#define TYPELIB_HEADER_C_PREFIX_OFFSET 56
+#define TYPELIB_HEADER_ENTRY_BLOB_SIZE_OFFSET 60
+#define TYPELIB_HEADER_FUNCTION_BLOB_SIZE_OFFSET 62
+#define TYPELIB_HEADER_CALLBACK_BLOB_SIZE_OFFSET 64
+#define TYPELIB_HEADER_ARG_BLOB_SIZE_OFFSET 70
+#define TYPELIB_HEADER_PROPERTY_BLOB_SIZE_OFFSET 72
+#define TYPELIB_HEADER_FIELD_BLOB_SIZE_OFFSET 74
+#define TYPELIB_HEADER_VALUE_BLOB_SIZE_OFFSET 76
+#define TYPELIB_HEADER_ENUM_BLOB_SIZE_OFFSET 86
+#define TYPELIB_HEADER_STRUCT_BLOB_SIZE_OFFSET 88
+#define TYPELIB_HEADER_OBJECT_BLOB_SIZE_OFFSET 90
+#define TYPELIB_HEADER_INTERFACE_BLOB_SIZE_OFFSET 92
+#define TYPELIB_HEADER_UNION_BLOB_SIZE_OFFSET 94
+
+/* DirEntry */
+#define TYPELIB_ENTRY_BLOB_TYPE_OFFSET 0
+#define TYPELIB_ENTRY_OFFSET_OFFSET 8
+#define TYPELIB_ENTRY_MIN_SIZE 12
+
+/* CommonBlob, the start of every directory entry and method blob */
+#define TYPELIB_BLOB_TYPE_OFFSET 0
+#define TYPELIB_BLOB_FLAGS_OFFSET 2
+#define TYPELIB_BLOB_DEPRECATED (1 << 0)
+
+/* FunctionBlob */
+#define TYPELIB_FUNCTION_SYMBOL_OFFSET 8
+#define TYPELIB_FUNCTION_SIGNATURE_OFFSET 12
+#define TYPELIB_FUNCTION_STATIC_FLAGS_OFFSET 16
+#define TYPELIB_FUNCTION_MIN_SIZE 18
+#define TYPELIB_FUNCTION_CONSTRUCTOR (1 << 3)
+#define TYPELIB_FUNCTION_THROWS (1 << 5)
+#define TYPELIB_FUNCTION_IS_STATIC (1 << 0)
+
+/* SignatureBlob, which is followed by its ArgBlobs */
+#define TYPELIB_SIGNATURE_RETURN_TYPE_OFFSET 0
+#define TYPELIB_SIGNATURE_FLAGS_OFFSET 4
+#define TYPELIB_SIGNATURE_N_ARGS_OFFSET 6
+#define TYPELIB_SIGNATURE_ARGS_OFFSET 8
+#define TYPELIB_SIGNATURE_CALLER_OWNS_RETURN_VALUE (1 << 1)
+#define TYPELIB_SIGNATURE_CALLER_OWNS_RETURN_CONTAINER (1 << 2)
+
+/* ArgBlob */
+#define TYPELIB_ARG_FLAGS_OFFSET 4
+#define TYPELIB_ARG_TYPE_OFFSET 12
+#define TYPELIB_ARG_MIN_SIZE 16
+#define TYPELIB_ARG_IN (1 << 0)
+#define TYPELIB_ARG_OUT (1 << 1)
+#define TYPELIB_ARG_NULLABLE (1 << 3)
+#define TYPELIB_ARG_OPTIONAL (1 << 4)
+#define TYPELIB_ARG_TRANSFER_OWNERSHIP (1 << 5)
+#define TYPELIB_ARG_TRANSFER_CONTAINER_OWNERSHIP (1 << 6)
+
+/* SimpleTypeBlob: either a basic type, or the offset of a complex type blob,
+ * which starts with the same pointer and tag bits as the low byte of its
+ * flags. Array type blobs follow those with the array type. */
+#define TYPELIB_SIMPLE_TYPE_RESERVED_MASK 0x00ffffff
+#define TYPELIB_SIMPLE_TYPE_POINTER_SHIFT 24
+#define TYPELIB_SIMPLE_TYPE_TAG_SHIFT 27
+#define TYPELIB_TYPE_POINTER (1 << 0)
+#define TYPELIB_TYPE_TAG_SHIFT 3
+#define TYPELIB_ARRAY_TYPE_SHIFT 11
+#define TYPELIB_ARRAY_TYPE_MASK 0x3
+
+/* FieldBlob */
+#define TYPELIB_FIELD_FLAGS_OFFSET 4
+#define TYPELIB_FIELD_MIN_SIZE 5
+#define TYPELIB_FIELD_HAS_EMBEDDED_TYPE (1 << 2)
+
+/* StructBlob (and BoxedBlob) */
+#define TYPELIB_STRUCT_N_FIELDS_OFFSET 20
+#define TYPELIB_STRUCT_N_METHODS_OFFSET 22
+
+/* EnumBlob */
+#define TYPELIB_ENUM_N_VALUES_OFFSET 16
+#define TYPELIB_ENUM_N_METHODS_OFFSET 18
+
+/* ObjectBlob */
+#define TYPELIB_OBJECT_N_INTERFACES_OFFSET 20
+#define TYPELIB_OBJECT_N_FIELDS_OFFSET 22
+#define TYPELIB_OBJECT_N_PROPERTIES_OFFSET 24
+#define TYPELIB_OBJECT_N_METHODS_OFFSET 26
+#define TYPELIB_OBJECT_N_FIELD_CALLBACKS_OFFSET 34
+
+/* InterfaceBlob */
+#define TYPELIB_INTERFACE_N_PREREQUISITES_OFFSET 18
+#define TYPELIB_INTERFACE_N_PROPERTIES_OFFSET 20
+#define TYPELIB_INTERFACE_N_METHODS_OFFSET 22
+
+/* UnionBlob */
+#define TYPELIB_UNION_N_FIELDS_OFFSET 20
+#define TYPELIB_UNION_N_FUNCTIONS_OFFSET 22
+
+TypelibReader::TypelibReader (GMappedFile *mapped_file) :
+	_mapped_file (mapped_file),
+	_data (g_mapped_file_get_contents (mapped_file)),
+	_length (g_mapped_file_get_length (mapped_file))
+{
+}
+
+TypelibReader::~TypelibReader ()
+{
+	g_mapped_file_unref (this->_mapped_file);
+}
+
+/* Map the typelib at @typelib_path and check its header: that it is a typelib
+ * of the supported format version, for the expected namespace and version, and
+ * that the blob sizes it records are big enough to read. Returns %NULL if the
+ * typelib can’t be read or doesn’t match. */
+TypelibReader*
+TypelibReader::open (const std::string& typelib_path,
+                     const std::string& gi_namespace,
+                     const std::string& gi_version)
+{
+	GMappedFile *mapped_file;
+
+	mapped_file = g_mapped_file_new (typelib_path.c_str (), FALSE, NULL);
+	if (mapped_file == NULL)
+		return NULL;
+
+	std::unique_ptr<TypelibReader> reader (new TypelibReader (mapped_file));
+	const gchar *data = reader->_data;
+	gsize length = reader->_length;
+
+	/* Check the fixed part of the header first, so the rest of it can be
+	 * read without bounds checks. */
+	if (G_BYTE_ORDER != G_LITTLE_ENDIAN ||
+	    data == NULL || length < TYPELIB_HEADER_SIZE ||
+	    length > G_MAXUINT32 ||
+	    memcmp (data, TYPELIB_MAGIC, strlen (TYPELIB_MAGIC)) != 0 ||
+	    (guint8) data[TYPELIB_HEADER_MAJOR_VERSION_OFFSET] !=
+	    TYPELIB_MAJOR_VERSION)
+		return NULL;
+
+	const gchar *nspace =
+		reader->_get_string (reader->_header_u32 (
+			TYPELIB_HEADER_NAMESPACE_OFFSET));
+	const gchar *nsversion =
+		reader->_get_string (reader->_header_u32 (
+			TYPELIB_HEADER_NSVERSION_OFFSET));
+
+	if (nspace == NULL || nsversion == NULL ||
+	    gi_namespace != nspace || gi_version != nsversion ||
+	    reader->_header_u16 (TYPELIB_HEADER_ENTRY_BLOB_SIZE_OFFSET) <
+	    TYPELIB_ENTRY_MIN_SIZE ||
+	    reader->_header_u16 (TYPELIB_HEADER_FUNCTION_BLOB_SIZE_OFFSET) <
+	    TYPELIB_FUNCTION_MIN_SIZE ||
+	    reader->_header_u16 (TYPELIB_HEADER_ARG_BLOB_SIZE_OFFSET) <
+	    TYPELIB_ARG_MIN_SIZE ||
+	    reader->_header_u16 (TYPELIB_HEADER_FIELD_BLOB_SIZE_OFFSET) <
+	    TYPELIB_FIELD_MIN_SIZE)
+		return NULL;
+
+	return reader.release ();
+}
+
+bool
+TypelibReader::_in_bounds (guint64 offset, guint64 size) const
+{
+	return (offset <= this->_length && size <= this->_length - offset);
+}
+
+bool
+TypelibReader::_read_u8 (guint64 offset, guint8& value) const
+{
+	if (!this->_in_bounds (offset, sizeof (value)))
+		return false;
+
+	value = (guint8) this->_data[offset];
+	return true;
+}
+
+bool
+TypelibReader::_read_u16 (guint64 offset, guint16& value) const
+{
+	if (!this->_in_bounds (offset, sizeof (value)))
+		return false;
+
+	memcpy (&value, this->_data + offset, sizeof (value));
+	return true;
+}
+
+bool
+TypelibReader::_read_u32 (guint64 offset, guint32& value) const
+{
+	if (!this->_in_bounds (offset, sizeof (value)))
+		return false;
+
+	memcpy (&value, this->_data + offset, sizeof (value));
+	return true;
+}
+
+/* Read a header field. open() has checked the header is all there. */
+guint16
+TypelibReader::_header_u16 (gsize field_offset) const
+{
+	guint16 value;
+
+	memcpy (&value, this->_data + field_offset, sizeof (value));
+	return value;
+}
+
+guint32
+TypelibReader::_header_u32 (gsize field_offset) const
+{
+	guint32 value;
+
+	memcpy (&value, this->_data + field_offset, sizeof (value));
+	return value;
+}
+
+/* Read the string at @offset in the typelib. Returns %NULL if the offset is
+ * out of bounds or the string is not nul-terminated within the file. */
+const gchar*
+TypelibReader::_get_string (guint32 offset) const
+{
+	if (offset == 0 || offset >= this->_length ||
+	    memchr (this->_data + offset, '\0', this->_length - offset) == NULL)
+		return NULL;
+
+	return this->_data + offset;
+}
+
+/* The C prefix is optional, so this returns the empty string if there isn’t
+ * one. */
+const gchar*
+TypelibReader::get_c_prefix () const
+{
+	const gchar *prefix =
+		this->_get_string (this->_header_u32 (
+			TYPELIB_HEADER_C_PREFIX_OFFSET));
+
+	return (prefix != NULL) ? prefix : "";
+}
+
+/* Number of directory entries defined by this typelib, as opposed to those it
+ * references from its dependencies. See g_irepository_get_n_infos(). */
+unsigned int
+TypelibReader::get_n_entries () const
+{
+	return this->_header_u16 (TYPELIB_HEADER_N_LOCAL_ENTRIES_OFFSET);
+}
+
+/* Read the type of the @i-th directory entry, and the offset of its blob. See
+ * g_irepository_get_info(). */
+bool
+TypelibReader::get_entry (unsigned int i, GIInfoType& type,
+                          guint32& offset) const
+{
+	guint64 entry =
+		(guint64) this->_header_u32 (TYPELIB_HEADER_DIRECTORY_OFFSET) +
+		(guint64) i *
+		this->_header_u16 (TYPELIB_HEADER_ENTRY_BLOB_SIZE_OFFSET);
+	guint16 blob_type;
+
+	if (i >= this->get_n_entries () ||
+	    !this->_read_u16 (entry + TYPELIB_ENTRY_BLOB_TYPE_OFFSET,
+	                      blob_type) ||
+	    !this->_read_u32 (entry + TYPELIB_ENTRY_OFFSET_OFFSET, offset) ||
+	    blob_type > GI_INFO_TYPE_UNION)
+		return false;
+
+	/* Blob types are numbered the same as #GIInfoTypes. */
+	type = (GIInfoType) blob_type;
+
+	return true;
+}
+
+/* Find the method blobs of the struct, enum, object, interface or union blob of
+ * the given @type at @offset. They are contiguous, and follow the blob’s
+ * fields, values, properties and so on, which have to be stepped over in the
+ * same way as g_struct_info_get_method() and friends do. Other types of blob
+ * have no methods. */
+bool
+TypelibReader::get_methods (GIInfoType type, guint32 offset,
+                            guint32& first_method,
+                            unsigned int& n_methods) const
+{
+	guint64 field_size =
+		this->_header_u16 (TYPELIB_HEADER_FIELD_BLOB_SIZE_OFFSET);
+	guint64 callback_size =
+		this->_header_u16 (TYPELIB_HEADER_CALLBACK_BLOB_SIZE_OFFSET);
+	guint64 property_size =
+		this->_header_u16 (TYPELIB_HEADER_PROPERTY_BLOB_SIZE_OFFSET);
+	guint64 value_size =
+		this->_header_u16 (TYPELIB_HEADER_VALUE_BLOB_SIZE_OFFSET);
+	guint64 function_size =
+		this->_header_u16 (TYPELIB_HEADER_FUNCTION_BLOB_SIZE_OFFSET);
+	guint16 n_fields = 0, n_values = 0, n_interfaces = 0;
+	guint16 n_field_callbacks = 0, n_properties = 0, count = 0;
+	guint64 pos;
+
+	switch (type) {
+	case GI_INFO_TYPE_STRUCT:
+		if (!this->_read_u16 (offset + TYPELIB_STRUCT_N_FIELDS_OFFSET,
+		                      n_fields) ||
+		    !this->_read_u16 (offset + TYPELIB_STRUCT_N_METHODS_OFFSET,
+		                      count))
+			return false;
+
+		/* Fields may be followed by an embedded callback type. */
+		pos = (guint64) offset + this->_header_u16 (
+			TYPELIB_HEADER_STRUCT_BLOB_SIZE_OFFSET);
+
+		for (guint16 i = 0; i < n_fields; i++) {
+			guint8 flags;
+
+			if (!this->_read_u8 (pos + TYPELIB_FIELD_FLAGS_OFFSET,
+			                     flags))
+				return false;
+
+			pos += field_size;
+
+			if (flags & TYPELIB_FIELD_HAS_EMBEDDED_TYPE)
+				pos += callback_size;
+		}
+
+		break;
+	case GI_INFO_TYPE_ENUM:
+		if (!this->_read_u16 (offset + TYPELIB_ENUM_N_VALUES_OFFSET,
+		                      n_values) ||
+		    !this->_read_u16 (offset + TYPELIB_ENUM_N_METHODS_OFFSET,
+		                      count))
+			return false;
+
+		pos = (guint64) offset + this->_header_u16 (
+			TYPELIB_HEADER_ENUM_BLOB_SIZE_OFFSET) +
+		      n_values * value_size;
+
+		break;
+	case GI_INFO_TYPE_OBJECT:
+		if (!this->_read_u16 (offset +
+		                      TYPELIB_OBJECT_N_INTERFACES_OFFSET,
+		                      n_interfaces) ||
+		    !this->_read_u16 (offset + TYPELIB_OBJECT_N_FIELDS_OFFSET,
+		                      n_fields) ||
+		    !this->_read_u16 (offset +
+		                      TYPELIB_OBJECT_N_FIELD_CALLBACKS_OFFSET,
+		                      n_field_callbacks) ||
+		    !this->_read_u16 (offset +
+		                      TYPELIB_OBJECT_N_PROPERTIES_OFFSET,
+		                      n_properties) ||
+		    !this->_read_u16 (offset + TYPELIB_OBJECT_N_METHODS_OFFSET,
+		                      count))
+			return false;
+
+		/* The interface indices are padded to a multiple of 4
+		 * bytes. */
+		pos = (guint64) offset + this->_header_u16 (
+			TYPELIB_HEADER_OBJECT_BLOB_SIZE_OFFSET) +
+		      (n_interfaces + n_interfaces % 2) * 2 +
+		      n_fields * field_size +
+		      n_field_callbacks * callback_size +
+		      n_properties * property_size;
+
+		break;
+	case GI_INFO_TYPE_INTERFACE:
+		if (!this->_read_u16 (offset +
+		                      TYPELIB_INTERFACE_N_PREREQUISITES_OFFSET,
+		                      n_interfaces) ||
+		    !this->_read_u16 (offset +
+		                      TYPELIB_INTERFACE_N_PROPERTIES_OFFSET,
+		                      n_properties) ||
+		    !this->_read_u16 (offset +
+		                      TYPELIB_INTERFACE_N_METHODS_OFFSET,
+		                      count))
+			return false;
+
+		/* As for objects, the prerequisite indices are padded. */
+		pos = (guint64) offset + this->_header_u16 (
+			TYPELIB_HEADER_INTERFACE_BLOB_SIZE_OFFSET) +
+		      (n_interfaces + n_interfaces % 2) * 2 +
+		      n_properties * property_size;
+
+		break;
+	case GI_INFO_TYPE_UNION:
+		if (!this->_read_u16 (offset + TYPELIB_UNION_N_FIELDS_OFFSET,
+		                      n_fields) ||
+		    !this->_read_u16 (offset +
+		                      TYPELIB_UNION_N_FUNCTIONS_OFFSET,
+		                      count))
+			return false;
+
+		pos = (guint64) offset + this->_header_u16 (
+			TYPELIB_HEADER_UNION_BLOB_SIZE_OFFSET) +
+		      n_fields * field_size;
+
+		break;
+	case GI_INFO_TYPE_INVALID:
+	case GI_INFO_TYPE_FUNCTION:
+	case GI_INFO_TYPE_CALLBACK:
+	case GI_INFO_TYPE_BOXED:
+	case GI_INFO_TYPE_FLAGS:
+	case GI_INFO_TYPE_CONSTANT:
+	case GI_INFO_TYPE_INVALID_0:
+	case GI_INFO_TYPE_VALUE:
+	case GI_INFO_TYPE_SIGNAL:
+	case GI_INFO_TYPE_VFUNC:
+	case GI_INFO_TYPE_PROPERTY:
+	case GI_INFO_TYPE_FIELD:
+	case GI_INFO_TYPE_ARG:
+	case GI_INFO_TYPE_TYPE:
+	case GI_INFO_TYPE_UNRESOLVED:
+	default:
+		/* Doesn’t have methods. */
+		first_method = 0;
+		n_methods = 0;
+		return true;
+	}
+
+	if (!this->_in_bounds (pos, count * function_size))
+		return false;
+
+	first_method = pos;
+	n_methods = count;
+
+	return true;
+}
+
+/* Offset of the @i-th method blob, given the offset of the first from
+ * get_methods(). */
+guint32
+TypelibReader::get_method_offset (guint32 first_method, unsigned int i) const
+{
+	return first_method +
+	       i * this->_header_u16 (TYPELIB_HEADER_FUNCTION_BLOB_SIZE_OFFSET);
+}
+
+static GITransfer
+_transfer (bool everything, bool container)
+{
+	if (everything)
+		return GI_TRANSFER_EVERYTHING;
+	else if (container)
+		return GI_TRANSFER_CONTAINER;
+	else
+		return GI_TRANSFER_NOTHING;
+}
+
+/* Read the function blob at @offset and its signature blob. @has_container
+ * should be set for methods, as opposed to directory entries. See
+ * g_function_info_get_flags() and g_callable_info_get_caller_owns(). */
+bool
+TypelibReader::get_function (guint32 offset, bool has_container,
+                             Function& function) const
+{
+	guint64 function_size =
+		this->_header_u16 (TYPELIB_HEADER_FUNCTION_BLOB_SIZE_OFFSET);
+	guint64 arg_size =
+		this->_header_u16 (TYPELIB_HEADER_ARG_BLOB_SIZE_OFFSET);
+	guint16 blob_type, flags, static_flags, signature_flags, n_args;
+	guint32 symbol, signature, return_type;
+
+	if (!this->_in_bounds (offset, function_size) ||
+	    !this->_read_u16 (offset + TYPELIB_BLOB_TYPE_OFFSET, blob_type) ||
+	    blob_type != GI_INFO_TYPE_FUNCTION ||
+	    !this->_read_u16 (offset + TYPELIB_BLOB_FLAGS_OFFSET, flags) ||
+	    !this->_read_u32 (offset + TYPELIB_FUNCTION_SYMBOL_OFFSET,
+	                      symbol) ||
+	    !this->_read_u32 (offset + TYPELIB_FUNCTION_SIGNATURE_OFFSET,
+	                      signature) ||
+	    !this->_read_u16 (offset + TYPELIB_FUNCTION_STATIC_FLAGS_OFFSET,
+	                      static_flags))
+		return false;
+
+	guint64 args_offset =
+		(guint64) signature + TYPELIB_SIGNATURE_ARGS_OFFSET;
+	const gchar *symbol_str = this->_get_string (symbol);
+
+	if (symbol_str == NULL ||
+	    !this->_read_u32 ((guint64) signature +
+	                      TYPELIB_SIGNATURE_RETURN_TYPE_OFFSET,
+	                      return_type) ||
+	    !this->_read_u16 ((guint64) signature +
+	                      TYPELIB_SIGNATURE_FLAGS_OFFSET,
+	                      signature_flags) ||
+	    !this->_read_u16 ((guint64) signature +
+	                      TYPELIB_SIGNATURE_N_ARGS_OFFSET,
+	                      n_args) ||
+	    !this->_in_bounds (args_offset, n_args * arg_size))
+		return false;
+
+	function.symbol = symbol_str;
+	function.is_constructor = (flags & TYPELIB_FUNCTION_CONSTRUCTOR) != 0;
+	function.is_method = (has_container && !function.is_constructor &&
+	                      !(static_flags & TYPELIB_FUNCTION_IS_STATIC));
+	function.throws = (flags & TYPELIB_FUNCTION_THROWS) != 0;
+	function.deprecated = (flags & TYPELIB_BLOB_DEPRECATED) != 0;
+	function.n_args = n_args;
+	function.return_transfer =
+		_transfer (signature_flags &
+		           TYPELIB_SIGNATURE_CALLER_OWNS_RETURN_VALUE,
+		           signature_flags &
+		           TYPELIB_SIGNATURE_CALLER_OWNS_RETURN_CONTAINER);
+	function.args_offset = args_offset;
+
+	return this->_get_type (return_type, function.return_type);
+}
+
+/* Read the @i-th argument of @function. See g_arg_info_get_direction() and
+ * g_arg_info_get_ownership_transfer(). */
+bool
+TypelibReader::get_arg (const Function& function, unsigned int i,
+                        Arg& arg) const
+{
+	guint64 offset =
+		(guint64) function.args_offset +
+		(guint64) i *
+		this->_header_u16 (TYPELIB_HEADER_ARG_BLOB_SIZE_OFFSET);
+	guint32 flags, type;
+
+	if (i >= function.n_args ||
+	    !this->_read_u32 (offset + TYPELIB_ARG_FLAGS_OFFSET, flags) ||
+	    !this->_read_u32 (offset + TYPELIB_ARG_TYPE_OFFSET, type))
+		return false;
+
+	if ((flags & TYPELIB_ARG_IN) && (flags & TYPELIB_ARG_OUT))
+		arg.direction = GI_DIRECTION_INOUT;
+	else if (flags & TYPELIB_ARG_OUT)
+		arg.direction = GI_DIRECTION_OUT;
+	else
+		arg.direction = GI_DIRECTION_IN;
+
+	arg.transfer =
+		_transfer (flags & TYPELIB_ARG_TRANSFER_OWNERSHIP,
+		           flags & TYPELIB_ARG_TRANSFER_CONTAINER_OWNERSHIP);
+	arg.may_be_null = (flags & TYPELIB_ARG_NULLABLE) != 0;
+	arg.is_optional = (flags & TYPELIB_ARG_OPTIONAL) != 0;
+
+	return this->_get_type (type, arg.type);
+}
+
+/* Decode a SimpleTypeBlob, following it to its complex type blob if it isn’t
+ * a basic type. See g_type_info_is_pointer(), g_type_info_get_tag() and
+ * g_type_info_get_array_type(). */
+bool
+TypelibReader::_get_type (guint32 simple_type, Type& type) const
+{
+	type.array_type = GI_ARRAY_TYPE_C;
+
+	if ((simple_type & TYPELIB_SIMPLE_TYPE_RESERVED_MASK) == 0) {
+		type.is_pointer =
+			(simple_type >> TYPELIB_SIMPLE_TYPE_POINTER_SHIFT) & 1;
+		type.tag = (GITypeTag) (simple_type >>
+		                        TYPELIB_SIMPLE_TYPE_TAG_SHIFT);
+
+		return true;
+	}
+
+	guint8 flags;
+
+	if (!this->_read_u8 (simple_type, flags))
+		return false;
+
+	type.is_pointer = (flags & TYPELIB_TYPE_POINTER) != 0;
+	type.tag = (GITypeTag) (flags >> TYPELIB_TYPE_TAG_SHIFT);
+
+	if (type.tag == GI_TYPE_TAG_ARRAY) {
+		guint16 array_flags;
+
+		if (!this->_read_u16 (simple_type, array_flags))
+			return false;
+
+		type.array_type = (GIArrayType)
+			((array_flags >> TYPELIB_ARRAY_TYPE_SHIFT) &
+			 TYPELIB_ARRAY_TYPE_MASK);
+	}
+
+	return true;
+}
@@ -0,0 +1,117 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Tartan
+ * Copyright © 2026 Philip Withnall
+ *
+ * Tartan is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tartan is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tartan.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *     Philip Withnall <philip@tecnocode.co.uk>
+ */
+
+#ifndef TARTAN_TYPELIB_READER_H
+#define TARTAN_TYPELIB_READER_H
+
+#include <string>
+
+#include <girepository.h>
+
+#include <llvm/ADT/StringRef.h>
+
+/* Read-only view of a mapped typelib, which reads the directory, function, arg
+ * and type blobs and the string table in place, rather than allocating a
+ * #GIBaseInfo for each of them as the #GIRepository does. Every read is bounds
+ * checked against the mapping, and fails (rather than crashing) if the typelib
+ * is malformed. Strings point into the mapping, so are valid for the lifetime
+ * of the #TypelibReader.
+ *
+ * Once opened, a #TypelibReader is immutable, so it can be read from several
+ * threads at once.
+ *
+ * The blob layouts are those of gitypelib-internal.h in gobject-introspection
+ * (format version 4). Only little-endian typelibs are supported; open() fails
+ * on big-endian hosts, and the caller should fall back to the #GIRepository. */
+class TypelibReader {
+public:
+	/* See #GITypeInfo. @array_type is only meaningful if @tag is
+	 * %GI_TYPE_TAG_ARRAY. */
+	struct Type {
+		bool is_pointer;
+		GITypeTag tag;
+		GIArrayType array_type;
+	};
+
+	/* See #GIArgInfo. */
+	struct Arg {
+		GIDirection direction;
+		GITransfer transfer;
+		bool may_be_null;
+		bool is_optional;
+		Type type;
+	};
+
+	/* See #GIFunctionInfo. */
+	struct Function {
+		llvm::StringRef symbol;
+		/* Has a container and %GI_FUNCTION_IS_METHOD is set. */
+		bool is_method;
+		bool is_constructor;
+		bool throws;
+		bool deprecated;
+		unsigned int n_args;
+		GITransfer return_transfer;
+		Type return_type;
+
+		guint32 args_offset;  /* private */
+	};
+
+	~TypelibReader ();
+
+	static TypelibReader* open (const std::string& typelib_path,
+	                            const std::string& gi_namespace,
+	                            const std::string& gi_version);
+
+	const gchar* get_c_prefix () const;
+
+	unsigned int get_n_entries () const;
+	bool get_entry (unsigned int i, GIInfoType& type,
+	                guint32& offset) const;
+	bool get_methods (GIInfoType type, guint32 offset,
+	                  guint32& first_method,
+	                  unsigned int& n_methods) const;
+	guint32 get_method_offset (guint32 first_method,
+	                           unsigned int i) const;
+	bool get_function (guint32 offset, bool has_container,
+	                   Function& function) const;
+	bool get_arg (const Function& function, unsigned int i,
+	              Arg& arg) const;
+
+private:
+	TypelibReader (GMappedFile *mapped_file);
+
+	bool _in_bounds (guint64 offset, guint64 size) const;
+	bool _read_u8 (guint64 offset, guint8& value) const;
+	bool _read_u16 (guint64 offset, guint16& value) const;
+	bool _read_u32 (guint64 offset, guint32& value) const;
+	guint16 _header_u16 (gsize field_offset) const;
+	guint32 _header_u32 (gsize field_offset) const;
+	const gchar* _get_string (guint32 offset) const;
+	bool _get_type (guint32 simple_type, Type& type) const;
+
+	GMappedFile *_mapped_file;  /* owned */
+	const gchar *_data;  /* unowned; points into @_mapped_file */
+	gsize _length;
+};
+
+#endif /* !TARTAN_TYPELIB_READER_H */
@@ -0,0 +1,90 @@
+/* Template: assertion */
+
+/*
+ * null passed to a callee that requires a non-null argument
+ *         assertion_func (NULL, 1, obj);
+ *                         ~~~~        ^
+ * null passed to a callee that requires a non-null argument
+ *         assertion_func (NULL, 3, NULL);
+ *                         ~~~~         ^
+ */
+{
+	// Negated equality.
+	g_return_if_fail (!(some_str == NULL));
+}
+
+/*
+ * null passed to a callee that requires a non-null argument
+ *         assertion_func ("str", 2, NULL);
+ *                                   ~~~~^
+ * null passed to a callee that requires a non-null argument
+ *         assertion_func (NULL, 3, NULL);
+ *                                  ~~~~^
+ */
+{
+	// Double negation.
+	g_return_if_fail (!!some_obj);
+}
+
+/*
+ * null passed to a callee that requires a non-null argument
+ *         assertion_func (NULL, 1, obj);
+ *                         ~~~~        ^
+ * null passed to a callee that requires a non-null argument
+ *         assertion_func (NULL, 3, NULL);
+ *                         ~~~~         ^
+ */
+{
+	// TRUE is the identity of conjunction.
+	g_return_if_fail (1 && some_str != NULL);
+}
+
+/*
+ * null passed to a callee that requires a non-null argument
+ *         assertion_func ("str", 2, NULL);
+ *                                   ~~~~^
+ * null passed to a callee that requires a non-null argument
+ *         assertion_func (NULL, 3, NULL);
+ *                                  ~~~~^
+ */
+{
+	// FALSE is the identity of disjunction.
+	g_return_if_fail (0 || some_obj != NULL);
+}
+
+/*
+ * null passed to a callee that requires a non-null argument
+ *         assertion_func (NULL, 1, obj);
+ *                         ~~~~        ^
+ * null passed to a callee that requires a non-null argument
+ *         assertion_func (NULL, 3, NULL);
+ *                         ~~~~         ^
+ * null passed to a callee that requires a non-null argument
+ *         assertion_func ("str", 2, NULL);
+ *                                   ~~~~^
+ * null passed to a callee that requires a non-null argument
+ *         assertion_func (NULL, 3, NULL);
+ *                                  ~~~~^
+ */
+{
+	// Nested conjunctions, with a condition which isn’t a non-NULL check.
+	g_return_if_fail (some_int > 0 &&
+	                  (some_str != NULL && some_obj != NULL));
+}
+
+/*
+ * No error
+ */
+{
+	// A NULL check rather than a non-NULL check.
+	g_return_if_fail (!some_str);
+}
+
+/*
+ * No error
+ */
+{
+	// FALSE absorbs the rest of a conjunction, so the assertion always
+	// fails and says nothing about the parameters.
+	g_return_if_fail (0 && some_str != NULL);
+}
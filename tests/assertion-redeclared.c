@@ -0,0 +1,39 @@
+/* Template: assertion-redeclared */
+
+/*
+ * No error
+ */
+{
+	// Nothing to see here, so all parameters are nullable.
+}
+
+/*
+ * null passed to a callee that requires a non-null argument
+ *         assertion_func (NULL, 1, obj);
+ *                         ~~~~        ^
+ * null passed to a callee that requires a non-null argument
+ *         assertion_func (NULL, 3, NULL);
+ *                         ~~~~         ^
+ */
+{
+	g_return_if_fail (some_str != NULL);
+}
+
+/*
+ * null passed to a callee that requires a non-null argument
+ *         assertion_func (NULL, 1, obj);
+ *                         ~~~~        ^
+ * null passed to a callee that requires a non-null argument
+ *         assertion_func ("str", 2, NULL);
+ *                                   ~~~~^
+ * null passed to a callee that requires a non-null argument
+ *         assertion_func (NULL, 3, NULL);
+ *                                  ~~~~^
+ * null passed to a callee that requires a non-null argument
+ *         assertion_func (NULL, 3, NULL);
+ *                         ~~~~         ^
+ */
+{
+	g_return_if_fail (some_str != NULL);
+	g_return_if_fail (some_obj != NULL);
+}
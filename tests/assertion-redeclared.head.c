@@ -0,0 +1,13 @@
+#include <stdio.h>
+
+#include <glib.h>
+#include <glib-object.h>
+
+/* Declared before its definition, so the first lookup of its preconditions is
+ * for a declaration without a body. */
+static void assertion_func (const gchar *some_str, guint some_int,
+                            GObject *some_obj);
+
+static void
+assertion_func (const gchar *some_str, guint some_int, GObject *some_obj)
+{
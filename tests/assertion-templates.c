@@ -0,0 +1,78 @@
+/* Template: assertion */
+
+/*
+ * No error
+ */
+{
+	// Two macros with the same shape, only one of which is an assertion.
+	// The template cached for the first must not be reused for the second.
+	void test_log_failure (const gchar *domain, const gchar *func,
+	                       const gchar *expr);
+
+#define TEST_REQUIRE(expr) \
+	G_STMT_START { \
+		if (expr) { } else { \
+			g_return_if_fail_warning (G_LOG_DOMAIN, G_STRFUNC, \
+			                          #expr); \
+			return; \
+		} \
+	} G_STMT_END
+#define TEST_CHECK(expr) \
+	G_STMT_START { \
+		if (expr) { } else { \
+			test_log_failure (G_LOG_DOMAIN, G_STRFUNC, #expr); \
+			return; \
+		} \
+	} G_STMT_END
+
+	TEST_REQUIRE (some_int > 0);
+	TEST_CHECK (some_str != NULL);
+	TEST_CHECK (some_obj != NULL);
+}
+
+/*
+ * null passed to a callee that requires a non-null argument
+ *         assertion_func (NULL, 1, obj);
+ *                         ~~~~        ^
+ * null passed to a callee that requires a non-null argument
+ *         assertion_func (NULL, 3, NULL);
+ *                         ~~~~         ^
+ */
+{
+	// The template for a macro is reused for its later expansions.
+#define TEST_REQUIRE(expr) \
+	G_STMT_START { \
+		if (expr) { } else { \
+			g_return_if_fail_warning (G_LOG_DOMAIN, G_STRFUNC, \
+			                          #expr); \
+			return; \
+		} \
+	} G_STMT_END
+
+	TEST_REQUIRE (some_int > 0);
+	TEST_REQUIRE (some_str != NULL);
+}
+
+/*
+ * null passed to a callee that requires a non-null argument
+ *         assertion_func ("str", 2, NULL);
+ *                                   ~~~~^
+ * null passed to a callee that requires a non-null argument
+ *         assertion_func (NULL, 3, NULL);
+ *                                  ~~~~^
+ */
+{
+	// A macro which expands to the same inner macros as g_return_if_fail()
+	// (G_STMT_START and G_LIKELY) but checks a different condition.
+#define TEST_REQUIRE_NONNULL(ptr) \
+	G_STMT_START { \
+		if (G_LIKELY ((ptr) != NULL)) { } else { \
+			g_return_if_fail_warning (G_LOG_DOMAIN, G_STRFUNC, \
+			                          #ptr " != NULL"); \
+			return; \
+		} \
+	} G_STMT_END
+
+	g_return_if_fail (some_int > 0);
+	TEST_REQUIRE_NONNULL (some_obj);
+}
@@ -0,0 +1,31 @@
+/* Template: generic */
+/* Options: --check-scope main-file */
+
+/*
+ * No error
+ */
+{
+	// GLib’s inline functions in its headers aren’t traversed.
+	GVariant *floating_variant = g_variant_new ("s", "some string");
+	g_variant_unref (floating_variant);
+}
+
+/*
+ * Expected a GVariant variadic argument of type 'char *' but saw one of type 'int'.
+ */
+{
+	// Functions in the main file are still checked.
+	GVariant *floating_variant = g_variant_new ("s", 5);
+}
+
+/*
+ * Expected a GVariant variadic argument of type 'char *' but saw one of type 'int'.
+ */
+{
+	// Including those inside nested blocks.
+	GVariant *floating_variant;
+
+	{
+		floating_variant = g_variant_new ("s", 5);
+	}
+}
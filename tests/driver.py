@@ -19,6 +19,8 @@
 
 # Take an input file which contains a header of the form:
 # /* Template: [template name] */
+# optionally followed by a line of the form:
+# /* Options: [Tartan plugin options] */
 # followed by a blank line, then one or more sections of the form:
 # /*
 # [Error message|‘No error’]
@@ -36,12 +38,18 @@
 # named template. It then compiles the code using Clang with Tartan, and checks
 # the compiler output against the expected error message. If the expected error
 # message is ‘No error’ it asserts there’s no error.
+#
+# The options, if given, are passed to Tartan for every section, after
+# ‘--quiet’. ‘{tmpdir}’ in them is replaced by the path of a temporary
+# directory which is shared by all the sections in the file, in order. The
+# statistics printed with ‘--stats’ are allowed in ‘No error’ sections.
 
 import argparse
 import itertools
 import os
 import re
 import shlex
+import shutil
 import subprocess
 import sys
 import tempfile
@@ -126,10 +134,15 @@ if args.verbose:
     print('# using template {}'.format(template))
 
 # Split the input file up into sections, delimiting on ‘/*’ on a line by itself
+tartan_options = ''
 for line in args.infile:
     line = line.rstrip(os.linesep)
 
-    if line == '/*':
+    options_match = re.match(r'\/\*\s*Options:(.*)\*\/', line)
+
+    if current_test is None and options_match:
+        tartan_options = options_match.group(1).strip()
+    elif line == '/*':
         if current_test is not None:
             current_test.finish_source()
             tests.append(current_test)
@@ -162,9 +175,14 @@ tartan_test_options = os.environ.get('TARTAN_TEST_OPTIONS', None)
 if tartan_test_options is not None:
     extra_options.append(tartan_test_options)
 
+tmpdir = tempfile.mkdtemp()
+tartan_options = tartan_options.replace('{tmpdir}', tmpdir)
+if args.verbose and tartan_options:
+    print('# using options {}'.format(tartan_options))
+
 test_env = {
     'TARTAN_PLUGIN': tartan_plugin,
-    'TARTAN_OPTIONS': '--quiet'
+    'TARTAN_OPTIONS': ' '.join(['--quiet', tartan_options]).strip()
 }
 env = dict(os.environ, **test_env)
 if args.target_cc:
@@ -212,8 +230,11 @@ for ix, test in enumerate(tests):
             print('# Actual:')
             log_tap_multiline_text(output_lines)
     else:
-        # Expecting no error.
-        if result.stderr:
+        # Expecting no error. The statistics printed with ‘--stats’ aren’t
+        # errors.
+        error_lines = [line for line in output_lines
+                       if not line.startswith('{"tartan_stats": ')]
+        if error_lines:
             failed = True
             print('# Error: compiler error when none was expected.')
             log_tap_multiline_text(output_lines)
@@ -226,3 +247,5 @@ for ix, test in enumerate(tests):
         os.remove(path)
 
     print('{}ok {} {}'.format('not ' if failed else '', ix + 1, test.name))
+
+shutil.rmtree(tmpdir, ignore_errors=True)
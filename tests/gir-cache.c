@@ -0,0 +1,33 @@
+/* Template: generic */
+/* Options: --gir-cache-dir {tmpdir} --stats */
+
+/*
+ * null passed to a callee that requires a non-null argument
+ *         guint64 size = g_ascii_strtoull (NULL, NULL, 10);
+ *                                          ~~~~          ^
+ * "gir_cache_maps": 0,
+ */
+{
+	// Written to the GIR cache.
+	guint64 size = g_ascii_strtoull (NULL, NULL, 10);
+}
+
+/*
+ * null passed to a callee that requires a non-null argument
+ *         guint64 size = g_ascii_strtoull (NULL, NULL, 10);
+ *                                          ~~~~          ^
+ * "gir_cache_writes": 0,
+ */
+{
+	// Read from the GIR cache written by the previous section, so none of
+	// it has to be written again.
+	guint64 size = g_ascii_strtoull (NULL, NULL, 10);
+}
+
+/*
+ * No error
+ */
+{
+	const gchar *endptr = NULL;
+	guint64 size = g_ascii_strtoull ("some-constant-string", (gchar **) &endptr, 10);
+}
@@ -0,0 +1,82 @@
+/* Template: gvariant */
+
+/*
+ * No error
+ */
+{
+	floating_variant = g_variant_new ("((s)(i(u)))", "a", (gint32) 1,
+	                                  (guint32) 2);
+}
+
+/*
+ * Expected a GVariant variadic argument of type 'guint32' (aka 'unsigned int') but saw one of type 'char *'.
+ */
+{
+	// Type mismatch in the innermost tuple
+	floating_variant = g_variant_new ("((s)(i(u)))", "a", (gint32) 1, "b");
+}
+
+/*
+ * No error
+ */
+{
+	GVariant *some_variant = g_variant_new_boolean (FALSE);
+	floating_variant = g_variant_new ("(s{sv}i)", "a", "key", some_variant,
+	                                  (gint32) 5);
+}
+
+/*
+ * Expected a GVariant basic type string but saw ‘v’.
+ */
+{
+	// Non-basic type as the key of a nested dict entry
+	GVariant *some_variant = g_variant_new_boolean (FALSE);
+	floating_variant = g_variant_new ("({vs})", some_variant, "value");
+}
+
+/*
+ * No error
+ */
+{
+	GVariant *some_variant = g_variant_new_string ("asd");
+	floating_variant = g_variant_new ("(&s@sms)", "a", some_variant, NULL);
+}
+
+/*
+ * No error
+ */
+{
+	floating_variant = g_variant_new ("(m(ss)s)", NULL, NULL, "a");
+}
+
+/*
+ * Invalid GVariant format string: tuple did not end with ‘)’.
+ */
+{
+	// Unterminated nested tuple
+	floating_variant = g_variant_new ("((si)", "a", (gint32) 1);
+}
+
+/*
+ * Invalid GVariant format string: dict did not end with ‘}’.
+ */
+{
+	// Unterminated dict entry inside a tuple
+	GVariant *some_variant = g_variant_new_boolean (FALSE);
+	floating_variant = g_variant_new ("(s{sv)", "a", "key", some_variant);
+}
+
+/*
+ * Invalid GVariant basic format string: convenience operator ‘^’ was not followed by a recognized convenience conversion.
+ */
+{
+	floating_variant = g_variant_new ("^ax", NULL);
+}
+
+/*
+ * Unexpected GVariant format strings ‘i’ with unpaired arguments.
+ */
+{
+	// Two format strings without an enclosing tuple
+	floating_variant = g_variant_new ("si", "a", (gint32) 1);
+}
@@ -0,0 +1,27 @@
+/* Template: nonnull-merging */
+
+/*
+ * null passed to a callee that requires a non-null argument
+ *         tartan_strrstr (NULL, "needle");
+ * null passed to a callee that requires a non-null argument
+ *         tartan_strrstr ("haystack", NULL);
+ */
+{
+	// The assertion only covers the parameter which the source attribute
+	// doesn’t, so the source attribute must be kept alongside the one
+	// Tartan adds.
+	g_return_val_if_fail (needle != NULL, NULL);
+}
+
+/*
+ * null passed to a callee that requires a non-null argument
+ *         tartan_strrstr (NULL, "needle");
+ * null passed to a callee that requires a non-null argument
+ *         tartan_strrstr ("haystack", NULL);
+ */
+{
+	// The assertions cover the parameter which the source attribute does
+	// too.
+	g_return_val_if_fail (haystack != NULL, NULL);
+	g_return_val_if_fail (needle != NULL, NULL);
+}
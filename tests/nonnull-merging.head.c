@@ -0,0 +1,9 @@
+#include <stdio.h>
+
+#include <glib.h>
+
+/* A function without GIR annotations, with a nonnull attribute written in the
+ * source for only its first parameter. */
+__attribute__ ((nonnull (1))) gchar *
+tartan_strrstr (const gchar *haystack, const gchar *needle)
+{
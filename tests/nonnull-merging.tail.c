@@ -0,0 +1,11 @@
+	return NULL;
+}
+
+int
+main (void)
+{
+	/* Various NULL and non-NULL calls to the function. */
+	tartan_strrstr ("haystack", "needle");
+	tartan_strrstr (NULL, "needle");
+	tartan_strrstr ("haystack", NULL);
+}
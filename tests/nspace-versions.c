@@ -0,0 +1,52 @@
+/* Template: nspace-versions */
+/* Options: --typelib-path tests/typelibs/v2 --typelib-path tests/typelibs/v1 */
+
+/*
+ * null passed to a callee that requires a non-null argument
+ *         tartan_greet (NULL, "hello");
+ */
+{
+	// Each --typelib-path is put at the start of the search path, so
+	// version 1.0 comes first and is used.
+	tartan_greet (NULL, "hello");
+}
+
+/*
+ * No error
+ */
+{
+	// Version 2.0 would require a non-NULL greeting.
+	tartan_greet ("world", NULL);
+}
+
+/*
+ * null passed to a callee that requires a non-null argument
+ *         tartan_greet (NULL, "hello");
+ */
+{
+	// The same version is used every time, whichever typelib is indexed
+	// first.
+	tartan_greet (NULL, "hello");
+}
+
+/*
+ * No error
+ */
+{
+	tartan_greet ("world", NULL);
+}
+
+/*
+ * null passed to a callee that requires a non-null argument
+ *         tartan_greet (NULL, "hello");
+ */
+{
+	tartan_greet (NULL, "hello");
+}
+
+/*
+ * No error
+ */
+{
+	tartan_greet ("world", NULL);
+}
@@ -0,0 +1,11 @@
+#include <stdio.h>
+
+#include <glib.h>
+
+/* Described by both versions of the Tartan namespace in typelibs/, which
+ * disagree about which parameter may be NULL. */
+void tartan_greet (const gchar *name, const gchar *greeting);
+
+int
+main (void)
+{
@@ -0,0 +1,23 @@
+/* Template: generic */
+/* Options: --stats */
+
+/*
+ * "tartan_stats": 1
+ * "gir_cache_maps": 0, "gir_cache_writes": 0, "typelib_dir_cache_hits": 0,
+ * "ast-dispatcher": {"count": 1,
+ */
+{
+	// Statistics are printed even when there are no diagnostics. Without
+	// --gir-cache-dir, the GIR cache isn’t read or written.
+}
+
+/*
+ * Expected a GVariant variadic argument of type 'char *' but saw one of type 'int'.
+ * "tartan_stats": 1
+ * "ast-dispatcher": {"count": 1,
+ */
+{
+	// The checkers’ diagnostics are unaffected, and the shared traversal
+	// is only timed once per translation unit.
+	GVariant *floating_variant = g_variant_new ("s", 5);
+}